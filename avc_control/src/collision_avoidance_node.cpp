@@ -6,6 +6,7 @@
 #include <avc_msgs/Control.h>
 #include <avc_msgs/ESC.h>
 #include <avc_msgs/SteeringServo.h>
+#include <avc_msgs/TimeToCollision.h>
 #include <sensor_msgs/Range.h>
 #include <signal.h>
 
@@ -17,7 +18,14 @@ float range_left = 9999; //left sensor range to nearest object [m]
 float range_right = 9999; //right sensor range to nearest object [m]
 float steering_angle = 0; //requested steering angle [deg]
 float steering_reset_timer = 0; //duration steering angle is held after obstacle is cleared from front sensor
-float throttle_percent = 0; //requested throttle position [%]
+float target_speed = 0; //requested speed in velocity mode [m/s]
+float throttle_percent = 0; //requested throttle position (throttle limit in velocity mode) [%]
+bool velocity_mode = false; //requested ESC velocity mode
+float closing_speed_front = 0; //front sensor closing speed to nearest object [m/s]
+float ttc_confidence_front = 0; //front sensor time to collision confidence [0 to 1]
+ros::Time ttc_front_time; //time of last front sensor time to collision message
+ros::Time esc_time; //time of last requested throttle message
+ros::Time steering_servo_time; //time of last requested steering message
 
 
 //callback function called to process SIGINT command
@@ -44,6 +52,9 @@ void escCallback(const avc_msgs::ESC::ConstPtr& msg)
 
   //set local value to received value
   throttle_percent = msg->throttle_percent;
+  velocity_mode = msg->velocity_mode;
+  target_speed = msg->target_speed;
+  esc_time = msg->header.stamp;
 
 }
 
@@ -83,11 +94,23 @@ void rangeRightCallback(const sensor_msgs::Range::ConstPtr& msg)
 
 }
 
+//callback function called to process messages on front time to collision topic
+void ttcFrontCallback(const avc_msgs::TimeToCollision::ConstPtr& msg)
+{
+
+  //set local values to received values
+  closing_speed_front = msg->closing_speed;
+  ttc_confidence_front = msg->confidence;
+  ttc_front_time = msg->header.stamp;
+
+}
+
 void steeringServoCallback(const avc_msgs::SteeringServo::ConstPtr& msg)
 {
 
   //set local value to received value
   steering_angle = msg->steering_angle;
+  steering_servo_time = msg->header.stamp;
 
 }
 
@@ -169,6 +192,46 @@ int main(int argc, char **argv)
     ROS_BREAK();
   }
 
+  //retrieve minimum speed-scaled threshold distance from parameter server [m]
+  float min_threshold_distance;
+  if (!node_private.getParam("/control/collision_avoidance_node/min_threshold_distance", min_threshold_distance))
+  {
+    ROS_ERROR("[collision_avoidance_node] minimum threshold distance not defined in config file: avc_control/config/control.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve maximum speed-scaled threshold distance from parameter server [m]
+  float max_threshold_distance;
+  if (!node_private.getParam("/control/collision_avoidance_node/max_threshold_distance", max_threshold_distance))
+  {
+    ROS_ERROR("[collision_avoidance_node] maximum threshold distance not defined in config file: avc_control/config/control.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve time to collision at which the algorithm engages from parameter server [s]
+  float ttc_threshold;
+  if (!node_private.getParam("/control/collision_avoidance_node/ttc_threshold", ttc_threshold))
+  {
+    ROS_ERROR("[collision_avoidance_node] time to collision threshold not defined in config file: avc_control/config/control.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve minimum time to collision confidence required to use speed-scaled threshold from parameter server
+  float ttc_min_confidence;
+  if (!node_private.getParam("/control/collision_avoidance_node/ttc_min_confidence", ttc_min_confidence))
+  {
+    ROS_ERROR("[collision_avoidance_node] time to collision minimum confidence not defined in config file: avc_control/config/control.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve time after which a time to collision message is ignored from parameter server [s]
+  float ttc_timeout;
+  if (!node_private.getParam("/control/collision_avoidance_node/ttc_timeout", ttc_timeout))
+  {
+    ROS_ERROR("[collision_avoidance_node] time to collision timeout not defined in config file: avc_control/config/control.yaml");
+    ROS_BREAK();
+  }
+
   //create ESC message object and set default parameters
   avc_msgs::ESC esc_msg;
   esc_msg.header.frame_id = "0";
@@ -198,6 +261,9 @@ int main(int argc, char **argv)
   //create subscriber to subscribe to right proximity message topic with queue size set to 1
   ros::Subscriber range_right_sub = node_public.subscribe("/sensor/proximity/right", 1, rangeRightCallback);
 
+  //create subscriber to subscribe to front time to collision message topic with queue size set to 1
+  ros::Subscriber ttc_front_sub = node_public.subscribe("/sensor/ttc/front", 1, ttcFrontCallback);
+
   //create subscriber to subscribe to steering servo message topic with queue size set to 1
   ros::Subscriber steering_servo_sub = node_public.subscribe("/control/steering_servo_raw", 1, steeringServoCallback);
 
@@ -213,12 +279,30 @@ int main(int argc, char **argv)
   while (ros::ok())
   {
 
+    //determine distance at which the algorithm engages
+    //with a confident time to collision estimate, engage when the obstacle is reached within the time to collision threshold,
+    //so the distance shrinks when closing slowly and grows when closing quickly
+    float engage_distance = threshold_distance;
+    if (!ttc_front_time.isZero() && ((ros::Time::now() - ttc_front_time).toSec() < ttc_timeout) && (ttc_confidence_front >= ttc_min_confidence))
+    {
+
+      //scale threshold distance by closing speed
+      engage_distance = closing_speed_front * ttc_threshold;
+
+      //validate engage distance
+      if (engage_distance < min_threshold_distance)
+        engage_distance = min_threshold_distance;
+      else if (engage_distance > max_threshold_distance)
+        engage_distance = max_threshold_distance;
+
+    }
+
     //engage collision avoidance algorithm if enabled in current driving mode and moving forward
     if ((autonomous_control && collision_avoidance_autonomous) || (!autonomous_control && collision_avoidance_manual) && (throttle_percent > 0))
     {
 
-      //engage collision avoidance algorithm if there's an obstacle within the threshold distance
-      if (range_front < threshold_distance)
+      //engage collision avoidance algorithm if there's an obstacle within the engage distance
+      if (range_front < engage_distance)
       {
 
         //----------------------------------------------------------------------
@@ -226,7 +310,7 @@ int main(int argc, char **argv)
         //----------------------------------------------------------------------
 
         //calculate steering correction value
-        float steering_correction = k_collision_steer * (1 - (range_front / threshold_distance));
+        float steering_correction = k_collision_steer * (1 - (range_front / engage_distance));
 
         //handle case: steering left is safer
         if (range_left < range_right)
@@ -257,25 +341,28 @@ int main(int argc, char **argv)
         //----------------------------------------------------------------------
 
         //calculate corrected throttle value
-        float throttle_correction = throttle_percent * k_collision_brake * (1 - (range_front / threshold_distance));
+        float throttle_correction = throttle_percent * k_collision_brake * (1 - (range_front / engage_distance));
 
         //verify calculated value is valid
         if (throttle_correction < 0)
           throttle_correction = 0;
 
-        //calculate new throttle value
+        //calculate new throttle value, and reduce target speed in velocity mode by the same fraction
+        if (throttle_percent > 0)
+          target_speed *= 1 - (throttle_correction / throttle_percent);
         throttle_percent -= throttle_correction;
 
         //if going forward and throttle percent is below set threshold then set both throttle and steering to zero
         if (throttle_percent < minimum_throttle)
         {
           steering_angle = 0;
+          target_speed = 0;
           throttle_percent = 0;
         }
 
       }
       //if obstacle was seen but isn't anymore then trigger timer to hold steering angle until time elapses
-      else if ((range_front > threshold_distance) && (last_range < threshold_distance))
+      else if ((range_front > engage_distance) && (last_range < engage_distance))
       {
 
         //set hold requested flag to true
@@ -295,15 +382,18 @@ int main(int argc, char **argv)
       //update steering and throttle message values
       steering_servo_msg.steering_angle = steering_angle;
       esc_msg.throttle_percent = throttle_percent;
+      esc_msg.velocity_mode = velocity_mode;
+      esc_msg.target_speed = target_speed;
 
     }
 
     //set steering servo message parameters and publish
-    steering_servo_msg.header.stamp = ros::Time::now();
+    //requested message times are passed on, so the actuators see when commands stop arriving from upstream
+    steering_servo_msg.header.stamp = steering_servo_time;
     steering_servo_pub.publish(steering_servo_msg);
 
     //set ESC message parameters and publish
-    esc_msg.header.stamp = ros::Time::now();
+    esc_msg.header.stamp = esc_time;
     esc_pub.publish(esc_msg);
 
     //process callback functions
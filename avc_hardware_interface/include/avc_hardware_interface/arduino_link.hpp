@@ -0,0 +1,112 @@
+#ifndef ARDUINO_LINK_HPP
+#define ARDUINO_LINK_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+
+//Arduino frame format (all fields little-endian):
+//  start (0xA5) | type | sequence | payload length | payload | CRC-8 (polynomial 0x07, over type through payload)
+//the Arduino only applies a frame with a valid CRC and a sequence number newer than the last one applied, and returns to neutral
+//when no valid frame arrives within its failsafe time, so corrupted, repeated, or reordered frames can't move the car
+//every valid frame received is answered with a telemetry frame (on I2C, by the read following it), but only command frames
+//release the failsafe
+const uint8_t ARDUINO_FRAME_START = 0xA5;
+const size_t ARDUINO_HEADER_SIZE = 4;
+const size_t ARDUINO_MAX_PAYLOAD = 16;
+const size_t ARDUINO_MAX_FRAME = ARDUINO_HEADER_SIZE + ARDUINO_MAX_PAYLOAD + 1;
+
+//frame types
+enum ArduinoFrameType
+{
+  ARDUINO_COMMAND = 0x01, //int16 throttle [% / 100], int16 steering angle [deg / 100]
+  ARDUINO_PULSEWIDTHS = 0x02, //uint16 ESC pulsewidth [us], uint16 steering servo pulsewidth [us]
+  ARDUINO_TELEMETRY_REQUEST = 0x03, //no payload, only asks for telemetry
+  ARDUINO_TELEMETRY = 0x81 //uint16 battery voltage [mV], uint16 applied ESC and steering servo pulsewidths [us], uint16 loop overruns,
+                           //uint8 sequence number of last command applied
+};
+
+//telemetry payload and frame size
+const size_t ARDUINO_TELEMETRY_PAYLOAD = 9;
+const size_t ARDUINO_TELEMETRY_FRAME = ARDUINO_HEADER_SIZE + ARDUINO_TELEMETRY_PAYLOAD + 1;
+
+//decoded frame
+struct ArduinoFrame
+{
+  uint8_t type;
+  uint8_t sequence;
+  uint8_t length;
+  uint8_t payload[ARDUINO_MAX_PAYLOAD];
+};
+
+//CRC-8 of data (polynomial 0x07, initial value 0)
+uint8_t crc8(const uint8_t *data, size_t size);
+
+//encode frame into buffer of at least ARDUINO_MAX_FRAME bytes, returns frame size (0 if payload is too long)
+size_t encodeArduinoFrame(uint8_t type, uint8_t sequence, const uint8_t *payload, size_t length, uint8_t *buffer);
+
+//store 16-bit values in payload
+void putInt16(uint8_t *payload, int16_t value);
+void putUint16(uint8_t *payload, uint16_t value);
+
+//read 16-bit values from payload
+int16_t getInt16(const uint8_t *payload);
+uint16_t getUint16(const uint8_t *payload);
+
+//returns true if sequence number is newer than last (within half the sequence range, so it survives wrapping)
+bool isNewerSequence(uint8_t sequence, uint8_t last);
+
+//byte stream frame decoder
+//resynchronizes on the next start byte after a corrupted or truncated frame
+class ArduinoFrameDecoder
+{
+  public:
+
+    //constructors and destructors
+    ArduinoFrameDecoder();
+
+    //get functions
+    unsigned int getCrcErrors() const;
+
+    //other functions
+    bool decode(uint8_t byte, ArduinoFrame& frame); //returns true and sets frame once byte completes a frame with a valid CRC
+    void reset();
+
+  private:
+    bool resync(size_t count, ArduinoFrame& frame); //re-feed bytes after start byte of rejected frame of count bytes
+
+    size_t _count; //bytes of current frame received
+    uint8_t _buffer[ARDUINO_MAX_FRAME];
+    unsigned int _crc_errors;
+
+};
+
+//link to Arduino over I2C (Linux i2c-dev) or a serial device
+//terminals (serial ports and pseudo terminals standing in for the Arduino) are set to raw mode, all other devices are treated as I2C buses
+class ArduinoLink
+{
+  public:
+
+    //constructors and destructors
+    ArduinoLink();
+    ~ArduinoLink();
+
+    //get functions
+    int getFileDescriptor() const;
+    bool isOpen() const;
+
+    //other functions
+    void close();
+    bool open(const std::string& device_path, int address); //address is the I2C slave address, ignored for terminals
+    ssize_t transfer(const uint8_t *data, size_t size, uint8_t *reply, size_t reply_size, int timeout); //write data and read reply
+    bool write(const uint8_t *data, size_t size); //returns false unless all bytes were written
+
+  private:
+    int _address;
+    int _device;
+    bool _terminal;
+
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef COMMAND_WATCHDOG_HPP
+#define COMMAND_WATCHDOG_HPP
+
+#include <chrono>
+#include <string>
+#include <ros/ros.h>
+
+//stale command failsafe of one actuator channel
+//a command is fresh if its header stamp is newer than the last fresh one and not already older than the timeout; once no fresh command
+//has arrived for the timeout (timed on the monotonic clock from arrival) the output ramps to neutral, so a hung or starved upstream node
+//can't keep the car driving (output returns the commanded value while fresh, otherwise the last output ramped towards neutral by the ramp
+//step); the failsafe engaging (with its reaction time), reaching neutral, and releasing are logged
+class CommandWatchdog
+{
+  public:
+
+    //constructors and destructors
+    CommandWatchdog(const std::string& node_name, const std::string& channel_name);
+
+    //get functions
+    ros::Time getStamp() const; //header stamp of latest fresh command
+    float getValue() const; //latest commanded value
+    bool isStale() const; //failsafe engaged at last output
+
+    //set functions
+    void setTimeout(float timeout); //[s]
+    void setValue(float value); //replace latest commanded value without restarting the deadline
+
+    //other functions
+    float output(float value, float last_output, float ramp_step, const std::chrono::steady_clock::time_point& now); //value if fresh
+    void receive(float value, const ros::Time& stamp); //store received command, restarting the deadline if it is fresh
+
+  private:
+    std::string _channel_name;
+    std::string _node_name;
+    std::chrono::steady_clock::time_point _received; //arrival time of latest fresh command
+    bool _stale;
+    ros::Time _stamp;
+    float _timeout; //[s]
+    float _value;
+
+};
+
+#endif
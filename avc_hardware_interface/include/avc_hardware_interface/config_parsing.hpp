@@ -0,0 +1,36 @@
+#ifndef CONFIG_PARSING_HPP
+#define CONFIG_PARSING_HPP
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string>
+
+//parsing of fields of configuration files written by the nodes (throttle map, steering table)
+//fields must be numbers in full (trailing whitespace allowed); malformed fields return false instead of throwing, so a corrupted file
+//is rejected and its loader falls back to defaults
+
+inline bool parseFloat(const std::string& field, float& value)
+{
+
+  char *end;
+  value = strtof(field.c_str(), &end);
+  while (isspace((unsigned char)*end))
+    end++;
+
+  return !field.empty() && (end != field.c_str()) && (*end == '\0');
+
+}
+
+inline bool parseUnsignedLong(const std::string& field, unsigned long& value)
+{
+
+  char *end;
+  value = strtoul(field.c_str(), &end, 10);
+  while (isspace((unsigned char)*end))
+    end++;
+
+  return !field.empty() && (field[0] != '-') && (end != field.c_str()) && (*end == '\0');
+
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <atomic>
+#include <stdint.h>
+
+//latency histogram with power-of-two buckets of microseconds
+//bucket i counts latencies in [2^i, 2^(i + 1)) us, the first bucket also counts shorter and the last bucket also counts longer latencies
+//counters are relaxed atomics, so one thread can record while others read or reset without locks (reads made while recording are
+//approximate)
+class LatencyHistogram
+{
+  public:
+
+    static const int BUCKETS = 24; //last bucket starts at 2^23 us (8.4 s)
+
+    //constructors and destructors
+    LatencyHistogram();
+
+    //get functions
+    uint64_t getCount() const; //number of latencies recorded
+    uint64_t getCount(int bucket) const; //number of latencies recorded in bucket
+    double getMax() const; //[s]
+    double getMean() const; //[s]
+
+    //other functions
+    void record(double latency); //record latency [s], negative latencies are recorded as zero
+    void reset();
+
+  private:
+    std::atomic<uint64_t> _buckets[BUCKETS];
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _max; //[us]
+    std::atomic<uint64_t> _sum; //[us]
+
+};
+
+#endif
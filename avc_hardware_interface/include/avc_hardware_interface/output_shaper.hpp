@@ -0,0 +1,53 @@
+#ifndef OUTPUT_SHAPER_HPP
+#define OUTPUT_SHAPER_HPP
+
+//shaping limits of one actuator channel (units of the channel, e.g. [%] or [deg]), a limit of zero disables it
+struct ShapingLimits
+{
+  float max_rate_away; //max rate of change away from neutral [units/s]
+  float max_rate_towards; //max rate of change towards neutral [units/s]
+  float max_rate_change; //max change of rate, limiting jerk of the actuator motion [units/s^2]
+};
+
+//output shaping of one actuator channel
+//upstream commands are linearly interpolated over the interval they arrived at (up to the max interpolation time), so the shaper can run
+//at a fixed rate higher than its upstream publishers, and the output follows the interpolated command within the rate limits; with a rate
+//change limit the rate is also reduced in time to reach the command without overshooting it
+class OutputShaper
+{
+  public:
+
+    //constructors and destructors
+    OutputShaper(const ShapingLimits& limits, float max_interpolation_time);
+
+    //get functions
+    float getOutput() const;
+    float getRate() const;
+
+    //set functions
+    void setCommand(float command, double time); //new upstream command received at time [s, monotonic clock]
+
+    //other functions
+    void reset(float output); //jump to output at rest, forgetting previous commands
+    float update(double time); //advance output to time [s, monotonic clock], returns shaped output
+
+  private:
+    float interpolatedCommand(double time) const; //command at time
+
+    ShapingLimits _limits;
+    float _max_interpolation_time; //[s]
+
+    float _command; //latest command
+    double _command_time; //time latest command was received [s]
+    bool _has_command;
+    float _interpolation_duration; //time to reach latest command from start command [s]
+    float _interpolation_start; //command interpolation started from
+
+    float _output;
+    float _rate; //[units/s]
+    double _time; //time of last update [s]
+    bool _has_time;
+
+};
+
+#endif
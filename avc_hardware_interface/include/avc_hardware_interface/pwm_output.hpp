@@ -0,0 +1,160 @@
+#ifndef PWM_OUTPUT_HPP
+#define PWM_OUTPUT_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <arduino_link.hpp>
+
+//PWM output channels
+enum PwmChannel
+{
+  PWM_ESC = 0,
+  PWM_STEERING = 1,
+  PWM_CHANNELS = 2
+};
+
+//servo pulse output used by actuator_node
+//every write outputs the pulsewidth of all channels [us], backends output them as close to atomically as their device allows
+class PwmOutput
+{
+  public:
+
+    //constructors and destructors
+    virtual ~PwmOutput() {}
+
+    //other functions
+    virtual bool init() = 0; //returns false if output device can't be opened
+    virtual bool write(const int *pulsewidths) = 0; //output pulsewidths of all channels [us], returns false on write error
+
+};
+
+//servoblaster driver output
+//both channels are written with a single write from command lines formatted once at construction (servoblaster uses units of tens
+//of microseconds); the device is held open until the output is destroyed
+class ServoblasterOutput : public PwmOutput
+{
+  public:
+
+    //constructors and destructors
+    ServoblasterOutput(const std::string& device_path, const int *servo_numbers);
+    ~ServoblasterOutput();
+
+    //other functions
+    bool init();
+    bool write(const int *pulsewidths);
+
+  private:
+    static const int LINE_SIZE = 8; //longest command line ("nn=nnn\n")
+    static const int MIN_STEP = 50; //shortest pulsewidth in table [us / 10]
+    static const int MAX_STEP = 250; //longest pulsewidth in table [us / 10]
+    static const int STEPS = MAX_STEP - MIN_STEP + 1;
+
+    int _device;
+    std::string _device_path;
+    char _lines[PWM_CHANNELS][STEPS][LINE_SIZE];
+    int _lengths[PWM_CHANNELS][STEPS];
+
+};
+
+//Linux sysfs PWM output (/sys/class/pwm)
+//channels are exported and enabled on init, and their duty_cycle files are held open so each write is one pwrite per channel
+class SysfsPwmOutput : public PwmOutput
+{
+  public:
+
+    //constructors and destructors
+    SysfsPwmOutput(const std::string& chip_path, const int *pwm_channels, int period);
+    ~SysfsPwmOutput();
+
+    //other functions
+    bool init();
+    bool write(const int *pulsewidths);
+
+  private:
+    bool writeAttribute(const std::string& path, int value); //write integer to sysfs attribute
+
+    int _duty_cycles[PWM_CHANNELS]; //duty_cycle file of each channel
+    int _period; //[us]
+    int _pwm_channels[PWM_CHANNELS];
+    std::string _chip_path;
+
+};
+
+//pigpio daemon output (pigpiod socket interface)
+//servo commands of both channels are sent in a single packet over a TCP connection held open, and both replies are checked
+class PigpioOutput : public PwmOutput
+{
+  public:
+
+    //constructors and destructors
+    PigpioOutput(const std::string& host, int port, const int *gpios);
+    ~PigpioOutput();
+
+    //other functions
+    bool init();
+    bool write(const int *pulsewidths);
+
+  private:
+    int _gpios[PWM_CHANNELS];
+    int _port;
+    int _socket;
+    std::string _host;
+
+};
+
+//Arduino output over I2C (or a terminal standing in for the Arduino)
+//pulsewidths of both channels are sent in one ARDUINO_PULSEWIDTHS frame, the Arduino generates the pulses and returns to neutral if no
+//frame arrives within its failsafe time, so the same pulsewidths must be written again regularly (actuator_node's keepalive time)
+class ArduinoI2COutput : public PwmOutput
+{
+  public:
+
+    //constructors and destructors
+    ArduinoI2COutput(const std::string& device_path, int address);
+
+    //other functions
+    bool init();
+    bool write(const int *pulsewidths);
+
+  private:
+    int _address;
+    ArduinoLink _link;
+    std::string _device_path;
+    uint8_t _sequence;
+
+};
+
+//simulated output recording every write in memory
+//samples are timestamped on the monotonic clock, writes beyond capacity are counted but not recorded, so writes never allocate
+class SimulatedOutput : public PwmOutput
+{
+  public:
+
+    //one recorded write
+    struct Sample
+    {
+      uint64_t timestamp; //[ns, steady clock]
+      int pulsewidths[PWM_CHANNELS]; //[us]
+    };
+
+    //constructors and destructors
+    SimulatedOutput(size_t capacity);
+
+    //get functions
+    const std::vector<Sample>& getSamples() const;
+    unsigned long getWrites() const; //number of writes, including those not recorded
+
+    //other functions
+    void clear();
+    bool init();
+    bool write(const int *pulsewidths);
+
+  private:
+    size_t _capacity;
+    std::vector<Sample> _samples;
+    unsigned long _writes;
+
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef SPEED_CONTROLLER_HPP
+#define SPEED_CONTROLLER_HPP
+
+#include <string>
+#include <vector>
+
+//learned map of throttle holding each forward speed
+//throttles are stored at evenly spaced speeds from 0 to max speed and linearly interpolated; bins start out linear in speed (initial
+//gain) and are pulled towards throttles observed at steady speeds, so the map adapts to battery charge, surface, and ESC deadband
+class ThrottleMap
+{
+  public:
+
+    //constructors and destructors
+    ThrottleMap(float max_speed, int bins, float initial_gain, float learning_rate);
+
+    //get functions
+    float getThrottle(float speed) const; //throttle holding speed [%] ([m/s]), extrapolated above max speed
+    unsigned long getSamples() const; //number of steady speed samples learned
+
+    //other functions
+    void learn(float speed, float throttle); //pull bins around speed [m/s] towards throttle [%] observed holding it
+    bool load(const std::string& path); //read map written by save, returns false if file can't be read, is malformed, or doesn't match the bins
+    bool save(const std::string& path) const; //write map as comma separated speed, throttle, and samples of each bin
+
+  private:
+    float _bin_width; //[m/s]
+    float _learning_rate; //fraction of difference learned per sample [0 to 1]
+    std::vector<unsigned long> _samples;
+    std::vector<float> _throttles; //[%]
+
+};
+
+//speed controller gains and limits
+struct SpeedControllerGains
+{
+  float kp; //[% / (m/s)]
+  float ki; //[% / m]
+  float max_brake; //largest negative throttle output to slow down [%]
+};
+
+//closed-loop forward speed controller
+//output throttle is the feedforward throttle of the throttle map at the target speed, corrected by a PI controller on measured speed;
+//the map learns the throttle output whenever throttle and speed have settled; without a valid speed measurement only feedforward is
+//output, and a target speed of zero brakes proportionally to speed until stopped
+class SpeedController
+{
+  public:
+
+    //constructors and destructors
+    SpeedController(const SpeedControllerGains& gains, const ThrottleMap& map);
+
+    //get functions
+    float getFeedforward() const; //feedforward throttle of last update [%]
+    ThrottleMap& getThrottleMap();
+
+    //other functions
+    void reset(); //clear integral and settling state (map is kept)
+    float update(float target_speed, float speed, bool speed_valid, float max_throttle, float dt); //returns throttle [%], speeds [m/s]
+
+  private:
+    static const float SETTLE_SPEED_BAND; //largest speed change while settled [m/s]
+    static const float SETTLE_THROTTLE_BAND; //largest throttle change while settled [%]
+    static const float SETTLE_TIME; //time speed and throttle must stay settled for before they are learned [s]
+
+    SpeedControllerGains _gains;
+    ThrottleMap _map;
+
+    float _feedforward; //[%]
+    float _integral; //[%]
+    float _output; //[%]
+
+    float _settle_speed; //[m/s]
+    float _settle_throttle; //[%]
+    float _settle_time; //[s]
+
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef STEERING_TABLE_HPP
+#define STEERING_TABLE_HPP
+
+#include <string>
+
+//steering servo pulsewidths at evenly spaced steering angles from full right (-max angle) to full left (max angle)
+//pulsewidths are kept in a fixed flat array and linearly interpolated, so mapping an angle is a multiply, an index, and a blend; the
+//default table has three points (max right, neutral, max left), the same mapping as separate left and right linear ranges, and a table
+//calibrated against measured curvature (steering_calibration_node) corrects for the nonlinear steering linkage
+class SteeringTable
+{
+  public:
+
+    static const int MAX_POINTS = 61; //1 deg spacing at 30 deg max angle
+
+    //constructors and destructors
+    SteeringTable(float max_angle, int neutral, int max_left, int max_right);
+
+    //get functions
+    float getMaxAngle() const; //[deg]
+    int getPoints() const;
+    float getPulsewidth(float angle) const; //pulsewidth of steering angle [us] ([deg], positive left), clamped to the table ends
+    float getPointAngle(int point) const; //[deg]
+    float getPointPulsewidth(int point) const; //[us]
+
+    //set functions
+    bool setPulsewidths(const float *pulsewidths, int points); //returns false if points is out of range [2 to MAX_POINTS]
+
+    //other functions
+    bool load(const std::string& path); //read table written by save, returns false if file can't be read, is malformed, or doesn't span max angle
+    bool save(const std::string& path) const; //write table as comma separated angle and pulsewidth of each point
+
+  private:
+    float _max_angle; //[deg]
+    float _scale; //points per degree
+    int _points;
+    float _pulsewidths[MAX_POINTS]; //[us]
+
+};
+
+#endif
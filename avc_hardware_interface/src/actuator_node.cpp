@@ -0,0 +1,703 @@
+//actuator node
+//outputs throttle and steering commands to the ESC and steering servo
+//pulses are output by the PWM output backend selected with the output parameter (servoblaster, sysfs, pigpio, arduino, or simulated),
+//which holds its device open for the life of the node and writes both channels at once, so throttle and steering always change together
+//every command must be followed by a fresh one (newer header stamp, not older than the command timeout) within the command timeout, timed
+//on the monotonic clock from its arrival; otherwise the channel ramps to neutral, so a hung or starved upstream node can't keep the car driving
+//the ESC is armed by outputting neutral for the arming time while the node keeps running, and readiness is published on the latched armed
+//topic, which navigation waits for before driving
+//commands are shaped every cycle before they are output (interpolated between upstream commands, and limited in rate and rate change), so
+//every control source gets smooth, bounded actuator motion; the node runs faster than its upstream publishers for this
+//applied outputs and pulsewidths are published as actuator_state every state decimation cycles, and histograms of write latency and
+//command age (upstream stamp to write) are returned by the actuator_latency service
+//ESC commands in velocity mode give a target speed, and the throttle is set by a speed controller using wheel speed from the encoders
+//and a learned throttle-to-speed map for feedforward (their throttle percent limits the controller output)
+//steering angles are mapped to pulsewidths by interpolating a steering table, linear between neutral and the left and right limits unless
+//a table calibrated against measured curvature (steering_calibration_node) is loaded, so commanded and achieved curvature match
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <command_watchdog.hpp>
+#include <latency_histogram.hpp>
+#include <output_shaper.hpp>
+#include <pwm_output.hpp>
+#include <speed_controller.hpp>
+#include <steering_table.hpp>
+#include <ros/ros.h>
+#include <avc_msgs/ActuatorState.h>
+#include <avc_msgs/Armed.h>
+#include <avc_msgs/ESC.h>
+#include <avc_msgs/GetActuatorLatency.h>
+#include <avc_msgs/SteeringServo.h>
+#include <avc_msgs/WheelEncoders.h>
+#include <signal.h>
+
+//number of writes recorded by simulated output
+const size_t SIMULATED_CAPACITY = 100000;
+
+//ESC arming states
+enum ArmingState
+{
+  ARMING, //outputting neutral for arming time
+  WAITING_FOR_NEUTRAL, //arming time elapsed, waiting for throttle command to return to neutral
+  ARMED
+};
+
+//global variables
+bool force_output = false;
+CommandWatchdog steering_command("actuator_node", "steering");
+CommandWatchdog throttle_command("actuator_node", "throttle");
+LatencyHistogram command_age_histogram;
+LatencyHistogram write_latency_histogram;
+bool velocity_mode = false; //ESC commands give target speed
+float target_speed = 0; //[m/s]
+float wheel_radius = 0; //[m]
+float wheel_speed = 0; //ground speed of front wheels [m/s]
+std::chrono::steady_clock::time_point wheel_speed_received; //arrival time of latest wheel speed
+
+
+//callback function called to process SIGINT command
+void sigintHandler(int sig)
+{
+
+  //call the default shutdown function
+  ros::shutdown();
+
+}
+
+//callback function called to process messages on esc topic
+void escCallback(const avc_msgs::ESC::ConstPtr& msg)
+{
+
+  //set local value to received value
+  throttle_command.receive(msg->throttle_percent, msg->header.stamp);
+  velocity_mode = msg->velocity_mode;
+  target_speed = msg->target_speed;
+
+}
+
+//callback function called to process messages on wheel encoders topic
+void wheelEncodersCallback(const avc_msgs::WheelEncoders::ConstPtr& msg)
+{
+
+  //average front (undriven) wheels and convert angular velocity to ground speed [m/s]
+  wheel_speed = (msg->front_left + msg->front_right) / 2 * wheel_radius;
+  wheel_speed_received = std::chrono::steady_clock::now();
+
+}
+
+//callback function called to process messages on steering_servo topic
+void steeringServoCallback(const avc_msgs::SteeringServo::ConstPtr& msg)
+{
+
+  //set local value to received value
+  steering_command.receive(msg->steering_angle, msg->header.stamp);
+
+}
+
+//callback function called to process service requests on the actuator latency topic
+bool actuatorLatencyCallback(avc_msgs::GetActuatorLatency::Request& req, avc_msgs::GetActuatorLatency::Response& res)
+{
+
+  //copy histograms to response
+  res.write_latency.resize(LatencyHistogram::BUCKETS);
+  res.command_age.resize(LatencyHistogram::BUCKETS);
+  for (int bucket = 0; bucket < LatencyHistogram::BUCKETS; bucket++)
+  {
+    res.write_latency[bucket] = write_latency_histogram.getCount(bucket);
+    res.command_age[bucket] = command_age_histogram.getCount(bucket);
+  }
+  res.write_latency_mean = write_latency_histogram.getMean();
+  res.write_latency_max = write_latency_histogram.getMax();
+  res.command_age_mean = command_age_histogram.getMean();
+  res.command_age_max = command_age_histogram.getMax();
+
+  //clear histograms if requested
+  if (req.reset)
+  {
+    write_latency_histogram.reset();
+    command_age_histogram.reset();
+  }
+
+  return true;
+
+}
+
+//write pulsewidths to output, recording write latency [s]
+bool timedWrite(PwmOutput *output, const int *pulsewidths, float& latency)
+{
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool success = output->write(pulsewidths);
+  latency = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+  write_latency_histogram.record(latency);
+
+  return success;
+
+}
+
+//callback function to process timer firing event
+void timerCallback(const ros::TimerEvent& event)
+{
+
+  //set force output to true to force servo output
+  force_output = true;
+
+}
+
+int main(int argc, char **argv)
+{
+
+  //send notification that node is launching
+  ROS_INFO("[NODE LAUNCH]: starting actuator_node");
+
+  //initialize node and create node handler
+  ros::init(argc, argv, "actuator_node");
+  ros::NodeHandle node_private("~");
+  ros::NodeHandle node_public;
+
+  //override the default SIGINT handler
+  signal(SIGINT, sigintHandler);
+
+  //retrieve ESC max pulsewidth value from parameter server [us]
+  int esc_max_value;
+  if (!node_private.getParam("/hardware/actuator_node/esc_max_value", esc_max_value))
+  {
+    ROS_ERROR("[actuator_node] ESC max value not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve ESC min pulsewidth value from parameter server [us]
+  int esc_min_value;
+  if (!node_private.getParam("/hardware/actuator_node/esc_min_value", esc_min_value))
+  {
+    ROS_ERROR("[actuator_node] ESC min value not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve ESC neutral pulsewidth value from parameter server [us]
+  int esc_neutral_value;
+  if (!node_private.getParam("/hardware/actuator_node/esc_neutral_value", esc_neutral_value))
+  {
+    ROS_ERROR("[actuator_node] ESC neutral value not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve servo max rotation angle value from parameter server [deg]
+  float ss_max_angle;
+  if (!node_private.getParam("/steering_servo/max_rotation_angle", ss_max_angle))
+  {
+    ROS_ERROR("[actuator_node] steering servo max angle not defined in config file: avc_bringup/config/global.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve servo max right pulsewidth value from parameter server [us]
+  int ss_max_right;
+  if (!node_private.getParam("/hardware/actuator_node/ss_max_right", ss_max_right))
+  {
+    ROS_ERROR("[actuator_node] steering servo max right value not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve servo max left pulsewidth value from parameter server [us]
+  int ss_max_left;
+  if (!node_private.getParam("/hardware/actuator_node/ss_max_left", ss_max_left))
+  {
+    ROS_ERROR("[actuator_node] steering servo max left value not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve servo neutral pulsewidth value from parameter server [us]
+  int ss_neutral_value;
+  if (!node_private.getParam("/hardware/actuator_node/ss_neutral_value", ss_neutral_value))
+  {
+    ROS_ERROR("[actuator_node] steering servo neutral value not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve steering table written by steering_calibration_node from parameter server ("" maps angles linearly to left and right ranges)
+  std::string ss_table_file = "";
+  if (!node_private.getParam("/hardware/actuator_node/ss_table_file", ss_table_file))
+  {
+    ROS_WARN("[actuator_node] no steering table file provided, using linear left and right ranges");
+  }
+
+  //retrieve refresh rate of node in hertz from parameter server
+  float refresh_rate;
+  if (!node_private.getParam("/hardware/actuator_node/refresh_rate", refresh_rate))
+  {
+    ROS_ERROR("[actuator_node] actuator node refresh rate not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve force servo output time value from parameter server
+  float force_output_time;
+  if (!node_private.getParam("/hardware/servoblaster/force_output_time", force_output_time))
+  {
+    ROS_ERROR("[actuator_node] force servo output time not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve time neutral is output for to arm the ESC from parameter server [s]
+  float arming_time = 3.0;
+  if (!node_private.getParam("/hardware/actuator_node/arming_time", arming_time))
+  {
+    ROS_WARN_STREAM("[actuator_node] no arming time provided, using default: " << arming_time);
+  }
+
+  //retrieve time after which a command without a fresh successor is stale from parameter server [s]
+  float command_timeout = 0.25;
+  if (!node_private.getParam("/hardware/actuator_node/command_timeout", command_timeout))
+  {
+    ROS_WARN_STREAM("[actuator_node] no command timeout provided, using default: " << command_timeout);
+  }
+  throttle_command.setTimeout(command_timeout);
+  steering_command.setTimeout(command_timeout);
+
+  //retrieve rate throttle ramps to neutral at when commands are stale from parameter server [%/s]
+  float throttle_ramp_rate = 200;
+  if (!node_private.getParam("/hardware/actuator_node/throttle_ramp_rate", throttle_ramp_rate))
+  {
+    ROS_WARN_STREAM("[actuator_node] no throttle ramp rate provided, using default: " << throttle_ramp_rate);
+  }
+
+  //retrieve rate steering ramps to neutral at when commands are stale from parameter server [deg/s]
+  float steering_ramp_rate = 120;
+  if (!node_private.getParam("/hardware/actuator_node/steering_ramp_rate", steering_ramp_rate))
+  {
+    ROS_WARN_STREAM("[actuator_node] no steering ramp rate provided, using default: " << steering_ramp_rate);
+  }
+
+  //retrieve throttle shaping limits from parameter server [%/s], [%/s^2] (zero disables a limit)
+  ShapingLimits throttle_limits = { 100, 500, 0 };
+  if (!node_private.getParam("/hardware/actuator_node/throttle_slew_rate", throttle_limits.max_rate_away))
+  {
+    ROS_WARN_STREAM("[actuator_node] no throttle slew rate provided, using default: " << throttle_limits.max_rate_away);
+  }
+  if (!node_private.getParam("/hardware/actuator_node/throttle_brake_rate", throttle_limits.max_rate_towards))
+  {
+    ROS_WARN_STREAM("[actuator_node] no throttle brake rate provided, using default: " << throttle_limits.max_rate_towards);
+  }
+  if (!node_private.getParam("/hardware/actuator_node/throttle_jerk_limit", throttle_limits.max_rate_change))
+  {
+    ROS_WARN_STREAM("[actuator_node] no throttle jerk limit provided, using default: " << throttle_limits.max_rate_change);
+  }
+
+  //retrieve steering servo shaping limits from parameter server [deg/s], [deg/s^2] (zero disables a limit)
+  ShapingLimits steering_limits = { 300, 300, 0 };
+  if (!node_private.getParam("/hardware/actuator_node/steering_slew_rate", steering_limits.max_rate_away))
+  {
+    ROS_WARN_STREAM("[actuator_node] no steering slew rate provided, using default: " << steering_limits.max_rate_away);
+  }
+  steering_limits.max_rate_towards = steering_limits.max_rate_away;
+  if (!node_private.getParam("/hardware/actuator_node/steering_jerk_limit", steering_limits.max_rate_change))
+  {
+    ROS_WARN_STREAM("[actuator_node] no steering jerk limit provided, using default: " << steering_limits.max_rate_change);
+  }
+
+  //retrieve longest time commands are interpolated over from parameter server [s]
+  float interpolation_time = 0.1;
+  if (!node_private.getParam("/hardware/actuator_node/interpolation_time", interpolation_time))
+  {
+    ROS_WARN_STREAM("[actuator_node] no interpolation time provided, using default: " << interpolation_time);
+  }
+
+  //retrieve speed controller parameters from parameter server
+  SpeedControllerGains speed_gains;
+  float map_max_speed, map_initial_gain, map_learning_rate, speed_timeout;
+  int map_bins;
+  std::string map_file;
+  if (!node_private.getParam("/hardware/speed_controller/kp", speed_gains.kp) ||
+    !node_private.getParam("/hardware/speed_controller/ki", speed_gains.ki) ||
+    !node_private.getParam("/hardware/speed_controller/max_brake", speed_gains.max_brake) ||
+    !node_private.getParam("/hardware/speed_controller/map_bins", map_bins) ||
+    !node_private.getParam("/hardware/speed_controller/map_file", map_file) ||
+    !node_private.getParam("/hardware/speed_controller/map_initial_gain", map_initial_gain) ||
+    !node_private.getParam("/hardware/speed_controller/map_learning_rate", map_learning_rate) ||
+    !node_private.getParam("/hardware/speed_controller/map_max_speed", map_max_speed) ||
+    !node_private.getParam("/hardware/speed_controller/speed_timeout", speed_timeout))
+  {
+    ROS_ERROR("[actuator_node] speed controller parameters not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve wheel radius used to convert encoder angular velocity to ground speed from parameter server [m]
+  if (!node_private.getParam("/sensor/encoder/wheel_radius", wheel_radius))
+  {
+    ROS_WARN("[actuator_node] wheel radius not defined in config file: avc_sensors/config/sensors.yaml, velocity mode uses feedforward only");
+  }
+
+  //retrieve number of cycles between actuator state messages from parameter server
+  int state_decimation = 10;
+  if (!node_private.getParam("/hardware/actuator_node/state_decimation", state_decimation))
+  {
+    ROS_WARN_STREAM("[actuator_node] no state decimation provided, using default: " << state_decimation);
+  }
+
+  //retrieve PWM output backend from parameter server
+  std::string output_type = "servoblaster";
+  if (!node_private.getParam("/hardware/actuator_node/output", output_type))
+  {
+    ROS_WARN_STREAM("[actuator_node] no PWM output provided, using default: " << output_type);
+  }
+
+  //create PWM output, retrieving parameters of selected backend from parameter server
+  PwmOutput *output = NULL;
+  if (output_type == "servoblaster")
+  {
+
+    std::string sb_driver_path;
+    int servo_numbers[PWM_CHANNELS];
+    if (!node_private.getParam("/hardware/servoblaster/sb_driver_path", sb_driver_path) ||
+      !node_private.getParam("/hardware/servoblaster/esc_servo_number", servo_numbers[PWM_ESC]) ||
+      !node_private.getParam("/hardware/servoblaster/ss_servo_number", servo_numbers[PWM_STEERING]))
+    {
+      ROS_ERROR("[actuator_node] servoblaster parameters not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+      ROS_BREAK();
+    }
+    output = new ServoblasterOutput(sb_driver_path, servo_numbers);
+
+  }
+  else if (output_type == "sysfs")
+  {
+
+    std::string chip_path;
+    int pwm_channels[PWM_CHANNELS];
+    int period;
+    if (!node_private.getParam("/hardware/sysfs_pwm/chip_path", chip_path) ||
+      !node_private.getParam("/hardware/sysfs_pwm/esc_channel", pwm_channels[PWM_ESC]) ||
+      !node_private.getParam("/hardware/sysfs_pwm/ss_channel", pwm_channels[PWM_STEERING]) ||
+      !node_private.getParam("/hardware/sysfs_pwm/period", period))
+    {
+      ROS_ERROR("[actuator_node] sysfs PWM parameters not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+      ROS_BREAK();
+    }
+    output = new SysfsPwmOutput(chip_path, pwm_channels, period);
+
+  }
+  else if (output_type == "pigpio")
+  {
+
+    std::string host;
+    int port;
+    int gpios[PWM_CHANNELS];
+    if (!node_private.getParam("/hardware/pigpio/host", host) || !node_private.getParam("/hardware/pigpio/port", port) ||
+      !node_private.getParam("/hardware/pigpio/esc_gpio", gpios[PWM_ESC]) ||
+      !node_private.getParam("/hardware/pigpio/ss_gpio", gpios[PWM_STEERING]))
+    {
+      ROS_ERROR("[actuator_node] pigpio parameters not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+      ROS_BREAK();
+    }
+    output = new PigpioOutput(host, port, gpios);
+
+  }
+  else if (output_type == "arduino")
+  {
+
+    std::string i2c_device;
+    int i2c_address;
+    if (!node_private.getParam("/hardware/arduino_pwm/i2c_device", i2c_device) || !node_private.getParam("/arduino/i2c_address", i2c_address))
+    {
+      ROS_ERROR("[actuator_node] arduino PWM parameters not defined in config files: avc_hardware_interface/config/hardware_interface.yaml, avc_bringup/config/global.yaml");
+      ROS_BREAK();
+    }
+    output = new ArduinoI2COutput(i2c_device, i2c_address);
+
+    //the arduino returns to neutral when no frame arrives within its failsafe time, so unchanged outputs are written again at least
+    //every keepalive time [s]
+    float keepalive_time = 0.1;
+    if (!node_private.getParam("/hardware/arduino_pwm/keepalive_time", keepalive_time))
+    {
+      ROS_WARN_STREAM("[actuator_node] no arduino keepalive time provided, using default: " << keepalive_time);
+    }
+    force_output_time = std::min(force_output_time, keepalive_time);
+
+  }
+  else if (output_type == "simulated")
+    output = new SimulatedOutput(SIMULATED_CAPACITY);
+  else
+  {
+    ROS_ERROR("[actuator_node] unknown PWM output: %s (servoblaster, sysfs, pigpio, arduino, or simulated)", output_type.c_str());
+    ROS_BREAK();
+  }
+
+  //open output device, it is held open until node shuts down
+  if (!output->init())
+  {
+    ROS_ERROR("[actuator_node] failed to initialize %s PWM output", output_type.c_str());
+    ROS_BREAK();
+  }
+  ROS_INFO("[actuator_node] using %s PWM output", output_type.c_str());
+
+  //neutral pulsewidths output while arming and on shutdown [us]
+  int neutral_pulsewidths[PWM_CHANNELS];
+  neutral_pulsewidths[PWM_ESC] = esc_neutral_value;
+  neutral_pulsewidths[PWM_STEERING] = ss_neutral_value;
+
+  //create subscriber to subscribe to ESC message topic with queue size set to 1
+  ros::Subscriber esc_sub = node_public.subscribe("esc", 1, escCallback);
+
+  //create subscriber to subscribe to steering servo message topic with queue size set to 1
+  ros::Subscriber steering_servo_sub = node_public.subscribe("steering_servo", 1, steeringServoCallback);
+
+  //create subscriber to subscribe to wheel encoders topic with queue size set to 1
+  ros::Subscriber wheel_encoders_sub = node_public.subscribe("/sensor/wheel_encoders", 1, wheelEncodersCallback);
+
+  //create speed controller, loading throttle map learned in previous runs
+  ThrottleMap throttle_map(map_max_speed, map_bins, map_initial_gain, map_learning_rate);
+  if (!map_file.empty())
+  {
+    if (throttle_map.load(map_file))
+      ROS_INFO("[actuator_node] throttle map read from %s", map_file.c_str());
+    else
+      ROS_WARN("[actuator_node] no throttle map matching map_max_speed and map_bins in %s, starting from initial gain", map_file.c_str());
+  }
+  SpeedController speed_controller(speed_gains, throttle_map);
+
+  //create steering table mapping steering angle to pulsewidth, loading table calibrated against measured curvature
+  SteeringTable steering_table(ss_max_angle, ss_neutral_value, ss_max_left, ss_max_right);
+  if (!ss_table_file.empty())
+  {
+    if (steering_table.load(ss_table_file))
+      ROS_INFO("[actuator_node] steering table of %d points read from %s", steering_table.getPoints(), ss_table_file.c_str());
+    else
+      ROS_WARN("[actuator_node] no steering table spanning max_rotation_angle in %s, using linear ranges", ss_table_file.c_str());
+  }
+
+  //create publisher to publish armed status with buffer size 1, and latch set to true
+  ros::Publisher armed_pub = node_public.advertise<avc_msgs::Armed>("armed", 1, true);
+
+  //create publisher to publish actuator state with buffer size 1, and latch set to false
+  ros::Publisher state_pub = node_public.advertise<avc_msgs::ActuatorState>("actuator_state", 1, false);
+
+  //create service to return write latency and command age histograms
+  ros::ServiceServer latency_srv = node_public.advertiseService("actuator_latency", actuatorLatencyCallback);
+
+  //calculate throttle forward and reverse ranges
+  int esc_fwd_range = esc_max_value - esc_neutral_value;
+  int esc_rev_range = esc_neutral_value - esc_min_value;
+
+  //calculate steering pulsewidth limits
+  int ss_min_value = std::min(ss_max_left, ss_max_right);
+  int ss_max_value = std::max(ss_max_left, ss_max_right);
+
+
+  //publish that the ESC isn't armed yet
+  avc_msgs::Armed armed_msg;
+  armed_msg.header.stamp = ros::Time::now();
+  armed_msg.armed = false;
+  armed_pub.publish(armed_msg);
+
+  //start ESC arming, neutral is output every cycle until arming completes
+  ArmingState arming_state = ARMING;
+  std::chrono::steady_clock::time_point arming_start = std::chrono::steady_clock::now();
+  ROS_INFO("[actuator_node] beginning ESC arming sequence");
+
+  //create variables for remembering last output values (steering is output on first cycle)
+  float last_throttle_value = 0;
+  float last_steering_value = 9999;
+
+  //commands after stale command failsafe (commands are stale until the first fresh ones arrive)
+  float steering_angle = 0;
+  float throttle_percent = 0;
+  std::chrono::steady_clock::time_point last_cycle = std::chrono::steady_clock::now();
+
+  //shaped outputs, starting at neutral once armed
+  OutputShaper throttle_shaper(throttle_limits, interpolation_time);
+  OutputShaper steering_shaper(steering_limits, interpolation_time);
+  float throttle_output = 0;
+  float steering_output = 0;
+  float throttle_shaper_command = 0;
+  float steering_shaper_command = 0;
+
+  //create timer to force servo write every predetermined interval
+  ros::Timer timer = node_private.createTimer(ros::Duration(force_output_time), timerCallback, true);
+
+  //pulsewidths of both channels [us]
+  int pulsewidths[PWM_CHANNELS];
+
+  //actuator state message, published every state decimation cycles
+  avc_msgs::ActuatorState state_msg;
+  state_msg.header.frame_id = "0";
+  state_msg.esc_pulsewidth = esc_neutral_value;
+  state_msg.steering_pulsewidth = ss_neutral_value;
+  unsigned long cycles = 0;
+
+  //set loop rate in Hz
+  ros::Rate loop_rate(refresh_rate);
+
+  while (ros::ok())
+  {
+
+    //output latest commands, or ramp channels with stale commands to neutral
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    float elapsed = std::chrono::duration<float>(now - last_cycle).count();
+    last_cycle = now;
+
+    //in velocity mode the throttle requested is the speed controller output, limited to the commanded throttle (before arming, any
+    //nonzero target speed counts as a throttle request)
+    float throttle_request = throttle_command.getValue();
+    if (velocity_mode && (arming_state == ARMED))
+    {
+      bool speed_valid = (wheel_radius > 0) && (std::chrono::duration<float>(now - wheel_speed_received).count() <= speed_timeout);
+      throttle_request = speed_controller.update(target_speed, wheel_speed, speed_valid, throttle_command.getValue(), elapsed);
+    }
+    else if (velocity_mode && (target_speed <= 0))
+      throttle_request = 0;
+
+    throttle_percent = throttle_command.output(throttle_request, throttle_percent, throttle_ramp_rate * elapsed, now);
+    steering_angle = steering_command.output(steering_command.getValue(), steering_angle, steering_ramp_rate * elapsed, now);
+
+    //speed controller starts over whenever it isn't in control
+    if (!velocity_mode || throttle_command.isStale() || (arming_state != ARMED))
+      speed_controller.reset();
+
+    //advance ESC arming, the ESC is only armed once the throttle command is neutral, so the car can't start moving on arming
+    if (arming_state != ARMED)
+    {
+
+      float arming_elapsed = std::chrono::duration<float>(now - arming_start).count();
+      if ((arming_state == ARMING) && (arming_elapsed >= arming_time) && (throttle_percent != 0))
+      {
+        ROS_WARN("[actuator_node] ESC arming waiting for throttle command to return to neutral");
+        arming_state = WAITING_FOR_NEUTRAL;
+      }
+
+      if ((arming_elapsed >= arming_time) && (throttle_percent == 0))
+      {
+
+        ROS_INFO("[actuator_node] ESC arming sequence complete after %.2f s", arming_elapsed);
+        arming_state = ARMED;
+        throttle_shaper.reset(0);
+        steering_shaper.reset(0);
+
+        //publish armed status
+        armed_msg.header.stamp = ros::Time::now();
+        armed_msg.armed = true;
+        armed_pub.publish(armed_msg);
+
+      }
+      else
+      {
+
+        //output neutral signals
+        if (!timedWrite(output, neutral_pulsewidths, state_msg.write_latency))
+          ROS_ERROR_THROTTLE(1, "[actuator_node] failed to write to %s PWM output", output_type.c_str());
+
+      }
+
+    }
+
+    //shape commands, interpolating from the previous command whenever one changes
+    if (arming_state == ARMED)
+    {
+
+      double time = std::chrono::duration<double>(now.time_since_epoch()).count();
+      if (throttle_percent != throttle_shaper_command)
+        throttle_shaper.setCommand(throttle_percent, time);
+      if (steering_angle != steering_shaper_command)
+        steering_shaper.setCommand(steering_angle, time);
+      throttle_shaper_command = throttle_percent;
+      steering_shaper_command = steering_angle;
+
+      throttle_output = throttle_shaper.update(time);
+      steering_output = steering_shaper.update(time);
+
+    }
+
+    //if new throttle or steering value was requested then output both values
+    if ((arming_state == ARMED) && ((throttle_output != last_throttle_value) || (steering_output != last_steering_value) || force_output))
+    {
+
+      //if force output flag is true then reset to false
+      if (force_output)
+      {
+
+        //reset force output flag to false
+        force_output = false;
+
+        //reset timer
+        timer = node_private.createTimer(ros::Duration(force_output_time), timerCallback, true);
+
+      }
+
+      //convert throttle value to pulsewidth [us]
+      if (throttle_output >= 0)
+        pulsewidths[PWM_ESC] = esc_neutral_value + (throttle_output / 100 * esc_fwd_range);
+      else
+        pulsewidths[PWM_ESC] = esc_neutral_value - (fabs(throttle_output) / 100 * esc_rev_range);
+
+      //convert steering angle to pulsewidth [us]
+      pulsewidths[PWM_STEERING] = lroundf(steering_table.getPulsewidth(steering_output));
+
+      //limit pulsewidths to configured ranges
+      pulsewidths[PWM_ESC] = std::min(std::max(pulsewidths[PWM_ESC], esc_min_value), esc_max_value);
+      pulsewidths[PWM_STEERING] = std::min(std::max(pulsewidths[PWM_STEERING], ss_min_value), ss_max_value);
+
+      //output both channels at once
+      if (!timedWrite(output, pulsewidths, state_msg.write_latency))
+        ROS_ERROR_THROTTLE(1, "[actuator_node] failed to write to %s PWM output", output_type.c_str());
+      state_msg.esc_pulsewidth = pulsewidths[PWM_ESC];
+      state_msg.steering_pulsewidth = pulsewidths[PWM_STEERING];
+
+      //record age of older command written (commands without stamps aren't recorded)
+      ros::Time command_stamp = std::min(throttle_command.getStamp(), steering_command.getStamp());
+      if (command_stamp.isZero())
+        command_stamp = std::max(throttle_command.getStamp(), steering_command.getStamp());
+      if (!command_stamp.isZero())
+      {
+        state_msg.command_age = (ros::Time::now() - command_stamp).toSec();
+        command_age_histogram.record(state_msg.command_age);
+      }
+
+      //set last values to current values
+      last_throttle_value = throttle_output;
+      last_steering_value = steering_output;
+
+    }
+
+    //publish actuator state every state decimation cycles
+    if ((state_decimation > 0) && (++cycles % state_decimation == 0))
+    {
+      state_msg.header.stamp = ros::Time::now();
+      state_msg.armed = (arming_state == ARMED);
+      state_msg.throttle_percent = throttle_output;
+      state_msg.steering_angle = steering_output;
+      state_msg.throttle_stale = throttle_command.isStale();
+      state_msg.steering_stale = steering_command.isStale();
+      state_msg.velocity_mode = velocity_mode;
+      state_msg.target_speed = target_speed;
+      state_msg.speed = wheel_speed;
+      state_pub.publish(state_msg);
+    }
+
+    //process callback function calls
+    ros::spinOnce();
+
+    //sleep until next cycle
+    loop_rate.sleep();
+  }
+
+  //keep throttle map learned for next run
+  if (!map_file.empty() && (speed_controller.getThrottleMap().getSamples() > 0))
+  {
+    if (speed_controller.getThrottleMap().save(map_file))
+      ROS_INFO("[actuator_node] throttle map written to %s", map_file.c_str());
+    else
+      ROS_ERROR("[actuator_node] failed to write throttle map to %s", map_file.c_str());
+  }
+
+  //output latency statistics
+  ROS_INFO("[actuator_node] writes: %lu, write latency: mean %.3f ms, max %.3f ms", (unsigned long)write_latency_histogram.getCount(),
+    1000 * write_latency_histogram.getMean(), 1000 * write_latency_histogram.getMax());
+  if (command_age_histogram.getCount() > 0)
+    ROS_INFO("[actuator_node] command age at write: mean %.3f ms, max %.3f ms", 1000 * command_age_histogram.getMean(),
+      1000 * command_age_histogram.getMax());
+
+  //leave both channels at neutral and close output device
+  if (!output->write(neutral_pulsewidths))
+    ROS_ERROR("[actuator_node] failed to write neutral pulsewidths to %s PWM output", output_type.c_str());
+  delete output;
+
+  return 0;
+}
@@ -0,0 +1,281 @@
+//include header
+#include <arduino_link.hpp>
+
+#include <chrono>
+#include <fcntl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+
+//CRC-8 of data (polynomial 0x07, initial value 0)
+uint8_t crc8(const uint8_t *data, size_t size)
+{
+
+  uint8_t crc = 0;
+  for (size_t i = 0; i < size; i++)
+  {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+  }
+
+  return crc;
+
+}
+
+//encode frame into buffer, returns frame size (0 if payload is too long)
+size_t encodeArduinoFrame(uint8_t type, uint8_t sequence, const uint8_t *payload, size_t length, uint8_t *buffer)
+{
+
+  if (length > ARDUINO_MAX_PAYLOAD)
+    return 0;
+
+  buffer[0] = ARDUINO_FRAME_START;
+  buffer[1] = type;
+  buffer[2] = sequence;
+  buffer[3] = length;
+  if (length > 0)
+    memcpy(buffer + ARDUINO_HEADER_SIZE, payload, length);
+  buffer[ARDUINO_HEADER_SIZE + length] = crc8(buffer + 1, ARDUINO_HEADER_SIZE - 1 + length);
+
+  return ARDUINO_HEADER_SIZE + length + 1;
+
+}
+
+void putInt16(uint8_t *payload, int16_t value)
+{
+  putUint16(payload, (uint16_t)value);
+}
+
+void putUint16(uint8_t *payload, uint16_t value)
+{
+  payload[0] = value & 0xFF;
+  payload[1] = value >> 8;
+}
+
+int16_t getInt16(const uint8_t *payload)
+{
+  return (int16_t)getUint16(payload);
+}
+
+uint16_t getUint16(const uint8_t *payload)
+{
+  return payload[0] | (payload[1] << 8);
+}
+
+//returns true if sequence number is newer than last, within half the sequence range
+bool isNewerSequence(uint8_t sequence, uint8_t last)
+{
+  return (int8_t)(sequence - last) > 0;
+}
+
+
+//byte stream frame decoder
+
+//default constructor
+ArduinoFrameDecoder::ArduinoFrameDecoder()
+{
+  this->_crc_errors = 0;
+  this->reset();
+}
+
+//get functions
+
+unsigned int ArduinoFrameDecoder::getCrcErrors() const
+{
+  return this->_crc_errors;
+}
+
+//other functions
+
+//add byte to current frame, returns true and sets frame once byte completes a frame with a valid CRC
+bool ArduinoFrameDecoder::decode(uint8_t byte, ArduinoFrame& frame)
+{
+
+  //wait for start of frame
+  if ((this->_count == 0) && (byte != ARDUINO_FRAME_START))
+    return false;
+
+  //payload length is checked as soon as it arrives, so a corrupted length can't swallow following frames
+  this->_buffer[this->_count++] = byte;
+  if ((this->_count == ARDUINO_HEADER_SIZE) && (byte > ARDUINO_MAX_PAYLOAD))
+    return this->resync(this->_count, frame);
+  if ((this->_count < ARDUINO_HEADER_SIZE) || (this->_count < ARDUINO_HEADER_SIZE + this->_buffer[3] + 1))
+    return false;
+
+  //complete frame received, buffer keeps its contents until next frame starts
+  size_t length = this->_buffer[3];
+  this->reset();
+  if (crc8(this->_buffer + 1, ARDUINO_HEADER_SIZE - 1 + length) != this->_buffer[ARDUINO_HEADER_SIZE + length])
+  {
+    this->_crc_errors++;
+    return this->resync(ARDUINO_HEADER_SIZE + length + 1, frame);
+  }
+
+  frame.type = this->_buffer[1];
+  frame.sequence = this->_buffer[2];
+  frame.length = length;
+  memcpy(frame.payload, this->_buffer + ARDUINO_HEADER_SIZE, length);
+
+  return true;
+
+}
+
+//discard partially received frame
+void ArduinoFrameDecoder::reset()
+{
+  this->_count = 0;
+}
+
+//rescan the bytes after the start byte of a rejected frame, so a frame starting inside it (after a dropped byte) isn't lost as well
+bool ArduinoFrameDecoder::resync(size_t count, ArduinoFrame& frame)
+{
+
+  uint8_t bytes[ARDUINO_MAX_FRAME];
+  memcpy(bytes, this->_buffer + 1, count - 1);
+  this->reset();
+
+  bool decoded = false;
+  for (size_t i = 0; i < count - 1; i++)
+  {
+    if (this->decode(bytes[i], frame))
+      decoded = true;
+  }
+
+  return decoded;
+
+}
+
+
+//link to Arduino
+
+//default constructor
+ArduinoLink::ArduinoLink()
+{
+  this->_address = 0;
+  this->_device = -1;
+  this->_terminal = false;
+}
+
+//default destructor
+ArduinoLink::~ArduinoLink()
+{
+  this->close();
+}
+
+//get functions
+
+int ArduinoLink::getFileDescriptor() const
+{
+  return this->_device;
+}
+
+bool ArduinoLink::isOpen() const
+{
+  return this->_device != -1;
+}
+
+//other functions
+
+void ArduinoLink::close()
+{
+
+  if (this->_device != -1)
+  {
+    ::close(this->_device);
+    this->_device = -1;
+  }
+
+}
+
+//open I2C bus and select Arduino as slave, or open terminal in raw mode
+bool ArduinoLink::open(const std::string& device_path, int address)
+{
+
+  this->close();
+  this->_device = ::open(device_path.c_str(), O_RDWR | O_NOCTTY);
+  if (this->_device == -1)
+    return false;
+
+  bool success;
+  this->_address = address;
+  this->_terminal = isatty(this->_device);
+  if (this->_terminal)
+  {
+    struct termios options;
+    success = tcgetattr(this->_device, &options) == 0;
+    cfmakeraw(&options);
+    success = success && (tcsetattr(this->_device, TCSANOW, &options) == 0);
+  }
+  else
+    success = ioctl(this->_device, I2C_SLAVE, address) == 0;
+
+  if (!success)
+    this->close();
+
+  return success;
+
+}
+
+//write data and read up to reply_size bytes of reply within timeout [ms], returns number of bytes read (-1 on error)
+//on I2C buses both happen in one combined transaction (repeated start), on terminals earlier input is discarded before writing
+ssize_t ArduinoLink::transfer(const uint8_t *data, size_t size, uint8_t *reply, size_t reply_size, int timeout)
+{
+
+  if (!this->_terminal)
+  {
+
+    struct i2c_msg messages[2];
+    messages[0].addr = this->_address;
+    messages[0].flags = 0;
+    messages[0].len = size;
+    messages[0].buf = (uint8_t*)data;
+    messages[1].addr = this->_address;
+    messages[1].flags = I2C_M_RD;
+    messages[1].len = reply_size;
+    messages[1].buf = reply;
+
+    struct i2c_rdwr_ioctl_data transaction;
+    transaction.msgs = messages;
+    transaction.nmsgs = 2;
+
+    return (ioctl(this->_device, I2C_RDWR, &transaction) < 0) ? -1 : reply_size;
+
+  }
+
+  tcflush(this->_device, TCIFLUSH);
+  if (!this->write(data, size))
+    return -1;
+
+  //read until reply is complete or timeout expires
+  size_t received = 0;
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+  while (received < reply_size)
+  {
+
+    int remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    struct pollfd fds = { this->_device, POLLIN, 0 };
+    if ((remaining <= 0) || (poll(&fds, 1, remaining) <= 0))
+      break;
+
+    ssize_t count = ::read(this->_device, reply + received, reply_size - received);
+    if (count < 0)
+      return -1;
+    received += count;
+
+  }
+
+  return received;
+
+}
+
+//write data, on I2C buses in a single transfer
+bool ArduinoLink::write(const uint8_t *data, size_t size)
+{
+  return ::write(this->_device, data, size) == (ssize_t)size;
+}
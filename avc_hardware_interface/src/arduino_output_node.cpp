@@ -1,18 +1,33 @@
-//subscribe to navigation output (heading error [rad]), odometry
-//determine forward velocity as a function of steering angle, set as target
-//compare current forward velocity to target and apply correction (PID control)
+//Arduino output node
+//sends throttle and steering commands to the Arduino Nano as framed ARDUINO_COMMAND frames (16-bit fixed point values, sequence number,
+//CRC-8) whenever they change, and repeats the last command every keepalive time so the Arduino's failsafe stays released
+//every cycle telemetry (battery voltage, applied pulsewidths, loop overruns) is read back in the same I2C transaction as the command
+//(or a telemetry request if no command is due) and published with the measured round-trip latency
+//the Arduino arms the ESC itself, so readiness is published on the latched armed topic once it first answers with telemetry
+//commands must stay fresh by the same command_watchdog rule as in actuator_node (newer header stamp, not older than the command timeout, timed on the monotonic clock from
+//arrival), otherwise the channel ramps to neutral, so a hung upstream node can't keep the keepalive repeating its last command
+#include <algorithm>
+#include <chrono>
 #include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <arduino_link.hpp>
+#include <command_watchdog.hpp>
 #include <ros/ros.h>
+#include <avc_msgs/ArduinoTelemetry.h>
+#include <avc_msgs/Armed.h>
 #include <avc_msgs/Control.h>
 #include <avc_msgs/ESC.h>
 #include <avc_msgs/SteeringServo.h>
 #include <signal.h>
-#include <wiringPiI2C.h>
+
+//time to wait for telemetry from a terminal standing in for the arduino [ms]
+const int TELEMETRY_TIMEOUT = 20;
 
 //global variables
 bool autonomous_control = false;
-float steering_angle = 0;
-float throttle_percent = 0;
+CommandWatchdog steering_command("arduino_output_node", "steering");
+CommandWatchdog throttle_command("arduino_output_node", "throttle");
 
 
 //callback function called to process SIGINT command
@@ -32,8 +47,8 @@ void controlCallback(const avc_msgs::Control::ConstPtr& msg)
   autonomous_control = msg->autonomous_control;
 
   //reset steering and throttle values on control mode change
-  steering_angle = 0;
-  throttle_percent = 0;
+  steering_command.setValue(0);
+  throttle_command.setValue(0);
 
 }
 
@@ -41,8 +56,10 @@ void controlCallback(const avc_msgs::Control::ConstPtr& msg)
 void escCallback(const avc_msgs::ESC::ConstPtr& msg)
 {
 
-  //set local value to received value
-  throttle_percent = msg->throttle_percent;
+  //set local value to received value, velocity mode needs the speed controller of actuator_node, so its commands are held at neutral
+  throttle_command.receive(msg->velocity_mode ? 0 : msg->throttle_percent, msg->header.stamp);
+  if (msg->velocity_mode)
+    ROS_WARN_THROTTLE(5, "[arduino_output_node] velocity mode ESC commands aren't supported, throttle held at neutral");
 
 }
 
@@ -50,7 +67,21 @@ void steeringServoCallback(const avc_msgs::SteeringServo::ConstPtr& msg)
 {
 
   //set local value to received value
-  steering_angle = msg->steering_angle;
+  steering_command.receive(msg->steering_angle, msg->header.stamp);
+
+}
+
+//convert value to 16-bit fixed point with two decimals, saturating instead of wrapping
+int16_t toFixedPoint(float value)
+{
+
+  float scaled = roundf(value * 100);
+  if (scaled > INT16_MAX)
+    return INT16_MAX;
+  if (scaled < INT16_MIN)
+    return INT16_MIN;
+
+  return (int16_t)scaled;
 
 }
 
@@ -80,10 +111,47 @@ int main(int argc, char **argv)
   float refresh_rate;
   if (!node_private.getParam("/hardware/arduino_output_node/refresh_rate", refresh_rate))
   {
-    ROS_ERROR("[arduino_output_node] arduino output node refresh rate not defined in config file: sd_hardware_interface/config/hardware_interface.yaml");
+    ROS_ERROR("[arduino_output_node] arduino output node refresh rate not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
     ROS_BREAK();
   }
 
+  //retrieve device the arduino is connected to from parameter server (i2c bus, or a terminal such as fake_arduino's pseudo terminal)
+  std::string device = "/dev/i2c-1";
+  if (!node_private.getParam("/hardware/arduino_output_node/device", device))
+  {
+    ROS_WARN_STREAM("[arduino_output_node] no device provided, using default: " << device);
+  }
+
+  //retrieve time after which an unchanged command is sent again from parameter server [s]
+  float keepalive_time = 0.1;
+  if (!node_private.getParam("/hardware/arduino_output_node/keepalive_time", keepalive_time))
+  {
+    ROS_WARN_STREAM("[arduino_output_node] no keepalive time provided, using default: " << keepalive_time);
+  }
+
+  //retrieve time after which a command is stale from parameter server, shared with actuator_node [s]
+  float command_timeout = 0.25;
+  if (!node_private.getParam("/hardware/actuator_node/command_timeout", command_timeout))
+  {
+    ROS_WARN_STREAM("[arduino_output_node] no command timeout provided, using default: " << command_timeout);
+  }
+  throttle_command.setTimeout(command_timeout);
+  steering_command.setTimeout(command_timeout);
+
+  //retrieve rate throttle ramps to neutral at when commands are stale from parameter server, shared with actuator_node [%/s]
+  float throttle_ramp_rate = 200;
+  if (!node_private.getParam("/hardware/actuator_node/throttle_ramp_rate", throttle_ramp_rate))
+  {
+    ROS_WARN_STREAM("[arduino_output_node] no throttle ramp rate provided, using default: " << throttle_ramp_rate);
+  }
+
+  //retrieve rate steering ramps to neutral at when commands are stale from parameter server, shared with actuator_node [deg/s]
+  float steering_ramp_rate = 120;
+  if (!node_private.getParam("/hardware/actuator_node/steering_ramp_rate", steering_ramp_rate))
+  {
+    ROS_WARN_STREAM("[arduino_output_node] no steering ramp rate provided, using default: " << steering_ramp_rate);
+  }
+
   //create subscriber to subscribe to control message topic with queue size set to 1000
   ros::Subscriber control_sub = node_public.subscribe("/control/control", 1000, controlCallback);
 
@@ -93,15 +161,47 @@ int main(int argc, char **argv)
   //create subscriber to subscribe to steering servo message topic with queue size set to 1
   ros::Subscriber steering_servo_sub = node_public.subscribe("steering_servo", 1, steeringServoCallback);
 
-  //initialize i2c protocol and verify connection
-  int fd = wiringPiI2CSetup(i2c_address);
-  int result; //variable for holding i2c read/write result
+  //create publisher to publish arduino telemetry messages with buffer size 1, and latch set to false
+  ros::Publisher telemetry_pub = node_public.advertise<avc_msgs::ArduinoTelemetry>("arduino_telemetry", 1, false);
 
-  //output notification message and error if one occurs
-  if (fd == -1)
-    ROS_INFO("[arduino_output_node] error establishing i2c connection: %d", errno);
-  else
-    ROS_INFO("[arduino_output_node] i2c connection result: %d", fd);
+  //create publisher to publish armed status with buffer size 1, and latch set to true
+  ros::Publisher armed_pub = node_public.advertise<avc_msgs::Armed>("armed", 1, true);
+
+  //publish that the arduino isn't ready yet
+  avc_msgs::Armed armed_msg;
+  armed_msg.header.stamp = ros::Time::now();
+  armed_msg.armed = false;
+  armed_pub.publish(armed_msg);
+
+  //open link to arduino
+  ArduinoLink link;
+  if (!link.open(device, i2c_address))
+  {
+    ROS_ERROR("[arduino_output_node] failed to open arduino link on %s: %s", device.c_str(), strerror(errno));
+    ROS_BREAK();
+  }
+  ROS_INFO("[arduino_output_node] opened arduino link on %s", device.c_str());
+
+  //last command sent (forces first command to be sent)
+  int16_t last_throttle = 0;
+  int16_t last_steering = 0;
+  uint8_t sequence = 0;
+  std::chrono::steady_clock::time_point last_send;
+  unsigned long frames_sent = 0;
+
+  //telemetry decoding and round-trip latency statistics
+  ArduinoFrameDecoder decoder;
+  ArduinoFrame telemetry;
+  avc_msgs::ArduinoTelemetry telemetry_msg;
+  unsigned long telemetry_received = 0;
+  unsigned long telemetry_missed = 0;
+  double latency_sum = 0;
+  double latency_max = 0;
+
+  //values sent, ramping to neutral while commands are stale (commands start out stale until the first fresh one arrives)
+  float throttle_percent = 0;
+  float steering_angle = 0;
+  std::chrono::steady_clock::time_point last_cycle = std::chrono::steady_clock::now();
 
   //set loop rate in Hz
   ros::Rate loop_rate(refresh_rate);
@@ -109,15 +209,86 @@ int main(int argc, char **argv)
   while (ros::ok())
   {
 
-    //create array and set output values to current throttle percent and steering angle values
-    unsigned char outputValues[2] = { int(throttle_percent), int(steering_angle) };
-
-    //output motor PWM values to arduino via i2c protocol
-    result = write(fd, outputValues, 2);
+    //send latest commands, or ramp channels with stale commands to neutral
+    std::chrono::steady_clock::time_point cycle_start = std::chrono::steady_clock::now();
+    float elapsed = std::chrono::duration<float>(cycle_start - last_cycle).count();
+    last_cycle = cycle_start;
+    throttle_percent = throttle_command.output(throttle_command.getValue(), throttle_percent, throttle_ramp_rate * elapsed, cycle_start);
+    steering_angle = steering_command.output(steering_command.getValue(), steering_angle, steering_ramp_rate * elapsed, cycle_start);
+
+    //convert commands to fixed point [% / 100], [deg / 100]
+    int16_t throttle = toFixedPoint(throttle_percent);
+    int16_t steering = toFixedPoint(steering_angle);
+
+    //send command when it changes, and repeat it every keepalive time, otherwise only request telemetry
+    uint8_t frame[ARDUINO_MAX_FRAME];
+    size_t size;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if ((frames_sent == 0) || (throttle != last_throttle) || (steering != last_steering) ||
+      (std::chrono::duration<float>(now - last_send).count() >= keepalive_time))
+    {
+
+      uint8_t payload[4];
+      putInt16(payload, throttle);
+      putInt16(payload + 2, steering);
+      size = encodeArduinoFrame(ARDUINO_COMMAND, ++sequence, payload, sizeof(payload), frame);
+
+      last_throttle = throttle;
+      last_steering = steering;
+      last_send = now;
+      frames_sent++;
+
+    }
+    else
+      size = encodeArduinoFrame(ARDUINO_TELEMETRY_REQUEST, sequence, NULL, 0, frame);
+
+    //send frame and read telemetry back in one transfer
+    uint8_t reply[ARDUINO_TELEMETRY_FRAME];
+    ros::Time request_time = ros::Time::now();
+    ssize_t count = link.transfer(frame, size, reply, sizeof(reply), TELEMETRY_TIMEOUT);
+    double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - now).count();
 
     //output notification message if error occurs
-    if (result == -1)
-      ROS_INFO("[arduino_output_node] error writing to arduino via i2c: %d", errno);
+    if (count < 0)
+      ROS_ERROR_THROTTLE(1, "[arduino_output_node] error communicating with arduino: %s", strerror(errno));
+
+    //publish telemetry if a valid telemetry frame was received
+    bool received = false;
+    decoder.reset();
+    for (ssize_t i = 0; i < count; i++)
+    {
+      if (decoder.decode(reply[i], telemetry) && (telemetry.type == ARDUINO_TELEMETRY) && (telemetry.length >= ARDUINO_TELEMETRY_PAYLOAD))
+        received = true;
+    }
+
+    if (received)
+    {
+
+      telemetry_msg.header.stamp = request_time;
+      telemetry_msg.battery_voltage = getUint16(telemetry.payload) / 1000.0;
+      telemetry_msg.esc_pulsewidth = getUint16(telemetry.payload + 2);
+      telemetry_msg.steering_pulsewidth = getUint16(telemetry.payload + 4);
+      telemetry_msg.loop_overruns = getUint16(telemetry.payload + 6);
+      telemetry_msg.sequence = telemetry.payload[8];
+      telemetry_msg.round_trip_latency = latency;
+      telemetry_pub.publish(telemetry_msg);
+
+      //publish armed status once arduino first answers
+      if (telemetry_received == 0)
+      {
+        ROS_INFO("[arduino_output_node] arduino ready");
+        armed_msg.header.stamp = ros::Time::now();
+        armed_msg.armed = true;
+        armed_pub.publish(armed_msg);
+      }
+
+      telemetry_received++;
+      latency_sum += latency;
+      latency_max = std::max(latency_max, latency);
+
+    }
+    else
+      telemetry_missed++;
 
     //process callback function calls
     ros::spinOnce();
@@ -126,5 +297,10 @@ int main(int argc, char **argv)
     loop_rate.sleep();
   }
 
+  ROS_INFO("[arduino_output_node] commands sent: %lu, telemetry received: %lu, missed: %lu (%u CRC errors)", frames_sent, telemetry_received,
+    telemetry_missed, decoder.getCrcErrors());
+  if (telemetry_received > 0)
+    ROS_INFO("[arduino_output_node] round-trip latency: mean %.3f ms, max %.3f ms", 1000 * latency_sum / telemetry_received, 1000 * latency_max);
+
   return 0;
 }
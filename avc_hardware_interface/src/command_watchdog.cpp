@@ -0,0 +1,112 @@
+//include header
+#include <command_watchdog.hpp>
+
+#include <algorithm>
+
+
+//move value towards target by at most step
+static float rampTowards(float value, float target, float step)
+{
+
+  if (value > target)
+    return std::max(value - step, target);
+
+  return std::min(value + step, target);
+
+}
+
+
+//constructors and destructors
+
+//default constructor
+CommandWatchdog::CommandWatchdog(const std::string& node_name, const std::string& channel_name)
+{
+
+  this->_node_name = node_name;
+  this->_channel_name = channel_name;
+  this->_timeout = 0.25;
+
+  //commands start out stale until the first fresh one arrives
+  this->_stale = true;
+  this->_value = 0;
+
+}
+
+//get functions
+
+ros::Time CommandWatchdog::getStamp() const
+{
+  return this->_stamp;
+}
+
+float CommandWatchdog::getValue() const
+{
+  return this->_value;
+}
+
+bool CommandWatchdog::isStale() const
+{
+  return this->_stale;
+}
+
+//set functions
+
+void CommandWatchdog::setTimeout(float timeout)
+{
+  this->_timeout = timeout;
+}
+
+void CommandWatchdog::setValue(float value)
+{
+  this->_value = value;
+}
+
+//other functions
+
+//returns value to output, ramping to neutral once the command is stale and logging when the failsafe engages and completes
+float CommandWatchdog::output(float value, float last_output, float ramp_step, const std::chrono::steady_clock::time_point& now)
+{
+
+  float age = std::chrono::duration<float>(now - this->_received).count();
+  if (age <= this->_timeout)
+  {
+
+    if (this->_stale)
+      ROS_INFO("[%s] fresh %s commands received, failsafe released", this->_node_name.c_str(), this->_channel_name.c_str());
+    this->_stale = false;
+
+    return value;
+
+  }
+
+  //reaction time is time from when the command became stale until the failsafe engaged
+  bool engaged = !this->_stale;
+  if (engaged)
+  {
+    ROS_WARN("[%s] no fresh %s command for %.3f s, ramping to neutral (reaction time %.1f ms)", this->_node_name.c_str(),
+      this->_channel_name.c_str(), age, 1000 * (age - this->_timeout));
+    this->_stale = true;
+  }
+
+  float output = rampTowards(last_output, 0, ramp_step);
+  if ((output == 0) && ((last_output != 0) || engaged))
+    ROS_WARN("[%s] %s at neutral %.3f s after last fresh command", this->_node_name.c_str(), this->_channel_name.c_str(), age);
+
+  return output;
+
+}
+
+//store received command value, and restart its deadline if the command is fresh
+//repeated stamps, as from a node republishing a stale command, don't restart the deadline
+void CommandWatchdog::receive(float value, const ros::Time& stamp)
+{
+
+  this->_value = value;
+
+  if ((stamp > this->_stamp) && ((ros::Time::now() - stamp).toSec() <= this->_timeout))
+  {
+    this->_stamp = stamp;
+    this->_received = std::chrono::steady_clock::now();
+  }
+
+}
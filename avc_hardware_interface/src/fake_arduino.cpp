@@ -0,0 +1,206 @@
+//fake Arduino
+//stands in for the Arduino Nano on a pseudo terminal, so arduino_output_node (device parameter pointed at the link) and the arduino PWM
+//output can be tested without hardware; frames are accepted by the same rules as on the Arduino (valid CRC, newer sequence number), the
+//output returns to neutral when no valid frame arrives within the failsafe time, and received bytes can be corrupted at a given rate
+//every valid frame is answered with telemetry of the applied pulsewidths and a battery voltage sagging with throttle
+//usage: rosrun avc_hardware_interface fake_arduino [link_path] [corrupt_rate] [failsafe_time]
+#include <chrono>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arduino_link.hpp>
+#include <avc_sensors/pseudo_terminal.hpp>
+
+//neutral pulsewidth and pulsewidth ranges of applied commands, approximating the car [us]
+const int NEUTRAL_PULSEWIDTH = 1350;
+const int ESC_FORWARD_RANGE = 650;
+const int ESC_REVERSE_RANGE = 350;
+const int STEERING_RANGE = 400; //at 30 deg
+
+//battery voltage at rest [V] and voltage sag at full throttle [V]
+const double BATTERY_VOLTAGE = 7.6;
+const double BATTERY_SAG = 1.2;
+
+//global variables
+volatile sig_atomic_t running = 1;
+
+
+//signal handler called to stop emulation
+void signalHandler(int sig)
+{
+  running = 0;
+}
+
+int main(int argc, char **argv)
+{
+
+  if (argc > 4)
+  {
+    fprintf(stderr, "usage: fake_arduino [link_path] [corrupt_rate] [failsafe_time]\n");
+    return 1;
+  }
+
+  //get symbolic link to create for pseudo terminal, probability of corrupting each received bit, and failsafe time [s]
+  const char *link_path = (argc >= 2) ? argv[1] : "/tmp/fake_arduino";
+  double corrupt_rate = (argc >= 3) ? atof(argv[2]) : 0;
+  double failsafe_time = (argc >= 4) ? atof(argv[3]) : 0.25;
+
+  PseudoTerminal terminal;
+  if (!terminal.open(link_path))
+  {
+    fprintf(stderr, "failed to create pseudo terminal linked to %s\n", link_path);
+    return 1;
+  }
+  int master = terminal.getFileDescriptor();
+
+  signal(SIGINT, signalHandler);
+  signal(SIGTERM, signalHandler);
+
+  printf("fake Arduino on %s (%s), corrupting %.4f of received bits, failsafe after %.2f s\n", link_path, terminal.getSlaveName().c_str(),
+    corrupt_rate, failsafe_time);
+
+  ArduinoFrameDecoder decoder;
+  ArduinoFrame frame;
+  bool has_sequence = false;
+  uint8_t last_sequence = 0;
+  bool failsafe = true;
+  uint8_t last_type = 0;
+  int last_values[2] = { 0, 0 };
+  unsigned long applied = 0;
+  unsigned long stale = 0;
+  unsigned long failsafes = 0;
+  unsigned long telemetry_errors = 0;
+  int pulsewidths[2] = { NEUTRAL_PULSEWIDTH, NEUTRAL_PULSEWIDTH }; //applied ESC and steering servo pulsewidths [us]
+  std::chrono::steady_clock::time_point last_frame = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point last_report = last_frame;
+
+  while (running)
+  {
+
+    //wait for bytes, waking up regularly to check failsafe time
+    struct pollfd fds = { master, POLLIN, 0 };
+    uint8_t buffer[256];
+    ssize_t count = 0;
+    if ((poll(&fds, 1, 10) > 0) && (fds.revents & POLLIN))
+      count = read(master, buffer, sizeof(buffer));
+    if ((count < 0) && (errno != EAGAIN) && (errno != EIO))
+      break;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (ssize_t i = 0; i < count; i++)
+    {
+
+      //corrupt received bits like a noisy bus would
+      for (int bit = 0; bit < 8; bit++)
+      {
+        if (drand48() < corrupt_rate)
+          buffer[i] ^= 1 << bit;
+      }
+
+      if (!decoder.decode(buffer[i], frame))
+        continue;
+
+      //only newer command frames are applied, repeated and reordered frames are dropped
+      bool command = (frame.type == ARDUINO_COMMAND) || (frame.type == ARDUINO_PULSEWIDTHS);
+      if (command && has_sequence && !isNewerSequence(frame.sequence, last_sequence))
+      {
+        stale++;
+        command = false;
+      }
+
+      if (command)
+      {
+
+        has_sequence = true;
+        last_sequence = frame.sequence;
+        last_frame = now;
+        applied++;
+
+        //apply command
+        if (frame.type == ARDUINO_COMMAND)
+        {
+          double throttle_percent = getInt16(frame.payload) / 100.0;
+          double steering_angle = getInt16(frame.payload + 2) / 100.0;
+          pulsewidths[0] = NEUTRAL_PULSEWIDTH + throttle_percent / 100 * ((throttle_percent >= 0) ? ESC_FORWARD_RANGE : ESC_REVERSE_RANGE);
+          pulsewidths[1] = NEUTRAL_PULSEWIDTH - steering_angle / 30 * STEERING_RANGE;
+        }
+        else
+        {
+          pulsewidths[0] = getUint16(frame.payload);
+          pulsewidths[1] = getUint16(frame.payload + 2);
+        }
+
+        if (failsafe)
+        {
+          printf("output enabled\n");
+          failsafe = false;
+          last_type = 0;
+        }
+
+        //print output whenever it changes (keepalive frames repeat it)
+        int values[2] = { getInt16(frame.payload), getInt16(frame.payload + 2) };
+        if ((frame.type != last_type) || (values[0] != last_values[0]) || (values[1] != last_values[1]))
+        {
+
+          last_type = frame.type;
+          last_values[0] = values[0];
+          last_values[1] = values[1];
+
+          if (frame.type == ARDUINO_COMMAND)
+            printf("command %u: throttle %7.2f %%, steering %7.2f deg\n", frame.sequence, values[0] / 100.0, values[1] / 100.0);
+          else
+            printf("pulsewidths %u: ESC %u us, steering servo %u us\n", frame.sequence, getUint16(frame.payload), getUint16(frame.payload + 2));
+
+        }
+
+      }
+
+      //answer every valid frame with telemetry of the output now applied
+      uint8_t payload[ARDUINO_TELEMETRY_PAYLOAD];
+      double throttle = (pulsewidths[0] >= NEUTRAL_PULSEWIDTH) ? (pulsewidths[0] - NEUTRAL_PULSEWIDTH) / (double)ESC_FORWARD_RANGE :
+        (NEUTRAL_PULSEWIDTH - pulsewidths[0]) / (double)ESC_REVERSE_RANGE;
+      putUint16(payload, 1000 * (BATTERY_VOLTAGE - BATTERY_SAG * throttle));
+      putUint16(payload + 2, pulsewidths[0]);
+      putUint16(payload + 4, pulsewidths[1]);
+      putUint16(payload + 6, 0);
+      payload[8] = last_sequence;
+      uint8_t reply[ARDUINO_MAX_FRAME];
+      size_t reply_size = encodeArduinoFrame(ARDUINO_TELEMETRY, frame.sequence, payload, sizeof(payload), reply);
+      if (write(master, reply, reply_size) != (ssize_t)reply_size)
+        telemetry_errors++;
+
+    }
+
+    //return to neutral when commands stop
+    if (!failsafe && (std::chrono::duration<double>(now - last_frame).count() > failsafe_time))
+    {
+      printf("no valid frame for %.2f s, output set to neutral\n", failsafe_time);
+      failsafe = true;
+      failsafes++;
+      pulsewidths[0] = NEUTRAL_PULSEWIDTH;
+      pulsewidths[1] = NEUTRAL_PULSEWIDTH;
+
+      //a restarted sender starts over with its sequence numbers
+      has_sequence = false;
+    }
+
+    //report frame statistics every second
+    if (now - last_report >= std::chrono::seconds(1))
+    {
+      printf("frames applied: %lu, CRC errors: %u, stale: %lu, failsafes: %lu, telemetry write errors: %lu\n", applied, decoder.getCrcErrors(),
+        stale, failsafes, telemetry_errors);
+      last_report = now;
+    }
+
+    fflush(stdout);
+
+  }
+
+  printf("frames applied: %lu, CRC errors: %u, stale: %lu, failsafes: %lu, telemetry write errors: %lu\n", applied, decoder.getCrcErrors(),
+    stale, failsafes, telemetry_errors);
+
+  return 0;
+}
@@ -0,0 +1,72 @@
+//include header
+#include <latency_histogram.hpp>
+
+
+//constructors and destructors
+
+//default constructor
+LatencyHistogram::LatencyHistogram()
+{
+  this->reset();
+}
+
+//get functions
+
+uint64_t LatencyHistogram::getCount() const
+{
+  return this->_count.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getCount(int bucket) const
+{
+  return this->_buckets[bucket].load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::getMax() const
+{
+  return this->_max.load(std::memory_order_relaxed) / 1e6;
+}
+
+double LatencyHistogram::getMean() const
+{
+
+  uint64_t count = this->_count.load(std::memory_order_relaxed);
+  if (count == 0)
+    return 0;
+
+  return this->_sum.load(std::memory_order_relaxed) / 1e6 / count;
+
+}
+
+//other functions
+
+//add latency to its bucket (index of highest set bit of latency in microseconds)
+void LatencyHistogram::record(double latency)
+{
+
+  uint64_t microseconds = (latency > 0) ? (uint64_t)(latency * 1e6) : 0;
+
+  int bucket = (microseconds > 1) ? 63 - __builtin_clzll(microseconds) : 0;
+  if (bucket >= BUCKETS)
+    bucket = BUCKETS - 1;
+
+  this->_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  this->_count.fetch_add(1, std::memory_order_relaxed);
+  this->_sum.fetch_add(microseconds, std::memory_order_relaxed);
+
+  uint64_t max = this->_max.load(std::memory_order_relaxed);
+  while ((microseconds > max) && !this->_max.compare_exchange_weak(max, microseconds, std::memory_order_relaxed));
+
+}
+
+//clear all counters
+void LatencyHistogram::reset()
+{
+
+  for (int bucket = 0; bucket < BUCKETS; bucket++)
+    this->_buckets[bucket].store(0, std::memory_order_relaxed);
+  this->_count.store(0, std::memory_order_relaxed);
+  this->_max.store(0, std::memory_order_relaxed);
+  this->_sum.store(0, std::memory_order_relaxed);
+
+}
@@ -0,0 +1,146 @@
+//include header
+#include <output_shaper.hpp>
+
+#include <algorithm>
+#include <math.h>
+
+
+//constructors and destructors
+
+//default constructor
+OutputShaper::OutputShaper(const ShapingLimits& limits, float max_interpolation_time)
+{
+  this->_limits = limits;
+  this->_max_interpolation_time = max_interpolation_time;
+  this->reset(0);
+}
+
+//get functions
+
+float OutputShaper::getOutput() const
+{
+  return this->_output;
+}
+
+float OutputShaper::getRate() const
+{
+  return this->_rate;
+}
+
+//set functions
+
+//start interpolating from the command now reached to the new command over the interval since the previous one
+void OutputShaper::setCommand(float command, double time)
+{
+
+  if (this->_has_command)
+  {
+    this->_interpolation_start = this->interpolatedCommand(time);
+    this->_interpolation_duration = std::min((float)(time - this->_command_time), this->_max_interpolation_time);
+  }
+  else
+  {
+    this->_interpolation_start = command;
+    this->_interpolation_duration = 0;
+  }
+
+  this->_command = command;
+  this->_command_time = time;
+  this->_has_command = true;
+
+}
+
+//other functions
+
+//jump to output at rest, forgetting previous commands
+void OutputShaper::reset(float output)
+{
+
+  this->_command = output;
+  this->_command_time = 0;
+  this->_has_command = false;
+  this->_interpolation_duration = 0;
+  this->_interpolation_start = output;
+
+  this->_output = output;
+  this->_rate = 0;
+  this->_time = 0;
+  this->_has_time = false;
+
+}
+
+//advance output to time towards interpolated command within rate and rate change limits
+float OutputShaper::update(double time)
+{
+
+  float dt = this->_has_time ? (float)(time - this->_time) : 0;
+  this->_time = time;
+  this->_has_time = true;
+
+  float error = this->interpolatedCommand(time) - this->_output;
+  if (error == 0)
+  {
+    this->_rate = 0;
+    return this->_output;
+  }
+
+  //without limits the output follows the command
+  if ((this->_limits.max_rate_away <= 0) && (this->_limits.max_rate_towards <= 0) && (this->_limits.max_rate_change <= 0))
+  {
+    this->_output += error;
+    this->_rate = (dt > 0) ? error / dt : 0;
+    return this->_output;
+  }
+
+  if (dt <= 0)
+    return this->_output;
+
+  //rate reaching command in this step, limited to rate away from or towards neutral
+  float rate = error / dt;
+  bool away = (this->_output == 0) || ((error > 0) == (this->_output > 0));
+  float max_rate = away ? this->_limits.max_rate_away : this->_limits.max_rate_towards;
+  if (max_rate > 0)
+    rate = std::min(std::max(rate, -max_rate), max_rate);
+
+  //with a rate change limit, only use a rate the output can still be stopped from at the command, and change rate gradually
+  float max_change = this->_limits.max_rate_change;
+  if (max_change > 0)
+  {
+
+    //highest rate that can be reduced to zero by max_change * dt every step before reaching the command
+    float step = max_change * dt;
+    float stopping_rate = step * (sqrtf(0.25 + 2 * fabsf(error) / (step * dt)) - 0.5);
+    rate = std::min(std::max(rate, -stopping_rate), stopping_rate);
+    rate = std::min(std::max(rate, this->_rate - max_change * dt), this->_rate + max_change * dt);
+
+  }
+
+  //stop at command instead of overshooting it (the rate change limit is relaxed when the command moves closer than the stopping distance)
+  float output = this->_output + rate * dt;
+  if ((error > 0) ? (output >= this->_output + error) : (output <= this->_output + error))
+  {
+    output = this->_output + error;
+    rate = error / dt;
+  }
+
+  this->_output = output;
+  this->_rate = rate;
+
+  return this->_output;
+
+}
+
+//command at time, linearly interpolated from start command
+float OutputShaper::interpolatedCommand(double time) const
+{
+
+  if (this->_interpolation_duration <= 0)
+    return this->_command;
+
+  float fraction = (time - this->_command_time) / this->_interpolation_duration;
+  if (fraction >= 1)
+    return this->_command;
+
+  return this->_interpolation_start + fraction * (this->_command - this->_interpolation_start);
+
+}
@@ -0,0 +1,388 @@
+//include header
+#include <pwm_output.hpp>
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//pigpio daemon servo pulsewidth command (pigpio.h PI_CMD_SERVO)
+const uint32_t PIGPIO_CMD_SERVO = 8;
+
+
+//write all bytes of buffer, returns false on error
+static bool writeAll(int fd, const void *buffer, size_t size)
+{
+
+  const char *data = (const char*)buffer;
+  while (size > 0)
+  {
+    ssize_t count = ::write(fd, data, size);
+    if (count <= 0)
+      return false;
+    data += count;
+    size -= count;
+  }
+
+  return true;
+
+}
+
+//read exactly size bytes into buffer, returns false on error or end of stream
+static bool readAll(int fd, void *buffer, size_t size)
+{
+
+  char *data = (char*)buffer;
+  while (size > 0)
+  {
+    ssize_t count = ::read(fd, data, size);
+    if (count <= 0)
+      return false;
+    data += count;
+    size -= count;
+  }
+
+  return true;
+
+}
+
+
+//servoblaster driver output
+
+//default constructor
+ServoblasterOutput::ServoblasterOutput(const std::string& device_path, const int *servo_numbers)
+{
+
+  this->_device = -1;
+  this->_device_path = device_path;
+
+  //format command line of every pulsewidth step of every channel
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+  {
+    for (int i = 0; i < STEPS; i++)
+      this->_lengths[channel][i] = snprintf(this->_lines[channel][i], LINE_SIZE, "%d=%d\n", servo_numbers[channel], MIN_STEP + i);
+  }
+
+}
+
+//default destructor
+ServoblasterOutput::~ServoblasterOutput()
+{
+  if (this->_device != -1)
+    close(this->_device);
+}
+
+//other functions
+
+//open servoblaster driver
+bool ServoblasterOutput::init()
+{
+
+  this->_device = open(this->_device_path.c_str(), O_WRONLY);
+  return this->_device != -1;
+
+}
+
+//write command lines of all channels at once, pulsewidths outside of table are clamped to its range
+bool ServoblasterOutput::write(const int *pulsewidths)
+{
+
+  char command[PWM_CHANNELS * LINE_SIZE];
+  int length = 0;
+
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+  {
+
+    int step = pulsewidths[channel] / 10;
+    if (step < MIN_STEP)
+      step = MIN_STEP;
+    else if (step > MAX_STEP)
+      step = MAX_STEP;
+
+    int index = step - MIN_STEP;
+    memcpy(command + length, this->_lines[channel][index], this->_lengths[channel][index]);
+    length += this->_lengths[channel][index];
+
+  }
+
+  return ::write(this->_device, command, length) == length;
+
+}
+
+
+//Linux sysfs PWM output
+
+//default constructor
+SysfsPwmOutput::SysfsPwmOutput(const std::string& chip_path, const int *pwm_channels, int period)
+{
+
+  this->_chip_path = chip_path;
+  this->_period = period;
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+  {
+    this->_duty_cycles[channel] = -1;
+    this->_pwm_channels[channel] = pwm_channels[channel];
+  }
+
+}
+
+//default destructor
+SysfsPwmOutput::~SysfsPwmOutput()
+{
+
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+  {
+    if (this->_duty_cycles[channel] != -1)
+      close(this->_duty_cycles[channel]);
+  }
+
+}
+
+//other functions
+
+//export, configure, and enable channels and open their duty_cycle files
+bool SysfsPwmOutput::init()
+{
+
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+  {
+
+    std::string pwm_path = this->_chip_path + "/pwm" + std::to_string(this->_pwm_channels[channel]);
+
+    //export channel unless it has already been exported
+    if ((access(pwm_path.c_str(), F_OK) != 0) && !this->writeAttribute(this->_chip_path + "/export", this->_pwm_channels[channel]))
+      return false;
+
+    //duty cycle is set before period is, so it never exceeds a shorter period than before
+    if (!this->writeAttribute(pwm_path + "/duty_cycle", 0) || !this->writeAttribute(pwm_path + "/period", this->_period * 1000) ||
+      !this->writeAttribute(pwm_path + "/enable", 1))
+      return false;
+
+    this->_duty_cycles[channel] = open((pwm_path + "/duty_cycle").c_str(), O_WRONLY);
+    if (this->_duty_cycles[channel] == -1)
+      return false;
+
+  }
+
+  return true;
+
+}
+
+//write duty cycle of every channel [ns]
+bool SysfsPwmOutput::write(const int *pulsewidths)
+{
+
+  bool success = true;
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+  {
+    char value[16];
+    int length = snprintf(value, sizeof(value), "%d\n", pulsewidths[channel] * 1000);
+    success &= pwrite(this->_duty_cycles[channel], value, length, 0) == length;
+  }
+
+  return success;
+
+}
+
+//write integer to sysfs attribute
+bool SysfsPwmOutput::writeAttribute(const std::string& path, int value)
+{
+
+  int fd = open(path.c_str(), O_WRONLY);
+  if (fd == -1)
+    return false;
+
+  char text[16];
+  int length = snprintf(text, sizeof(text), "%d\n", value);
+  bool success = ::write(fd, text, length) == length;
+  close(fd);
+
+  return success;
+
+}
+
+
+//pigpio daemon output
+
+//default constructor
+PigpioOutput::PigpioOutput(const std::string& host, int port, const int *gpios)
+{
+
+  this->_host = host;
+  this->_port = port;
+  this->_socket = -1;
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+    this->_gpios[channel] = gpios[channel];
+
+}
+
+//default destructor
+PigpioOutput::~PigpioOutput()
+{
+  if (this->_socket != -1)
+    close(this->_socket);
+}
+
+//other functions
+
+//connect to pigpio daemon
+bool PigpioOutput::init()
+{
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  struct addrinfo *addresses;
+  if (getaddrinfo(this->_host.c_str(), std::to_string(this->_port).c_str(), &hints, &addresses) != 0)
+    return false;
+
+  for (struct addrinfo *address = addresses; address != NULL; address = address->ai_next)
+  {
+
+    this->_socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (this->_socket == -1)
+      continue;
+    if (connect(this->_socket, address->ai_addr, address->ai_addrlen) == 0)
+      break;
+
+    close(this->_socket);
+    this->_socket = -1;
+
+  }
+  freeaddrinfo(addresses);
+
+  if (this->_socket == -1)
+    return false;
+
+  //send small command packets immediately instead of coalescing them
+  int no_delay = 1;
+  setsockopt(this->_socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+  return true;
+
+}
+
+//send servo commands of all channels in one packet and check their results
+bool PigpioOutput::write(const int *pulsewidths)
+{
+
+  //command: command, gpio, pulsewidth, unused; reply: command, gpio, pulsewidth, result
+  uint32_t commands[PWM_CHANNELS][4];
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+  {
+    commands[channel][0] = PIGPIO_CMD_SERVO;
+    commands[channel][1] = this->_gpios[channel];
+    commands[channel][2] = pulsewidths[channel];
+    commands[channel][3] = 0;
+  }
+
+  if (!writeAll(this->_socket, commands, sizeof(commands)) || !readAll(this->_socket, commands, sizeof(commands)))
+    return false;
+
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+  {
+    if ((int32_t)commands[channel][3] < 0)
+      return false;
+  }
+
+  return true;
+
+}
+
+
+//Arduino output over I2C
+
+//default constructor
+ArduinoI2COutput::ArduinoI2COutput(const std::string& device_path, int address)
+{
+  this->_address = address;
+  this->_device_path = device_path;
+  this->_sequence = 0;
+}
+
+//other functions
+
+//open link to Arduino
+bool ArduinoI2COutput::init()
+{
+  return this->_link.open(this->_device_path, this->_address);
+}
+
+//send pulsewidths of all channels in one frame
+bool ArduinoI2COutput::write(const int *pulsewidths)
+{
+
+  uint8_t payload[2 * PWM_CHANNELS];
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+    putUint16(payload + 2 * channel, pulsewidths[channel]);
+
+  uint8_t frame[ARDUINO_MAX_FRAME];
+  size_t size = encodeArduinoFrame(ARDUINO_PULSEWIDTHS, ++this->_sequence, payload, sizeof(payload), frame);
+
+  return this->_link.write(frame, size);
+
+}
+
+
+//simulated output
+
+//default constructor
+SimulatedOutput::SimulatedOutput(size_t capacity)
+{
+  this->_capacity = capacity;
+  this->_writes = 0;
+  this->_samples.reserve(capacity);
+}
+
+//get functions
+
+const std::vector<SimulatedOutput::Sample>& SimulatedOutput::getSamples() const
+{
+  return this->_samples;
+}
+
+unsigned long SimulatedOutput::getWrites() const
+{
+  return this->_writes;
+}
+
+//other functions
+
+//forget recorded samples
+void SimulatedOutput::clear()
+{
+  this->_samples.clear();
+  this->_writes = 0;
+}
+
+//nothing to open
+bool SimulatedOutput::init()
+{
+  return true;
+}
+
+//record pulsewidths of all channels with write time
+bool SimulatedOutput::write(const int *pulsewidths)
+{
+
+  this->_writes++;
+  if (this->_samples.size() == this->_capacity)
+    return true;
+
+  Sample sample;
+  sample.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+    sample.pulsewidths[channel] = pulsewidths[channel];
+  this->_samples.push_back(sample);
+
+  return true;
+
+}
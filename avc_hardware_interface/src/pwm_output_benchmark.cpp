@@ -0,0 +1,288 @@
+//PWM output benchmark
+//measures write latency of the PWM output backends and checks that every pulsewidth written arrives unchanged, using stand-ins for the
+//devices (a FIFO read like servod reads /dev/servoblaster, a sysfs PWM tree in a temporary directory, and a local pigpiod emulator),
+//so backends can be compared and verified without a Raspberry Pi
+//usage: rosrun avc_hardware_interface pwm_output_benchmark [writes]
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <pwm_output.hpp>
+
+//stand-in device locations
+const char *SB_FIFO_PATH = "/tmp/pwm_benchmark_servoblaster";
+const char *SYSFS_CHIP_PATH = "/tmp/pwm_benchmark_pwmchip0";
+const int PIGPIO_PORT = 18888;
+
+//channel mapping given to backends
+const int SERVO_NUMBERS[PWM_CHANNELS] = { 1, 0 };
+const int PWM_NUMBERS[PWM_CHANNELS] = { 0, 1 };
+
+
+//pulsewidths of write i, sweeping both channels through the servo range in steps of 10 us [us]
+void getPulsewidths(int i, int *pulsewidths)
+{
+  pulsewidths[PWM_ESC] = 1000 + 10 * (i % 101);
+  pulsewidths[PWM_STEERING] = 2000 - 10 * (i % 101);
+}
+
+//write sweep to output and print latency statistics, returns false if a write fails
+bool benchmark(const char *name, PwmOutput& output, int writes)
+{
+
+  std::vector<double> latencies;
+  latencies.reserve(writes);
+
+  int pulsewidths[PWM_CHANNELS];
+  for (int i = 0; i < writes; i++)
+  {
+
+    getPulsewidths(i, pulsewidths);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (!output.write(pulsewidths))
+    {
+      printf("%-14s write %d failed\n", name, i);
+      return false;
+    }
+    latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  double sum = 0;
+  for (size_t i = 0; i < latencies.size(); i++)
+    sum += latencies[i];
+  printf("%-14s write latency: mean %7.2f us, median %7.2f us, 99th percentile %7.2f us, max %8.2f us\n", name, sum / writes,
+    latencies[writes / 2], latencies[writes * 99 / 100], latencies.back());
+
+  return true;
+
+}
+
+//print whether every written pulsewidth was received
+void printCheck(const char *name, int mismatches, int expected, int received)
+{
+  printf("%-14s received %d of %d writes, %d mismatched\n", name, received, expected, mismatches);
+}
+
+//servoblaster daemon stand-in: read command lines from FIFO and compare them to the sweep
+void servoblasterReader(int *mismatches, int *received)
+{
+
+  FILE *fifo = fopen(SB_FIFO_PATH, "r");
+  if (fifo == NULL)
+    return;
+
+  int servo;
+  int step;
+  int lines = 0;
+  int pulsewidths[PWM_CHANNELS];
+  while (fscanf(fifo, "%d=%d\n", &servo, &step) == 2)
+  {
+    int channel = lines % PWM_CHANNELS;
+    getPulsewidths(lines / PWM_CHANNELS, pulsewidths);
+    if ((servo != SERVO_NUMBERS[channel]) || (step != pulsewidths[channel] / 10))
+      (*mismatches)++;
+    lines++;
+  }
+  *received = lines / PWM_CHANNELS;
+
+  fclose(fifo);
+
+}
+
+//pigpio daemon stand-in: answer servo commands on local port and compare them to the sweep
+void pigpioServer(int listener, int *mismatches, int *received)
+{
+
+  int connection = accept(listener, NULL, NULL);
+  if (connection == -1)
+    return;
+
+  //reply to each command immediately like pigpiod
+  int no_delay = 1;
+  setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+  uint32_t command[4];
+  int commands = 0;
+  int pulsewidths[PWM_CHANNELS];
+  while (recv(connection, command, sizeof(command), MSG_WAITALL) == sizeof(command))
+  {
+    int channel = commands % PWM_CHANNELS;
+    getPulsewidths(commands / PWM_CHANNELS, pulsewidths);
+    if ((command[0] != 8) || ((int)command[1] != PWM_NUMBERS[channel]) || ((int)command[2] != pulsewidths[channel]))
+      (*mismatches)++;
+    command[3] = 0;
+    send(connection, command, sizeof(command), 0);
+    commands++;
+  }
+  *received = commands / PWM_CHANNELS;
+
+  close(connection);
+
+}
+
+//create sysfs PWM chip stand-in with already exported channels
+bool createSysfsChip()
+{
+
+  mkdir(SYSFS_CHIP_PATH, 0755);
+  for (int channel = 0; channel < PWM_CHANNELS; channel++)
+  {
+    std::string pwm_path = std::string(SYSFS_CHIP_PATH) + "/pwm" + std::to_string(PWM_NUMBERS[channel]);
+    mkdir(pwm_path.c_str(), 0755);
+    const char *attributes[] = { "/duty_cycle", "/enable", "/period" };
+    for (int i = 0; i < 3; i++)
+    {
+      int fd = open((pwm_path + attributes[i]).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd == -1)
+        return false;
+      close(fd);
+    }
+  }
+
+  return true;
+
+}
+
+//read duty cycle of sysfs PWM channel stand-in [ns]
+int readDutyCycle(int channel)
+{
+
+  std::string path = std::string(SYSFS_CHIP_PATH) + "/pwm" + std::to_string(PWM_NUMBERS[channel]) + "/duty_cycle";
+  FILE *file = fopen(path.c_str(), "r");
+  int duty_cycle = -1;
+  if (file != NULL)
+  {
+    if (fscanf(file, "%d", &duty_cycle) != 1)
+      duty_cycle = -1;
+    fclose(file);
+  }
+
+  return duty_cycle;
+
+}
+
+int main(int argc, char **argv)
+{
+
+  int writes = (argc >= 2) ? atoi(argv[1]) : 10000;
+  if (writes <= 0)
+  {
+    fprintf(stderr, "usage: pwm_output_benchmark [writes]\n");
+    return 1;
+  }
+
+  printf("writing %d pulsewidth pairs to every backend\n\n", writes);
+
+  //simulated output, recorded samples are compared to the sweep
+  {
+    SimulatedOutput output(writes);
+    output.init();
+    if (benchmark("simulated", output, writes))
+    {
+      int mismatches = 0;
+      int pulsewidths[PWM_CHANNELS];
+      const std::vector<SimulatedOutput::Sample>& samples = output.getSamples();
+      for (size_t i = 0; i < samples.size(); i++)
+      {
+        getPulsewidths(i, pulsewidths);
+        if ((samples[i].pulsewidths[PWM_ESC] != pulsewidths[PWM_ESC]) || (samples[i].pulsewidths[PWM_STEERING] != pulsewidths[PWM_STEERING]) ||
+          ((i > 0) && (samples[i].timestamp < samples[i - 1].timestamp)))
+          mismatches++;
+      }
+      printCheck("simulated", mismatches, writes, samples.size());
+    }
+  }
+
+  //servoblaster output into FIFO, opening it blocks until the reader has opened it as well
+  {
+    unlink(SB_FIFO_PATH);
+    if (mkfifo(SB_FIFO_PATH, 0600) != 0)
+      printf("servoblaster   failed to create FIFO %s\n", SB_FIFO_PATH);
+    else
+    {
+      int mismatches = 0;
+      int received = 0;
+      std::thread reader(servoblasterReader, &mismatches, &received);
+      {
+        ServoblasterOutput output(SB_FIFO_PATH, SERVO_NUMBERS);
+        if (output.init())
+          benchmark("servoblaster", output, writes);
+      }
+      reader.join();
+      printCheck("servoblaster", mismatches, writes, received);
+      unlink(SB_FIFO_PATH);
+    }
+  }
+
+  //sysfs PWM output into regular files, only the final duty cycles can be checked
+  if (!createSysfsChip())
+    printf("sysfs          failed to create stand-in %s\n", SYSFS_CHIP_PATH);
+  else
+  {
+    SysfsPwmOutput output(SYSFS_CHIP_PATH, PWM_NUMBERS, 20000);
+    if (!output.init())
+      printf("sysfs          failed to initialize\n");
+    else if (benchmark("sysfs", output, writes))
+    {
+      int pulsewidths[PWM_CHANNELS];
+      getPulsewidths(writes - 1, pulsewidths);
+      int mismatches = 0;
+      for (int channel = 0; channel < PWM_CHANNELS; channel++)
+      {
+        if (readDutyCycle(channel) != pulsewidths[channel] * 1000)
+          mismatches++;
+      }
+      printf("%-14s final duty cycles %s\n", "sysfs", (mismatches == 0) ? "match" : "don't match");
+    }
+  }
+
+  //pigpio output to local daemon stand-in
+  {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(PIGPIO_PORT);
+    if ((bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0) || (listen(listener, 1) != 0))
+      printf("pigpio         failed to listen on port %d\n", PIGPIO_PORT);
+    else
+    {
+      int mismatches = 0;
+      int received = 0;
+      std::thread server(pigpioServer, listener, &mismatches, &received);
+      {
+        PigpioOutput output("127.0.0.1", PIGPIO_PORT, PWM_NUMBERS);
+        if (output.init())
+          benchmark("pigpio", output, writes);
+        else
+          shutdown(listener, SHUT_RDWR);
+      }
+      server.join();
+      printCheck("pigpio", mismatches, writes, received);
+    }
+    close(listener);
+  }
+
+  //Arduino output needs an I2C bus (the i2c-stub kernel module provides one without an Arduino)
+  printf("%-14s not benchmarked, needs an I2C bus\n", "arduino");
+
+  return 0;
+}
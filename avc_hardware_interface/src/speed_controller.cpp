@@ -0,0 +1,237 @@
+//include header
+#include <speed_controller.hpp>
+
+#include <algorithm>
+#include <config_parsing.hpp>
+#include <fstream>
+#include <math.h>
+#include <sstream>
+
+
+//throttle map
+
+//default constructor
+ThrottleMap::ThrottleMap(float max_speed, int bins, float initial_gain, float learning_rate)
+{
+
+  this->_bin_width = max_speed / (std::max(bins, 2) - 1);
+  this->_learning_rate = learning_rate;
+  this->_samples.assign(std::max(bins, 2), 0);
+
+  //start with throttle proportional to speed
+  for (size_t i = 0; i < this->_samples.size(); i++)
+    this->_throttles.push_back(initial_gain * i * this->_bin_width);
+
+}
+
+//get functions
+
+//interpolate throttle between bins around speed, extrapolating from the last two bins above max speed
+float ThrottleMap::getThrottle(float speed) const
+{
+
+  float position = std::max(speed, 0.0f) / this->_bin_width;
+  size_t bin = std::min((size_t)position, this->_throttles.size() - 2);
+  float fraction = position - bin;
+
+  return this->_throttles[bin] + fraction * (this->_throttles[bin + 1] - this->_throttles[bin]);
+
+}
+
+unsigned long ThrottleMap::getSamples() const
+{
+
+  unsigned long samples = 0;
+  for (size_t i = 0; i < this->_samples.size(); i++)
+    samples += this->_samples[i];
+
+  return samples;
+
+}
+
+//other functions
+
+//pull both bins around speed towards throttle, weighted by how close speed is to each of them
+void ThrottleMap::learn(float speed, float throttle)
+{
+
+  float position = speed / this->_bin_width;
+  if ((position < 0) || (position > this->_throttles.size() - 1))
+    return;
+
+  size_t bin = std::min((size_t)position, this->_throttles.size() - 2);
+  float fraction = position - bin;
+
+  this->_throttles[bin] += this->_learning_rate * (1 - fraction) * (throttle - this->_throttles[bin]);
+  this->_throttles[bin + 1] += this->_learning_rate * fraction * (throttle - this->_throttles[bin + 1]);
+  this->_samples[(fraction < 0.5) ? bin : bin + 1]++;
+
+  //keep throttle non-decreasing with speed, so interpolation between learned and unlearned bins stays sensible
+  for (size_t i = bin + 1; i < this->_throttles.size(); i++)
+    this->_throttles[i] = std::max(this->_throttles[i], this->_throttles[i - 1]);
+  for (size_t i = bin + 1; i > 0; i--)
+    this->_throttles[i - 1] = std::min(this->_throttles[i - 1], this->_throttles[i]);
+
+}
+
+//read map from file (header line, then speed, throttle, and samples of each bin)
+bool ThrottleMap::load(const std::string& path)
+{
+
+  std::ifstream input_file(path.c_str());
+  if (!input_file.good())
+    return false;
+
+  std::vector<float> throttles;
+  std::vector<unsigned long> samples;
+  std::string line;
+  std::getline(input_file, line);
+  while (std::getline(input_file, line))
+  {
+
+    std::istringstream line_stream(line);
+    std::string speed_field, throttle_field, count_field;
+    std::getline(line_stream, speed_field, ',');
+    std::getline(line_stream, throttle_field, ',');
+    std::getline(line_stream, count_field, '\n');
+    if (speed_field.empty() || throttle_field.empty() || count_field.empty())
+      continue;
+
+    //a malformed line means the file is corrupted
+    float speed, throttle;
+    unsigned long count;
+    if (!parseFloat(speed_field, speed) || !parseFloat(throttle_field, throttle) || !parseUnsignedLong(count_field, count))
+      return false;
+
+    //bins must be at the same speeds as this map's
+    if (fabs(speed - throttles.size() * this->_bin_width) > 0.001)
+      return false;
+
+    throttles.push_back(throttle);
+    samples.push_back(count);
+
+  }
+
+  if (throttles.size() != this->_throttles.size())
+    return false;
+
+  this->_throttles = throttles;
+  this->_samples = samples;
+
+  return true;
+
+}
+
+//write map to file
+bool ThrottleMap::save(const std::string& path) const
+{
+
+  std::ofstream output_file(path.c_str());
+  if (!output_file.good())
+    return false;
+
+  output_file << "speed,throttle,samples\n";
+  for (size_t i = 0; i < this->_throttles.size(); i++)
+    output_file << i * this->_bin_width << "," << this->_throttles[i] << "," << this->_samples[i] << "\n";
+
+  return output_file.good();
+
+}
+
+
+//speed controller
+
+const float SpeedController::SETTLE_SPEED_BAND = 0.1;
+const float SpeedController::SETTLE_THROTTLE_BAND = 2.0;
+const float SpeedController::SETTLE_TIME = 0.5;
+
+//default constructor
+SpeedController::SpeedController(const SpeedControllerGains& gains, const ThrottleMap& map) : _map(map)
+{
+  this->_gains = gains;
+  this->reset();
+}
+
+//get functions
+
+float SpeedController::getFeedforward() const
+{
+  return this->_feedforward;
+}
+
+ThrottleMap& SpeedController::getThrottleMap()
+{
+  return this->_map;
+}
+
+//other functions
+
+//clear integral and settling state
+void SpeedController::reset()
+{
+
+  this->_feedforward = 0;
+  this->_integral = 0;
+  this->_output = 0;
+
+  this->_settle_speed = 0;
+  this->_settle_throttle = 0;
+  this->_settle_time = 0;
+
+}
+
+//calculate throttle driving at target speed, learning the throttle output once it holds a steady speed
+float SpeedController::update(float target_speed, float speed, bool speed_valid, float max_throttle, float dt)
+{
+
+  //encoders don't measure direction, so only forward speeds are controlled
+  target_speed = std::max(target_speed, 0.0f);
+  max_throttle = std::max(max_throttle, 0.0f);
+
+  //learn throttle output since last update once it has held speed steady for the settle time
+  if (speed_valid && (speed > SETTLE_SPEED_BAND) && (fabs(speed - this->_settle_speed) <= SETTLE_SPEED_BAND) &&
+    (fabs(this->_output - this->_settle_throttle) <= SETTLE_THROTTLE_BAND))
+  {
+    this->_settle_time += dt;
+    if (this->_settle_time >= SETTLE_TIME)
+      this->_map.learn(speed, this->_output);
+  }
+  else
+  {
+    this->_settle_speed = speed;
+    this->_settle_throttle = this->_output;
+    this->_settle_time = 0;
+  }
+
+  //brake to a stop
+  if (target_speed == 0)
+  {
+
+    this->_feedforward = 0;
+    this->_integral = 0;
+    this->_output = speed_valid ? std::max(-this->_gains.kp * speed, -this->_gains.max_brake) : 0;
+
+    return this->_output;
+
+  }
+
+  this->_feedforward = this->_map.getThrottle(target_speed);
+  if (!speed_valid)
+  {
+    this->_output = std::min(this->_feedforward, max_throttle);
+    return this->_output;
+  }
+
+  //PI correction, the integral only grows while the output isn't saturated in the same direction
+  float error = target_speed - speed;
+  float integral = this->_integral + this->_gains.ki * error * dt;
+  float output = this->_feedforward + this->_gains.kp * error + integral;
+  float limited = std::min(std::max(output, -this->_gains.max_brake), max_throttle);
+  if ((output == limited) || ((output > limited) != (error > 0)))
+    this->_integral = integral;
+
+  this->_output = limited;
+
+  return this->_output;
+
+}
@@ -0,0 +1,267 @@
+//steering calibration node
+//measures the steering angle achieved at each steering servo pulsewidth while driving (live, or from a recorded run played back with
+//rosbag play), and on shutdown writes the steering table actuator_node interpolates (ss_table_file), so the steering angle commanded
+//gives the curvature the path tracker expects on both sides
+//the achieved angle follows from the bicycle model: yaw rate of the IMU = front wheel speed * sin(angle) / wheelbase; samples are taken
+//while armed and driving above min speed (from the front wheel encoders), once the pulsewidth has been held for the settle time, and are
+//averaged in pulsewidth bins
+//usage: rosrun avc_hardware_interface steering_calibration_node, then drive circles at steady steering angles from full left to full
+//right and stop the node (Ctrl-C) to write the table
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include <vector>
+#include <steering_table.hpp>
+#include <ros/ros.h>
+#include <avc_msgs/ActuatorState.h>
+#include <avc_msgs/WheelEncoders.h>
+#include <sensor_msgs/Imu.h>
+
+//age after which the latest actuator state or wheel speed isn't matched to IMU samples [s]
+const double MAX_SAMPLE_AGE = 0.2;
+
+//steering angles measured at pulsewidths of one bin
+struct AngleBin
+{
+  double angle_sum; //[deg]
+  unsigned long samples;
+};
+
+//pulsewidth bin with its mean measured steering angle, or a run of bins pooled to keep angle monotonic in pulsewidth
+struct CalibrationPoint
+{
+  double pulsewidth; //[us]
+  double angle; //[deg]
+  double samples;
+};
+
+//global variables
+std::map<int, AngleBin> angle_bins; //keyed by bin (pulsewidth / bin width, rounded)
+int bin_width = 10; //[us]
+unsigned long min_samples = 20;
+float min_speed = 1.0; //[m/s]
+float settle_time = 0.3; //[s]
+float wheelbase = 0.33; //[m]
+float wheel_radius = 0; //[m]
+
+bool state_valid = false; //armed and steering command fresh
+int steering_pulsewidth = 0; //[us]
+ros::Time pulsewidth_stamp; //time steering pulsewidth was first seen at its current value
+ros::Time state_stamp;
+float speed = 0; //ground speed of front wheels [m/s]
+ros::Time speed_stamp;
+
+
+//callback function called to process messages on actuator_state topic
+void actuatorStateCallback(const avc_msgs::ActuatorState::ConstPtr& msg)
+{
+
+  //restart settling whenever pulsewidth changes
+  if ((msg->steering_pulsewidth != steering_pulsewidth) || !state_valid)
+    pulsewidth_stamp = msg->header.stamp;
+
+  state_valid = msg->armed && !msg->steering_stale;
+  steering_pulsewidth = msg->steering_pulsewidth;
+  state_stamp = msg->header.stamp;
+
+}
+
+//callback function called to process messages on wheel encoders topic
+void wheelEncodersCallback(const avc_msgs::WheelEncoders::ConstPtr& msg)
+{
+
+  //average front (undriven) wheels and convert angular velocity to ground speed [m/s]
+  speed = (msg->front_left + msg->front_right) / 2 * wheel_radius;
+  speed_stamp = msg->header.stamp;
+
+}
+
+//callback function called to process messages on imu topic
+void imuCallback(const sensor_msgs::Imu::ConstPtr& msg)
+{
+
+  //only use samples driving steadily at a settled pulsewidth, with current actuator state and wheel speed (a dead encoder must not keep
+  //its last speed)
+  if (!state_valid || (fabs((msg->header.stamp - state_stamp).toSec()) > MAX_SAMPLE_AGE) ||
+    (fabs((msg->header.stamp - speed_stamp).toSec()) > MAX_SAMPLE_AGE) || (speed < min_speed) ||
+    ((msg->header.stamp - pulsewidth_stamp).toSec() < settle_time))
+    return;
+
+  //imu_node publishes RTIMULib's NED gyro rates (z down), so a left turn has a negative z rate; yaw rate here is positive turning left
+  double yaw_rate = -msg->angular_velocity.z; //[rad/s]
+
+  //steering angle from yaw rate and front wheel speed, positive left [deg]
+  double ratio = std::min(std::max(wheelbase * yaw_rate / speed, -1.0), 1.0);
+  double angle = asin(ratio) * 180 / M_PI;
+
+  int bin = lround((double)steering_pulsewidth / bin_width);
+  AngleBin& angle_bin = angle_bins[bin];
+  angle_bin.angle_sum += angle;
+  angle_bin.samples++;
+
+  if (angle_bin.samples == min_samples)
+    ROS_INFO("[steering_calibration_node] %d us calibrated: %.1f deg", bin * bin_width, angle_bin.angle_sum / angle_bin.samples);
+
+}
+
+//pool adjacent points until angle changes with pulsewidth in direction only (weighted by samples), so the calibration can be inverted
+std::vector<CalibrationPoint> poolMonotonic(const std::vector<CalibrationPoint>& points, double direction)
+{
+
+  std::vector<CalibrationPoint> pooled;
+  for (size_t i = 0; i < points.size(); i++)
+  {
+
+    pooled.push_back(points[i]);
+    while ((pooled.size() > 1) && (direction * (pooled.back().angle - pooled[pooled.size() - 2].angle) <= 0))
+    {
+
+      CalibrationPoint last = pooled.back();
+      pooled.pop_back();
+
+      CalibrationPoint& previous = pooled.back();
+      double samples = previous.samples + last.samples;
+      previous.pulsewidth = (previous.pulsewidth * previous.samples + last.pulsewidth * last.samples) / samples;
+      previous.angle = (previous.angle * previous.samples + last.angle * last.samples) / samples;
+      previous.samples = samples;
+
+    }
+
+  }
+
+  return pooled;
+
+}
+
+//pulsewidth giving steering angle, interpolated between calibration points and extrapolated from the outermost two [us]
+double calibratedPulsewidth(const std::vector<CalibrationPoint>& points, double angle, double direction)
+{
+
+  size_t i = 1;
+  while ((i < points.size() - 1) && (direction * (angle - points[i].angle) > 0))
+    i++;
+
+  const CalibrationPoint& a = points[i - 1];
+  const CalibrationPoint& b = points[i];
+
+  return a.pulsewidth + (angle - a.angle) / (b.angle - a.angle) * (b.pulsewidth - a.pulsewidth);
+
+}
+
+int main(int argc, char **argv)
+{
+
+  //send notification that node is launching
+  ROS_INFO("[NODE LAUNCH]: starting steering_calibration_node");
+
+  //initialize node and create node handler
+  ros::init(argc, argv, "steering_calibration_node");
+  ros::NodeHandle node_private("~");
+  ros::NodeHandle node_public;
+
+  //retrieve servo max rotation angle value from parameter server [deg]
+  float ss_max_angle;
+  if (!node_private.getParam("/steering_servo/max_rotation_angle", ss_max_angle))
+  {
+    ROS_ERROR("[steering_calibration_node] steering servo max angle not defined in config file: avc_bringup/config/global.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve steering servo pulsewidth limits and steering table file from parameter server [us]
+  int ss_max_left, ss_max_right, ss_neutral_value;
+  std::string ss_table_file;
+  if (!node_private.getParam("/hardware/actuator_node/ss_max_left", ss_max_left) ||
+    !node_private.getParam("/hardware/actuator_node/ss_max_right", ss_max_right) ||
+    !node_private.getParam("/hardware/actuator_node/ss_neutral_value", ss_neutral_value) ||
+    !node_private.getParam("/hardware/actuator_node/ss_table_file", ss_table_file) || ss_table_file.empty())
+  {
+    ROS_ERROR("[steering_calibration_node] steering servo parameters not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve calibration parameters from parameter server
+  int table_points;
+  int min_bin_samples;
+  if (!node_private.getParam("/hardware/steering_calibration_node/bin_width", bin_width) ||
+    !node_private.getParam("/hardware/steering_calibration_node/min_samples", min_bin_samples) ||
+    !node_private.getParam("/hardware/steering_calibration_node/min_speed", min_speed) ||
+    !node_private.getParam("/hardware/steering_calibration_node/settle_time", settle_time) ||
+    !node_private.getParam("/hardware/steering_calibration_node/table_points", table_points) ||
+    !node_private.getParam("/hardware/steering_calibration_node/wheelbase", wheelbase))
+  {
+    ROS_ERROR("[steering_calibration_node] calibration parameters not defined in config file: avc_hardware_interface/config/hardware_interface.yaml");
+    ROS_BREAK();
+  }
+  bin_width = std::max(bin_width, 1);
+  min_samples = std::max(min_bin_samples, 1);
+
+  //retrieve wheel radius used to convert encoder angular velocity to ground speed from parameter server [m]
+  if (!node_private.getParam("/sensor/encoder/wheel_radius", wheel_radius))
+  {
+    ROS_ERROR("[steering_calibration_node] wheel radius not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //create subscriber to subscribe to actuator state topic with queue size set to 10
+  ros::Subscriber state_sub = node_public.subscribe("/hardware/actuator_state", 10, actuatorStateCallback);
+
+  //create subscriber to subscribe to wheel encoders topic with queue size set to 10
+  ros::Subscriber wheel_encoders_sub = node_public.subscribe("/sensor/wheel_encoders", 10, wheelEncodersCallback);
+
+  //create subscriber to subscribe to imu topic with queue size set to 100
+  ros::Subscriber imu_sub = node_public.subscribe("/sensor/imu", 100, imuCallback);
+
+  //collect samples until node shuts down
+  ros::spin();
+
+  //calibration points of bins with enough samples, in order of pulsewidth
+  std::vector<CalibrationPoint> points;
+  for (std::map<int, AngleBin>::const_iterator it = angle_bins.begin(); it != angle_bins.end(); it++)
+  {
+    if (it->second.samples < min_samples)
+      continue;
+
+    CalibrationPoint point = { (double)it->first * bin_width, it->second.angle_sum / it->second.samples, (double)it->second.samples };
+    points.push_back(point);
+    ROS_INFO("[steering_calibration_node] %4.0f us: %6.2f deg (%lu samples)", point.pulsewidth, point.angle, it->second.samples);
+  }
+
+  //angle must decrease with pulsewidth if left is the lower pulsewidth, and increase otherwise
+  double direction = (ss_max_left < ss_max_right) ? -1 : 1;
+  points = poolMonotonic(points, direction);
+  if ((points.size() < 2) || (std::min(points.front().angle, points.back().angle) >= 0) ||
+    (std::max(points.front().angle, points.back().angle) <= 0))
+  {
+    ROS_ERROR("[steering_calibration_node] not enough pulsewidths calibrated turning both left and right, steering table not written");
+    return 1;
+  }
+
+  //invert calibration at table angles, limited to the servo range
+  SteeringTable steering_table(ss_max_angle, ss_neutral_value, ss_max_left, ss_max_right);
+  table_points = std::min(std::max(table_points, 2), SteeringTable::MAX_POINTS);
+  float pulsewidths[SteeringTable::MAX_POINTS];
+  int extrapolated = 0;
+  for (int i = 0; i < table_points; i++)
+  {
+    double angle = i * 2 * ss_max_angle / (table_points - 1) - ss_max_angle;
+    double pulsewidth = calibratedPulsewidth(points, angle, direction);
+    pulsewidths[i] = std::min(std::max(pulsewidth, (double)std::min(ss_max_left, ss_max_right)), (double)std::max(ss_max_left, ss_max_right));
+
+    if ((angle < std::min(points.front().angle, points.back().angle)) || (angle > std::max(points.front().angle, points.back().angle)))
+      extrapolated++;
+  }
+  steering_table.setPulsewidths(pulsewidths, table_points);
+
+  if (extrapolated > 0)
+    ROS_WARN("[steering_calibration_node] %d of %d table points are beyond the angles driven and were extrapolated", extrapolated, table_points);
+
+  if (!steering_table.save(ss_table_file))
+  {
+    ROS_ERROR("[steering_calibration_node] failed to write steering table to %s", ss_table_file.c_str());
+    return 1;
+  }
+  ROS_INFO("[steering_calibration_node] steering table written to %s (neutral %.0f us)", ss_table_file.c_str(),
+    steering_table.getPulsewidth(0.0f));
+
+  return 0;
+}
@@ -0,0 +1,144 @@
+//include header
+#include <steering_table.hpp>
+
+#include <config_parsing.hpp>
+#include <fstream>
+#include <math.h>
+#include <sstream>
+#include <vector>
+
+
+//constructors and destructors
+
+//default constructor
+SteeringTable::SteeringTable(float max_angle, int neutral, int max_left, int max_right)
+{
+
+  this->_max_angle = max_angle;
+
+  float pulsewidths[3] = { (float)max_right, (float)neutral, (float)max_left };
+  this->setPulsewidths(pulsewidths, 3);
+
+}
+
+//get functions
+
+float SteeringTable::getMaxAngle() const
+{
+  return this->_max_angle;
+}
+
+int SteeringTable::getPoints() const
+{
+  return this->_points;
+}
+
+//interpolate pulsewidth between the two points around angle
+float SteeringTable::getPulsewidth(float angle) const
+{
+
+  float position = (angle + this->_max_angle) * this->_scale;
+  if (position <= 0)
+    return this->_pulsewidths[0];
+  if (position >= this->_points - 1)
+    return this->_pulsewidths[this->_points - 1];
+
+  int point = (int)position;
+  float fraction = position - point;
+
+  return this->_pulsewidths[point] + fraction * (this->_pulsewidths[point + 1] - this->_pulsewidths[point]);
+
+}
+
+float SteeringTable::getPointAngle(int point) const
+{
+  return point / this->_scale - this->_max_angle;
+}
+
+float SteeringTable::getPointPulsewidth(int point) const
+{
+  return this->_pulsewidths[point];
+}
+
+//set functions
+
+//replace points, first point at -max angle and last at max angle
+bool SteeringTable::setPulsewidths(const float *pulsewidths, int points)
+{
+
+  if ((points < 2) || (points > MAX_POINTS))
+    return false;
+
+  for (int i = 0; i < points; i++)
+    this->_pulsewidths[i] = pulsewidths[i];
+  this->_points = points;
+  this->_scale = (points - 1) / (2 * this->_max_angle);
+
+  return true;
+
+}
+
+//other functions
+
+//read table from file (header line, then angle and pulsewidth of each point)
+bool SteeringTable::load(const std::string& path)
+{
+
+  std::ifstream input_file(path.c_str());
+  if (!input_file.good())
+    return false;
+
+  std::vector<float> angles;
+  std::vector<float> pulsewidths;
+  std::string line;
+  std::getline(input_file, line);
+  while (std::getline(input_file, line))
+  {
+
+    std::istringstream line_stream(line);
+    std::string angle_field, pulsewidth_field;
+    std::getline(line_stream, angle_field, ',');
+    std::getline(line_stream, pulsewidth_field, '\n');
+    if (angle_field.empty() || pulsewidth_field.empty())
+      continue;
+
+    //a malformed line means the file is corrupted
+    float angle, pulsewidth;
+    if (!parseFloat(angle_field, angle) || !parseFloat(pulsewidth_field, pulsewidth))
+      return false;
+
+    angles.push_back(angle);
+    pulsewidths.push_back(pulsewidth);
+
+  }
+
+  if (pulsewidths.size() < 2)
+    return false;
+
+  //points must be evenly spaced over this table's angle range
+  float spacing = 2 * this->_max_angle / (angles.size() - 1);
+  for (size_t i = 0; i < angles.size(); i++)
+  {
+    if (fabs(angles[i] - (i * spacing - this->_max_angle)) > 0.01)
+      return false;
+  }
+
+  return this->setPulsewidths(pulsewidths.data(), pulsewidths.size());
+
+}
+
+//write table to file
+bool SteeringTable::save(const std::string& path) const
+{
+
+  std::ofstream output_file(path.c_str());
+  if (!output_file.good())
+    return false;
+
+  output_file << "angle,pulsewidth\n";
+  for (int i = 0; i < this->_points; i++)
+    output_file << this->getPointAngle(i) << "," << this->_pulsewidths[i] << "\n";
+
+  return output_file.good();
+
+}
@@ -9,6 +9,7 @@
 #include <pid_controller.hpp>
 #include <ros/console.h>
 #include <ros/ros.h>
+#include <avc_msgs/Armed.h>
 #include <avc_msgs/ChangeControlMode.h>
 #include <avc_msgs/Control.h>
 #include <avc_msgs/ESC.h>
@@ -26,6 +27,7 @@ const double PI = 3.1415926535897;
 
 //global variables
 bool accel_delay_flag = false;
+bool actuators_armed = false;
 bool autonomous_control = false;
 bool autonomous_running = false;
 bool mode_change_requested = false;
@@ -68,6 +70,27 @@ void accelDelayTimerCallback(const ros::TimerEvent& event)
 
 //--------------------------CALLBACK FUNCTIONS----------------------------------
 
+//callback function called to process messages on armed topic
+void armedCallback(const avc_msgs::Armed::ConstPtr& msg)
+{
+
+  //notify once actuators are ready
+  if (msg->armed && !actuators_armed)
+    ROS_INFO("[navigation_node] actuators armed");
+
+  //stop autonomous running if actuators are no longer armed (actuator node restarted)
+  if (!msg->armed && autonomous_running)
+  {
+    autonomous_running = false;
+    digitalWrite(indicator_LED, LOW);
+    ROS_WARN("[navigation_node] actuators not armed, disabling autonomous running");
+  }
+
+  //set local value to received value
+  actuators_armed = msg->armed;
+
+}
+
 //callback function called to process messages on control topic
 void controlCallback(const avc_msgs::Control::ConstPtr& msg)
 {
@@ -87,6 +110,13 @@ void controllerCallback(const sensor_msgs::Joy::ConstPtr& msg)
   //set local values to match message values
   controller_buttons = msg->buttons;
 
+  //autonomous running can't be enabled until actuators are armed
+  if ((controller_buttons[1] == 1) && autonomous_control && !autonomous_running && !actuators_armed)
+  {
+    ROS_WARN("[navigation_node] actuators not armed yet, can't enable autonomous running");
+    controller_buttons[1] = 0;
+  }
+
   //if autonomous running button on controller is pressed then toggle autonomous running status
   if ((controller_buttons[1] == 1) && (autonomous_control))
   {
@@ -257,6 +287,30 @@ int main(int argc, char **argv)
     ROS_BREAK();
   }
 
+  //retrieve whether to drive at target speeds with the hardware interface speed controller (velocity mode) from parameter server
+  bool velocity_mode = false;
+  if (!node_private.getParam("/navigation/navigation_node/velocity_mode", velocity_mode))
+  {
+    ROS_WARN_STREAM("[navigation_node] no velocity mode provided, using default: " << velocity_mode);
+  }
+
+  //drive profile, in velocity mode given in speeds [m/s] and speed changes [m/s^2] instead of throttles [%] and throttle changes [%/s]
+  //(the maximum throttle then limits the speed controller output)
+  float drive_maximum = maximum_throttle;
+  float drive_minimum = minimum_throttle;
+  float drive_min_distance = min_distance_throttle;
+  float drive_acceleration = maximum_acceleration;
+  float drive_deceleration = maximum_deceleration;
+  if (velocity_mode && (!node_private.getParam("/driving/maximum_speed", drive_maximum) ||
+    !node_private.getParam("/driving/minimum_speed", drive_minimum) ||
+    !node_private.getParam("/driving/min_distance_speed", drive_min_distance) ||
+    !node_private.getParam("/driving/speed_acceleration", drive_acceleration) ||
+    !node_private.getParam("/driving/speed_deceleration", drive_deceleration)))
+  {
+    ROS_ERROR("[navigation_node] velocity mode speed profile not defined in config file: avc_bringup/config/global.yaml");
+    ROS_BREAK();
+  }
+
   //retrieve map waypoint delay from parameter server [ms]
   std::string output_file_path;
   if (!node_private.getParam("/mapping/output_file_path", output_file_path))
@@ -324,6 +378,7 @@ int main(int argc, char **argv)
   //create ESC message object and set default parameters
   avc_msgs::ESC esc_msg;
   esc_msg.header.frame_id = "0";
+  esc_msg.velocity_mode = velocity_mode;
 
   //create steering servo message object and set default parameters
   avc_msgs::SteeringServo steering_servo_msg;
@@ -338,6 +393,9 @@ int main(int argc, char **argv)
   //create service to process service requests on the disable manual control topic
   ros::ServiceServer disable_navigation_srv = node_public.advertiseService("/control/disable_navigation", disableNavigationCallback);
 
+  //create subscriber to subscribe to armed messages topic with queue size set to 1
+  ros::Subscriber armed_sub = node_public.subscribe("/hardware/armed", 1, armedCallback);
+
   //create subscriber to subscribe to control messages topic with queue size set to 1000
   ros::Subscriber control_sub = node_public.subscribe("/control/control", 1000, controlCallback);
 
@@ -364,8 +422,8 @@ int main(int argc, char **argv)
   //create timer object for clearing acceleration delay flag
   ros::Timer accel_delay_timer;
 
-  //initialie variable for recording last throttle percent value
-  double last_throttle_value = 0;
+  //initialie variable for recording last throttle percent (or target speed) value
+  double last_drive_value = 0;
 
   //set loop rate in Hz
   ros::Rate loop_rate(refresh_rate);
@@ -438,8 +496,8 @@ int main(int argc, char **argv)
       }
 
     }
-    //if mode change wasn't requested and in autonomous mode, check if button is pressed
-    else if (autonomous_control && !autonomous_running && digitalRead(button_pin))
+    //if mode change wasn't requested and in autonomous mode, check if button is pressed (only once actuators are armed)
+    else if (autonomous_control && !autonomous_running && actuators_armed && digitalRead(button_pin))
     {
 
       //enable autonomous running
@@ -506,37 +564,43 @@ int main(int argc, char **argv)
         //calculate distance to next waypoint
         float distance_to_next = sqrt(pow(target_delta_x, 2) + pow(target_delta_y, 2));
 
-        //create throttle percent variable
-        double throttle_percent;
+        //create throttle percent (target speed in velocity mode) variable
+        double drive_value;
 
         //if distance is above threshold value, set throttle to maximum value
         if (!accel_delay_flag && (distance_to_next > threshold_distance_value))
-          throttle_percent = maximum_throttle;
+          drive_value = drive_maximum;
         //if within threshold distance, reduce throttle from maximum inverse-proportionally to distance to minimum distance value
         else if (!accel_delay_flag && ((distance_to_next < threshold_distance_value) && (distance_to_next > min_distance_value)))
-          throttle_percent = min_distance_throttle + (maximum_throttle - min_distance_throttle) * ((distance_to_next - min_distance_value) / (threshold_distance_value - min_distance_value));
+          drive_value = drive_min_distance + (drive_maximum - drive_min_distance) * ((distance_to_next - min_distance_value) / (threshold_distance_value - min_distance_value));
         //if below minimum distance value, set throttle to minimum value
         else
-          throttle_percent = min_distance_throttle;
+          drive_value = drive_min_distance;
 
         //limit acceleration to defined maximum
-        if ((throttle_percent - last_throttle_value) > (maximum_acceleration / refresh_rate))
-          throttle_percent = last_throttle_value + (maximum_acceleration / refresh_rate);
+        if ((drive_value - last_drive_value) > (drive_acceleration / refresh_rate))
+          drive_value = last_drive_value + (drive_acceleration / refresh_rate);
         //limit deceleration to defined maximum
-        else if ((last_throttle_value - throttle_percent)  > (maximum_deceleration / refresh_rate))
-          throttle_percent = last_throttle_value - (maximum_deceleration / refresh_rate);
+        else if ((last_drive_value - drive_value)  > (drive_deceleration / refresh_rate))
+          drive_value = last_drive_value - (drive_deceleration / refresh_rate);
 
         //if throttle percent is requested below minimum value, set to minimum value
-        if (throttle_percent < minimum_throttle)
-          throttle_percent = minimum_throttle;
+        if (drive_value < drive_minimum)
+          drive_value = drive_minimum;
 
-        //set time and throttle percent value of ESC message and publish
-        esc_msg.throttle_percent = throttle_percent;
+        //set time and throttle percent (or target speed and throttle limit) value of ESC message and publish
+        if (velocity_mode)
+        {
+          esc_msg.target_speed = drive_value;
+          esc_msg.throttle_percent = maximum_throttle;
+        }
+        else
+          esc_msg.throttle_percent = drive_value;
         esc_msg.header.stamp = ros::Time::now();
         esc_pub.publish(esc_msg);
 
         //set last throttle value to current throttle value
-        last_throttle_value = throttle_percent;
+        last_drive_value = drive_value;
 
         //check if robot is within defined distance of waypoint, notify and set target to next waypoint if true
         if (distance_to_next < waypoint_radius)
@@ -595,6 +659,7 @@ int main(int argc, char **argv)
       //reset ESC msg, set time, and publish
       esc_msg.header.stamp = ros::Time::now();
       esc_msg.throttle_percent = 0;
+      esc_msg.target_speed = 0;
       esc_pub.publish(esc_msg);
 
       //reset steering msg, set time, and publish
@@ -0,0 +1,40 @@
+#ifndef ENCODER_VELOCITY_ESTIMATOR_HPP
+#define ENCODER_VELOCITY_ESTIMATOR_HPP
+
+#include <stdint.h>
+
+//estimates wheel angular velocity from encoder edge timestamps
+//at low rates velocity is taken from the period between edges, which resolves speed far better than counting edges
+//over a short window; at high rates (or if edges were lost) it falls back to counting edges per publish interval
+//timestamps are in microseconds and may wrap around (e.g. wiringPi micros())
+class EncoderVelocityEstimator
+{
+  public:
+
+    //constructors and destructors
+    EncoderVelocityEstimator(int counts_per_rev, int count_threshold, double timeout);
+    ~EncoderVelocityEstimator();
+
+    //other functions
+    void addEdge(uint32_t timestamp); //record an encoder edge [us]
+    void addLostEdges(unsigned int count); //record edges that occurred but have no timestamp
+    double estimate(uint32_t now); //estimate angular velocity at time now from edges recorded since last estimate [rad/s]
+
+  private:
+    double _counts_per_rev;
+    double _timeout;
+    double _velocity; //last estimate [rad/s]
+    bool _have_last_edge;
+    bool _have_last_estimate;
+    int _count_threshold;
+    uint32_t _first_edge; //first edge since last estimate [us]
+    uint32_t _last_edge; //most recent edge [us]
+    uint32_t _last_estimate; //time of last estimate [us]
+    uint32_t _reference_edge; //most recent edge before first edge since last estimate [us]
+    bool _have_reference_edge;
+    unsigned int _edges; //edges recorded since last estimate
+    unsigned int _lost_edges; //edges lost since last estimate
+
+};
+
+#endif
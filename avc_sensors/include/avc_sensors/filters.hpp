@@ -0,0 +1,301 @@
+#ifndef FILTERS_HPP
+#define FILTERS_HPP
+
+#include <math.h>
+#include <stddef.h>
+
+//streaming filters with per-instance state
+//all filters are allocation-free so any number of independent channels can be filtered in one process
+
+//running median over the last N samples
+//keeps a circular buffer of samples in arrival order and a sorted copy of the same samples,
+//so each update is a single remove and insert in the sorted copy (O(N), no allocation)
+template <typename T, size_t N>
+class MedianFilter
+{
+  public:
+
+    MedianFilter() : _count(0), _index(0) {}
+
+    //add sample to window and return median of current window
+    T update(T sample)
+    {
+
+      //if window is full then remove oldest sample from sorted copy
+      if (this->_count == N)
+        removeSorted(this->_buffer[this->_index]);
+      else
+        this->_count++;
+
+      //overwrite oldest sample in circular buffer and wrap index
+      this->_buffer[this->_index] = sample;
+      if (++this->_index >= N)
+        this->_index = 0;
+
+      //insert new sample into sorted copy
+      insertSorted(sample);
+
+      return median();
+
+    }
+
+    //get median of current window (upper median for even sample counts)
+    T median() const
+    {
+      return (this->_count > 0) ? this->_sorted[this->_count / 2] : T();
+    }
+
+    //get sample at given position of sorted window
+    T sorted(size_t i) const
+    {
+      return this->_sorted[i];
+    }
+
+    size_t size() const
+    {
+      return this->_count;
+    }
+
+    bool full() const
+    {
+      return this->_count == N;
+    }
+
+    void reset()
+    {
+      this->_count = 0;
+      this->_index = 0;
+    }
+
+  private:
+    T _buffer[N];
+    T _sorted[N];
+    size_t _count;
+    size_t _index;
+
+    //remove one copy of value from sorted copy (sorted count is _count - 1 afterwards)
+    void removeSorted(T value)
+    {
+
+      //find position of value (guaranteed to be present)
+      size_t i = 0;
+      while ((i < N - 1) && (this->_sorted[i] != value))
+        i++;
+
+      //shift larger values down over removed value
+      for (; i < N - 1; i++)
+        this->_sorted[i] = this->_sorted[i + 1];
+
+    }
+
+    //insert value into sorted copy, which holds _count - 1 values on entry
+    void insertSorted(T value)
+    {
+
+      //shift larger values up until insertion point is found
+      size_t i = this->_count - 1;
+      while ((i > 0) && (this->_sorted[i - 1] > value))
+      {
+        this->_sorted[i] = this->_sorted[i - 1];
+        i--;
+      }
+
+      this->_sorted[i] = value;
+
+    }
+
+};
+
+//Hampel outlier rejection over the last N samples
+//samples further than k scaled median absolute deviations from the window median are replaced by the median
+template <typename T, size_t N>
+class HampelFilter
+{
+  public:
+
+    HampelFilter(T k = 3) : _k(k), _outlier(false) {}
+
+    //add sample to window and return sample, or window median if sample is an outlier
+    T update(T sample)
+    {
+
+      //update running window and get median
+      T median = this->_window.update(sample);
+
+      //calculate median absolute deviation of window
+      size_t count = this->_window.size();
+      T deviations[N];
+      for (size_t i = 0; i < count; i++)
+        deviations[i] = fabs(this->_window.sorted(i) - median);
+      T mad = selectMedian(deviations, count);
+
+      //1.4826 scales MAD to standard deviation for normally distributed data
+      this->_outlier = (count > 2) && (fabs(sample - median) > this->_k * T(1.4826) * mad);
+
+      return this->_outlier ? median : sample;
+
+    }
+
+    //returns true if last sample was rejected as an outlier
+    bool outlier() const
+    {
+      return this->_outlier;
+    }
+
+    void reset()
+    {
+      this->_window.reset();
+      this->_outlier = false;
+    }
+
+  private:
+    MedianFilter<T, N> _window;
+    T _k;
+    bool _outlier;
+
+    //get upper median of small array by insertion sort (array is modified)
+    static T selectMedian(T values[], size_t count)
+    {
+
+      for (size_t i = 1; i < count; i++)
+      {
+        T value = values[i];
+        size_t j = i;
+        while ((j > 0) && (values[j - 1] > value))
+        {
+          values[j] = values[j - 1];
+          j--;
+        }
+        values[j] = value;
+      }
+
+      return values[count / 2];
+
+    }
+
+};
+
+//first order exponential smoothing filter
+//alpha is the weight of the newest sample (0 to 1, larger values = less smoothing)
+template <typename T>
+class ExponentialFilter
+{
+  public:
+
+    ExponentialFilter(T alpha) : _alpha(alpha), _initialized(false), _value(0) {}
+
+    //add sample and return smoothed value (first sample initializes filter)
+    T update(T sample)
+    {
+
+      if (!this->_initialized)
+      {
+        this->_value = sample;
+        this->_initialized = true;
+      }
+      else
+        this->_value += this->_alpha * (sample - this->_value);
+
+      return this->_value;
+
+    }
+
+    T value() const
+    {
+      return this->_value;
+    }
+
+    void setAlpha(T alpha)
+    {
+      this->_alpha = alpha;
+    }
+
+    void reset()
+    {
+      this->_initialized = false;
+      this->_value = 0;
+    }
+
+  private:
+    T _alpha;
+    bool _initialized;
+    T _value;
+
+};
+
+//alpha-beta (fixed gain g-h) tracking filter estimating value and rate of change
+//alpha corrects the value estimate and beta the rate estimate from the prediction residual (0 to 1)
+template <typename T>
+class AlphaBetaFilter
+{
+  public:
+
+    AlphaBetaFilter(T alpha, T beta) : _alpha(alpha), _beta(beta), _initialized(false), _value(0), _rate(0), _residual(0) {}
+
+    //add sample taken dt seconds after the previous one and return filtered value
+    T update(T sample, T dt)
+    {
+
+      //first sample initializes value with unknown (zero) rate
+      if (!this->_initialized || (dt <= 0))
+      {
+        if (!this->_initialized)
+        {
+          this->_value = sample;
+          this->_rate = 0;
+          this->_initialized = true;
+        }
+        return this->_value;
+      }
+
+      //predict value from current rate, then correct value and rate from residual
+      T prediction = this->_value + this->_rate * dt;
+      this->_residual = sample - prediction;
+      this->_value = prediction + this->_alpha * this->_residual;
+      this->_rate += (this->_beta / dt) * this->_residual;
+
+      return this->_value;
+
+    }
+
+    T value() const
+    {
+      return this->_value;
+    }
+
+    //estimated rate of change [units/s]
+    T rate() const
+    {
+      return this->_rate;
+    }
+
+    //residual between last sample and its prediction
+    T residual() const
+    {
+      return this->_residual;
+    }
+
+    bool initialized() const
+    {
+      return this->_initialized;
+    }
+
+    void reset()
+    {
+      this->_initialized = false;
+      this->_value = 0;
+      this->_rate = 0;
+      this->_residual = 0;
+    }
+
+  private:
+    T _alpha;
+    T _beta;
+    bool _initialized;
+    T _value;
+    T _rate;
+    T _residual;
+
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef GPS_CLOCK_MODEL_HPP
+#define GPS_CLOCK_MODEL_HPP
+
+#include <stddef.h>
+
+//learns offset between system time and GPS time from sentence arrival times
+//every arrival is later than its fix by the receiver output delay plus serial buffering and scheduling latency, so the smallest
+//arrival time minus GPS time seen within a sliding window (less a known minimum delay) is taken as the clock offset; it follows
+//slow system clock drift through the window and resets when the system clock is stepped forward (arrivals stay late for several
+//consecutive fixes, unlike a single scheduling stall)
+class GpsClockModel
+{
+  public:
+
+    //constructors and destructors
+    GpsClockModel(double window, double min_delay);
+    ~GpsClockModel();
+
+    //get functions
+    double getOffset() const; //system time minus GPS time [s]
+    bool isInitialized() const;
+
+    //other functions
+    void reset();
+    double toSystemTime(double gps_time) const; //[s]
+    void update(double gps_time, double arrival_time); //add arrival of fix with GPS time [s since epoch] at system time [s since epoch]
+
+  private:
+    static const size_t CAPACITY = 1024;
+
+    //arrival time and offset of candidate minimum offsets
+    struct Sample
+    {
+      double arrival_time;
+      double offset;
+    };
+
+    double _min_delay; //[s]
+    double _window; //[s]
+    size_t _count;
+    size_t _head;
+    int _step_samples; //consecutive arrivals past the clock step threshold
+    Sample _samples[CAPACITY]; //increasing offsets in order of arrival, front is current minimum
+
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef GYRO_BIAS_ESTIMATOR_HPP
+#define GYRO_BIAS_ESTIMATOR_HPP
+
+//estimates gyro bias while the vehicle is standing still
+//standstill is detected from a running (exponentially weighted) accelerometer variance, gyro rate, and commanded throttle,
+//and while it lasts the gyro output is averaged as its bias; every update is O(1) with no sample history
+class GyroBiasEstimator
+{
+  public:
+
+    //constructors and destructors
+    GyroBiasEstimator(double max_accel_variance, double max_gyro_rate, double max_throttle, double min_standstill_time, double variance_time_constant, double bias_time_constant);
+    ~GyroBiasEstimator();
+
+    //set functions
+    void setThrottlePercent(double throttle_percent); //commanded throttle [%]
+
+    //get functions
+    void getBias(double& x, double& y, double& z) const; //[rad/s]
+    bool isStandstill() const;
+
+    //other functions
+    void update(double gx, double gy, double gz, double ax, double ay, double az, double dt); //add raw sample taken dt seconds after previous one
+    void correct(double& gx, double& gy, double& gz) const; //subtract bias from gyro rates [rad/s]
+
+  private:
+    double _bias[3]; //[rad/s]
+    double _bias_time_constant; //[s]
+    double _max_accel_variance; //[g^2]
+    double _max_gyro_rate; //[rad/s]
+    double _max_throttle; //[%]
+    double _mean[3]; //running accelerometer mean [g]
+    double _min_standstill_time; //[s]
+    double _standstill_time; //time standstill conditions have held [s]
+    double _throttle_percent; //[%]
+    double _variance[3]; //running accelerometer variance [g^2]
+    double _variance_time_constant; //[s]
+    bool _initialized;
+
+};
+
+#endif
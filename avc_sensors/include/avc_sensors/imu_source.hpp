@@ -0,0 +1,123 @@
+#ifndef IMU_SOURCE_HPP
+#define IMU_SOURCE_HPP
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+//external library includes
+#include <RTIMULib.h>
+
+//IMU sample source used by imu_node acquisition thread
+//samples are returned as RTIMU_DATA with sensor values and read timestamp [us since epoch], fusion is left to the caller
+class ImuSource
+{
+  public:
+
+    //constructors and destructors
+    virtual ~ImuSource() {}
+
+    //get functions
+    virtual int getPollInterval() = 0; //time between checks for new samples [ms]
+    virtual bool isFinished(); //returns true once no more samples will be available
+
+    //other functions
+    virtual bool init() = 0; //returns false if source can't be opened
+    virtual bool read(RTIMU_DATA& data) = 0; //returns true and sets data if a new sample is available
+
+};
+
+//IMU hardware source (RTIMULib driver)
+//RTIMULib only runs its internal fusion if the fusion type of the settings isn't RTFUSION_TYPE_NULL
+class RTIMUSource : public ImuSource
+{
+  public:
+
+    //constructors and destructors
+    RTIMUSource(RTIMUSettings *settings);
+    ~RTIMUSource();
+
+    //get functions
+    int getPollInterval();
+
+    //other functions
+    bool init();
+    bool read(RTIMU_DATA& data);
+
+  private:
+    RTIMU *_imu;
+    RTIMUSettings *_settings;
+
+};
+
+//binary IMU log of raw samples
+//file starts with an 8 byte magic string followed by fixed size little-endian records
+class ImuLog
+{
+  public:
+
+    //one raw sample as stored in log
+    struct Record
+    {
+      uint64_t timestamp; //[us since epoch]
+      float gyro[3]; //[rad/s]
+      float accel[3]; //[g]
+      float compass[3]; //[uT]
+      uint32_t flags; //COMPASS_VALID
+    };
+
+    static const uint32_t COMPASS_VALID = 1;
+
+    //constructors and destructors
+    ImuLog();
+    ~ImuLog();
+
+    //other functions
+    bool openRead(const std::string& file_name); //returns false if file can't be opened or isn't an IMU log
+    bool openWrite(const std::string& file_name); //returns false if file can't be created
+    bool read(RTIMU_DATA& data); //read next sample, returns false at end of log
+    bool write(const RTIMU_DATA& data); //append sample, returns false on write error
+    void close();
+
+  private:
+    FILE *_file;
+
+};
+
+//IMU log replay source
+//samples are released at the logged sample spacing divided by replay rate (must be greater than zero)
+//timestamps keep the logged sample spacing but are shifted to start at the time replay starts
+class ImuLogSource : public ImuSource
+{
+  public:
+
+    //constructors and destructors
+    ImuLogSource(const std::string& file_name, double replay_rate);
+    ~ImuLogSource();
+
+    //get functions
+    int getPollInterval();
+    bool isFinished();
+
+    //other functions
+    bool init();
+    bool read(RTIMU_DATA& data);
+
+  private:
+    bool _finished;
+    bool _pending; //next sample has been read from log but not yet released
+    double _replay_rate;
+    std::chrono::steady_clock::time_point _replay_start;
+    std::string _file_name;
+    uint64_t _first_timestamp; //logged timestamp of first sample [us]
+    uint64_t _start_timestamp; //timestamp given to first sample [us since epoch]
+    ImuLog _log;
+    RTIMU_DATA _next;
+
+};
+
+//create RTIMULib fusion of given type (RTFUSION_TYPE_*), type RTFUSION_TYPE_NULL creates a fusion that leaves samples unchanged
+RTFusion* createFusion(int fusion_type);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef MAG_CALIBRATOR_HPP
+#define MAG_CALIBRATOR_HPP
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <spsc_ring.hpp>
+
+//online compass (magnetometer) calibration
+//compass samples are passed to a low priority thread that incrementally fits an ellipsoid to them
+//(hard-iron offset and soft-iron matrix), and new coefficients are swapped in atomically whenever the fit improves
+class MagCalibrator
+{
+  public:
+
+    //constructors and destructors
+    MagCalibrator(double min_spacing, double forgetting_factor, int min_samples, double max_residual, double max_axis_ratio, double prior_weight);
+    ~MagCalibrator();
+
+    //get functions
+    bool isCalibrated() const; //returns true once a fit has been accepted
+    unsigned int getUpdateCount() const; //number of fits accepted so far
+    double getResidual() const; //RMS algebraic residual of accepted fit
+    void getCalibration(double offset[3], double matrix[9]) const; //hard-iron offset [input units] and soft-iron matrix (row major)
+
+    //other functions
+    void start(); //start calibration thread
+    void stop(); //stop calibration thread
+    void addSample(double x, double y, double z); //queue compass sample for fitting (drops sample if calibration thread is behind)
+    void correct(double& x, double& y, double& z) const; //apply current calibration to compass sample
+
+  private:
+
+    //compass sample passed to calibration thread
+    struct Sample
+    {
+      double x;
+      double y;
+      double z;
+    };
+
+    //calibration coefficients, never modified after being published
+    struct Calibration
+    {
+      double offset[3];
+      double matrix[9];
+      double quadric[9]; //fitted quadric in normalized coordinates
+      double residual;
+    };
+
+    //settings
+    double _forgetting_factor;
+    double _max_axis_ratio;
+    double _max_residual;
+    double _min_spacing;
+    int _min_samples;
+    double _prior_weight;
+
+    //published calibration (shared_ptr accessed with atomic_load/atomic_store)
+    std::shared_ptr<const Calibration> _calibration;
+    std::atomic<unsigned int> _update_count;
+
+    //calibration thread
+    SPSCRing<Sample, 256> _samples;
+    std::thread _thread;
+    std::atomic<bool> _running;
+
+    //fit state (calibration thread only)
+    double _dtd[9][9]; //weighted sum of D^T D
+    double _dt1[9]; //weighted sum of D^T 1
+    double _weight; //weighted number of accepted samples
+    double _last[3]; //last accepted sample
+    double _prior[9]; //quadric the fit is regularized towards
+    double _scale; //normalization of samples to unit field strength [input units]
+    int _accepted; //accepted samples since last fit
+    int _count; //accepted samples in total
+
+    void run();
+    void accumulate(const Sample& sample);
+    bool fit(Calibration& calibration);
+    double residual(const double quadric[9]);
+
+};
+
+#endif
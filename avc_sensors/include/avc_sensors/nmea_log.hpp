@@ -0,0 +1,39 @@
+#ifndef NMEA_LOG_HPP
+#define NMEA_LOG_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+//binary log of raw GPS serial bytes
+//file starts with an 8 byte magic string followed by chunks of bytes as they were read, each with its arrival time,
+//so a replay reproduces the receiver's sentence boundaries, bursts, and timing as well as its content
+class NmeaLog
+{
+  public:
+
+    //chunk header as stored in log, followed by length bytes
+    struct Record
+    {
+      uint64_t timestamp; //arrival time [us since epoch]
+      uint32_t length;
+    };
+
+    //constructors and destructors
+    NmeaLog();
+    ~NmeaLog();
+
+    //other functions
+    bool openRead(const std::string& file_name); //returns false if file can't be opened or isn't an NMEA log
+    bool openWrite(const std::string& file_name); //returns false if file can't be created
+    bool read(char *buffer, size_t size, size_t& length, uint64_t& timestamp); //read next chunk (truncated to size), returns false at end of log
+    bool write(const char *data, size_t length, uint64_t timestamp); //append chunk, returns false on write error
+    void close();
+
+  private:
+    FILE *_file;
+
+};
+
+#endif
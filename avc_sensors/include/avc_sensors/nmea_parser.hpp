@@ -0,0 +1,89 @@
+#ifndef NMEA_PARSER_HPP
+#define NMEA_PARSER_HPP
+
+#include <stddef.h>
+
+//longest valid NMEA sentence including "$" and "\r\n" is 82 characters, some receivers exceed it slightly
+const size_t NMEA_MAX_SENTENCE_LENGTH = 96;
+
+//frames NMEA sentences from a raw serial byte stream
+//bytes are read directly into a fixed buffer, sentences are found and checksum verified in place and returned as pointers into the buffer,
+//so no sentence is ever copied or allocated; only the unfinished tail of the buffer (at most one sentence) is moved to the front before each read
+class NmeaFramer
+{
+  public:
+
+    static const size_t BUFFER_SIZE = 512;
+
+    //constructors and destructors
+    NmeaFramer();
+    ~NmeaFramer();
+
+    //get functions
+    unsigned int getChecksumErrors() const; //sentences dropped for invalid checksum
+    unsigned int getOverflows() const; //sentences dropped for exceeding maximum length
+    char* getWriteBuffer(size_t& size); //free space to read new bytes into, valid until commit()
+
+    //other functions
+    void commit(size_t count); //mark count bytes of write buffer as received
+    bool next(const char*& sentence, size_t& length); //get next valid sentence ("$" to checksum, no line ending), valid until next getWriteBuffer()
+    void reset(); //discard all buffered bytes
+
+  private:
+    char _buffer[BUFFER_SIZE];
+    size_t _end; //end of received bytes
+    size_t _scan; //position up to which current sentence has been searched for a line ending
+    size_t _start; //start of current (unfinished) sentence
+    unsigned int _checksum_errors;
+    unsigned int _overflows;
+
+};
+
+//sentence types handled by parser
+enum NmeaSentenceType
+{
+  NMEA_UNKNOWN,
+  NMEA_GGA,
+  NMEA_RMC
+};
+
+//fix data from GGA sentence
+struct NmeaGGA
+{
+  bool has_time;
+  double utc_time; //time of day [s since midnight UTC]
+  double latitude; //[deg, north positive]
+  double longitude; //[deg, east positive]
+  int fix_type; //0 = no fix, 1 = GPS, 2 = DGPS, 4/5 = RTK, 9 = WAAS
+  int satellites;
+  double hdop;
+  double altitude; //above mean sea level [m]
+  double geoid_separation; //mean sea level above ellipsoid [m]
+};
+
+//minimum navigation data from RMC sentence
+struct NmeaRMC
+{
+  bool has_time;
+  double utc_time; //time of day [s since midnight UTC]
+  bool fix_valid;
+  double latitude; //[deg, north positive]
+  double longitude; //[deg, east positive]
+  double speed; //[m/s]
+  double course; //true course [rad]
+  bool has_date;
+  int day;
+  int month;
+  int year; //four digit year
+};
+
+//allocation-free NMEA sentence parsing, sentence is given as returned by NmeaFramer
+//empty or malformed numeric fields are returned as NaN (as the Python nmea_navsat_driver does)
+NmeaSentenceType getNmeaSentenceType(const char *sentence, size_t length);
+bool parseGGA(const char *sentence, size_t length, NmeaGGA& gga); //returns false if sentence isn't a GGA sentence
+bool parseRMC(const char *sentence, size_t length, NmeaRMC& rmc); //returns false if sentence isn't an RMC sentence
+
+//format sentence from body (without "$" and checksum) as "$body*hh\r\n", returns sentence length or 0 if it doesn't fit into buffer
+size_t formatNmeaSentence(const char *body, char *buffer, size_t size);
+
+#endif
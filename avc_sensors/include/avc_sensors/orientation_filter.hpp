@@ -0,0 +1,107 @@
+#ifndef ORIENTATION_FILTER_HPP
+#define ORIENTATION_FILTER_HPP
+
+#include <string>
+
+//orientation filter interface
+//estimates orientation from raw gyro [rad/s], accelerometer, and compass samples (accelerometer and compass in any consistent unit)
+//samples are in RTIMULib's NED convention as imu_node passes them (x forward, y right, z down, so a left turn gives a negative z gyro
+//rate), and orientation is the rotation from sensor frame to a north-east-down earth frame, as a quaternion
+template <typename T>
+class OrientationFilter
+{
+  public:
+
+    //constructors and destructors
+    OrientationFilter();
+    virtual ~OrientationFilter();
+
+    //get functions
+    void getQuaternion(T& w, T& x, T& y, T& z) const;
+    T getRoll() const; //[rad]
+    T getPitch() const; //[rad]
+    T getYaw() const; //[rad], positive values indicate CW rotation from magnetic north
+    bool isInitialized() const;
+
+    //other functions
+    //update orientation with sample taken dt seconds after previous one [s]
+    //a zero compass vector updates orientation from gyro and accelerometer only
+    void update(T gx, T gy, T gz, T ax, T ay, T az, T mx, T my, T mz, T dt);
+    virtual void reset();
+
+  protected:
+    T _q0; //quaternion scalar
+    T _q1;
+    T _q2;
+    T _q3;
+
+    //filter specific correction and integration step (accelerometer and compass are non-zero when passed)
+    virtual void step(T gx, T gy, T gz, T ax, T ay, T az, T mx, T my, T mz, T dt) = 0;
+    void integrateGyro(T gx, T gy, T gz, T dt);
+    void normalizeQuaternion();
+
+  private:
+    bool _initialized;
+
+    //set orientation directly from accelerometer and compass (first sample)
+    bool initialize(T ax, T ay, T az, T mx, T my, T mz);
+
+};
+
+//Madgwick gradient descent orientation filter
+//beta is the gyro measurement error [rad/s] that the accelerometer/compass correction compensates (larger values = faster correction, more noise)
+template <typename T>
+class MadgwickFilter : public OrientationFilter<T>
+{
+  public:
+
+    //constructors and destructors
+    MadgwickFilter(T beta);
+    ~MadgwickFilter();
+
+    //set functions
+    void setBeta(T beta);
+
+  protected:
+    void step(T gx, T gy, T gz, T ax, T ay, T az, T mx, T my, T mz, T dt);
+
+  private:
+    T _beta;
+
+};
+
+//Mahony complementary orientation filter
+//kp and ki are the proportional and integral gains applied to the accelerometer/compass error (integral term estimates gyro bias)
+template <typename T>
+class MahonyFilter : public OrientationFilter<T>
+{
+  public:
+
+    //constructors and destructors
+    MahonyFilter(T kp, T ki);
+    ~MahonyFilter();
+
+    //set functions
+    void setGains(T kp, T ki);
+
+    //other functions
+    void reset();
+
+  protected:
+    void step(T gx, T gy, T gz, T ax, T ay, T az, T mx, T my, T mz, T dt);
+
+  private:
+    T _kp;
+    T _ki;
+    T _integral_x; //integral of error [rad/s]
+    T _integral_y;
+    T _integral_z;
+
+};
+
+//create orientation filter of named type (madgwick or mahony) with given gains, returns NULL for unknown types
+//madgwick uses gain_1 as beta, mahony uses gain_1 as kp and gain_2 as ki
+template <typename T>
+OrientationFilter<T>* createOrientationFilter(const std::string& type, T gain_1, T gain_2);
+
+#endif
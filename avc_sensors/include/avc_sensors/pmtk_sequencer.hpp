@@ -0,0 +1,60 @@
+#ifndef PMTK_SEQUENCER_HPP
+#define PMTK_SEQUENCER_HPP
+
+#include <string>
+#include <vector>
+#include <nmea_parser.hpp>
+#include <serial_port.hpp>
+
+//sends PMTK configuration commands to an MTK GPS chip one at a time
+//each command is resent until the chip acknowledges it with $PMTK001 or the attempts run out, so setup takes as long as the chip needs to answer
+//instead of a fixed delay per command, and a command the chip rejects or never answers is reported instead of ignored
+class PmtkSequencer
+{
+  public:
+
+    //acknowledgement flags of $PMTK001 replies, and results of commands that got no reply
+    enum Result
+    {
+      WRITE_FAILED = -2,
+      NO_REPLY = -1,
+      INVALID_COMMAND = 0,
+      UNSUPPORTED_COMMAND = 1,
+      ACTION_FAILED = 2,
+      ACTION_SUCCEEDED = 3
+    };
+
+    //NMEA output observed from chip
+    struct Output
+    {
+      bool rmc;
+      bool gga;
+      bool other; //any other NMEA sentence
+      int update_interval; //average time between RMC sentences [ms] (0 if fewer than two were received)
+    };
+
+    //constructors and destructors
+    PmtkSequencer(SerialPort *port, int ack_timeout, int attempts);
+    ~PmtkSequencer();
+
+    //get functions
+    static const char* getResultName(Result result);
+
+    //other functions
+    Result sendCommand(const char *command); //send command body (without "$" and checksum, e.g. "PMTK220,100") until acknowledged
+    int detectBaudRate(const std::string& device, const std::vector<int>& baud_rates, int timeout); //returns first baud rate with valid sentences within timeout [ms] (port is left open at it), or 0
+    bool observeOutput(int timeout, Output& output); //watch NMEA output for three RMC sentences or until timeout [ms], returns false if no sentence was received
+    bool setBaudRate(const std::string& device, int baud_rate, int timeout); //switch chip and port to baud rate, returns true once a valid sentence is received at the new rate
+    bool waitForSentence(int timeout); //returns true once a sentence with valid checksum is received within timeout [ms]
+
+  private:
+    Result waitForAck(int command, int timeout);
+
+    int _ack_timeout; //[ms]
+    int _attempts;
+    NmeaFramer _framer;
+    SerialPort *_port;
+
+};
+
+#endif
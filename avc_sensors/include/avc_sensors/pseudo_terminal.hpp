@@ -0,0 +1,33 @@
+#ifndef PSEUDO_TERMINAL_HPP
+#define PSEUDO_TERMINAL_HPP
+
+#include <string>
+
+//pseudo terminal standing in for a serial device
+//programs under test open the slave side (optionally through a symbolic link) exactly like a serial port, while the master side is
+//written to and read from by the emulator; the slave side is also held open internally, so the master stays usable while they reopen it
+class PseudoTerminal
+{
+  public:
+
+    //constructors and destructors
+    PseudoTerminal();
+    ~PseudoTerminal();
+
+    //get functions
+    int getBaudRate() const; //baud rate slave side is currently set to (0 if unknown)
+    int getFileDescriptor() const; //master side
+    std::string getSlaveName() const;
+
+    //other functions
+    bool open(const std::string& link_path); //create pseudo terminal and symbolic link to slave side (no link if path is empty)
+    void close(); //close pseudo terminal and remove symbolic link
+
+  private:
+    int _master;
+    int _slave;
+    std::string _link_path;
+
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef RANGING_SCHEDULER_HPP
+#define RANGING_SCHEDULER_HPP
+
+#include <string>
+
+//scales the firing rate of one proximity sensor with commanded throttle and steering
+//sensors that matter for the current motion are fired up to the maximum rate, all others fall back to the idle rate
+class RangingScheduler
+{
+  public:
+
+    //sensor mounting positions
+    enum Position
+    {
+      FRONT,
+      LEFT,
+      RIGHT
+    };
+
+    //constructors and destructors
+    RangingScheduler(Position position, double idle_rate, double max_rate, double min_cycle_time, double full_rate_throttle, double side_rate_floor, double max_steering_angle);
+    ~RangingScheduler();
+
+    //set functions
+    void setSteeringAngle(double steering_angle); //[deg], positive values indicate CCW (left) rotation
+    void setThrottlePercent(double throttle_percent); //[%], negative values indicate reverse
+
+    //get functions
+    double getImportance(); //relevance of sensor to current motion [0 to 1]
+    double getPeriod(); //time until next reading [s]
+    double getRate(); //current firing rate [Hz]
+
+    //other functions
+    static bool parsePosition(const std::string& name, Position& position); //convert position name (front, left, right) to position
+
+  private:
+    double _full_rate_throttle;
+    double _idle_rate;
+    double _max_rate;
+    double _max_steering_angle;
+    double _side_rate_floor;
+    double _steering_angle;
+    double _throttle_percent;
+    Position _position;
+
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef SERIAL_PORT_HPP
+#define SERIAL_PORT_HPP
+
+#include <stddef.h>
+#include <string>
+#include <sys/types.h>
+
+//raw (non-canonical) serial port using termios
+//reads block for at most a given timeout, so a single thread can service the port without busy waiting
+class SerialPort
+{
+  public:
+
+    //constructors and destructors
+    SerialPort();
+    ~SerialPort();
+
+    //get functions
+    int getBaudRate() const;
+    int getFileDescriptor() const;
+    bool isOpen() const;
+
+    //other functions
+    bool open(const std::string& device, int baud_rate); //returns false if device can't be opened or baud rate isn't supported
+    void close();
+    void drain(); //wait until all output has been transmitted
+    void flush(); //discard unread input and unsent output
+    ssize_t read(char *buffer, size_t size, int timeout); //read available bytes, waiting up to timeout [ms] for the first, returns -1 on error
+    bool write(const char *data, size_t length); //write all bytes, returns false on error
+
+  private:
+    int _baud_rate;
+    int _fd;
+
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <atomic>
+#include <stddef.h>
+
+//lock-free single-producer/single-consumer ring buffer
+//one thread (e.g. an interrupt callback) may push while one other thread pops, without locks or allocation
+//N must be a power of two; the ring holds at most N - 1 elements
+template <typename T, size_t N>
+class SPSCRing
+{
+  static_assert((N >= 2) && ((N & (N - 1)) == 0), "SPSCRing size must be a power of two");
+
+  public:
+
+    SPSCRing() : _head(0), _tail(0) {}
+
+    //add element to ring (producer thread only)
+    //returns false without modifying the ring if it is full
+    bool push(const T& element)
+    {
+
+      size_t head = this->_head.load(std::memory_order_relaxed);
+      size_t next = (head + 1) & (N - 1);
+
+      //ring is full when advancing head would reach tail
+      if (next == this->_tail.load(std::memory_order_acquire))
+        return false;
+
+      //write element before publishing new head to consumer
+      this->_buffer[head] = element;
+      this->_head.store(next, std::memory_order_release);
+
+      return true;
+
+    }
+
+    //remove oldest element from ring (consumer thread only)
+    //returns false if the ring is empty
+    bool pop(T& element)
+    {
+
+      size_t tail = this->_tail.load(std::memory_order_relaxed);
+
+      //ring is empty when tail has caught up with head
+      if (tail == this->_head.load(std::memory_order_acquire))
+        return false;
+
+      //read element before releasing its slot to producer
+      element = this->_buffer[tail];
+      this->_tail.store((tail + 1) & (N - 1), std::memory_order_release);
+
+      return true;
+
+    }
+
+    //get number of elements currently in ring (approximate while the other thread is active)
+    size_t size() const
+    {
+      return (this->_head.load(std::memory_order_acquire) - this->_tail.load(std::memory_order_acquire)) & (N - 1);
+    }
+
+    bool empty() const
+    {
+      return this->size() == 0;
+    }
+
+  private:
+    T _buffer[N];
+    std::atomic<size_t> _head; //next slot to write (owned by producer)
+    std::atomic<size_t> _tail; //next slot to read (owned by consumer)
+
+};
+
+#endif
@@ -1,14 +1,26 @@
-//ROS includes
+//encoder node
+//samples all four wheel encoders on one shared timestamp and publishes their angular velocities in one message
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+#include <encoder_velocity_estimator.hpp>
+#include <spsc_ring.hpp>
 #include <ros/ros.h>
-#include <avc_msgs/Encoder.h>
+#include <avc_msgs/WheelEncoders.h>
 #include <signal.h>
 #include <wiringPi.h>
 
+//size of encoder edge timestamp ring buffers (must be a power of two)
+const size_t EDGE_RING_SIZE = 256;
+
+//number of wheels and their parameter names, in message field order
+const int WHEEL_NUM = 4;
+const char *WHEEL_NAMES[WHEEL_NUM] = { "fl", "fr", "rl", "rr" };
+
 //global variables
-//unsigned int encoder_samples[ENCODER_SAMPLE_NUM];
-//volatile unsigned int encoder_sample = 0;
-//volatile unsigned int last_pulse_time = 0;
-volatile unsigned int encoder_pulses = 0;
+//edge timestamps are pushed by the interrupt callback threads and popped by the publish loop (one ring per wheel)
+SPSCRing<uint32_t, EDGE_RING_SIZE> encoder_edges[WHEEL_NUM];
+std::atomic<unsigned int> lost_edges[WHEEL_NUM];
 
 
 //callback function called to process SIGINT command
@@ -20,65 +32,20 @@ void sigintHandler(int sig)
 
 }
 
+//callback function called by wiringPi interrupt thread on encoder rising edge
+//wiringPi callbacks take no arguments, so one instance is generated per wheel
+template <int WHEEL>
 void encoderInterruptCallback()
 {
 
-  //capture current pulse time, set sample time to time since current and last pulse, then update last pulse time
-  /*unsigned int current_pulse_time = millis();
-  encoder_sample = current_pulse_time - last_pulse_time;
-  last_pulse_time = current_pulse_time;*/
-  if (encoder_pulses < 4294967295)
-    encoder_pulses++;
-  else
-    encoder_pulses = 0;
+  //record edge time, counting the edge as lost if the publish loop has fallen behind
+  if (!encoder_edges[WHEEL].push(micros()))
+    lost_edges[WHEEL]++;
 
 }
 
-//sample velocity ENCODER_SAMPLE_NUM times and return average result
-float getVelocity(int cpr, int sample_num, int refresh_rate)
-{
-
-
-  //calculate average sample time over last sample_num samples
-  int num_pulses = 0;
-  float start_time = millis();
-  for (int i = 0; i < sample_num; i++)
-  {
-    num_pulses += encoder_pulses;
-    encoder_pulses = 0;
-    delay((1000 / refresh_rate) / (sample_num * 1.25));
-  }
-
-  //calculate velocity in rotations per second from sample time and counts per rev
-  float velocity = num_pulses / ((millis() - start_time) / 1000); // [pulses/s]
-  velocity =  (velocity / cpr) * 2 * 3.14159265359; // [rad/s]
-
-  //return angular velocity in radians per second
-  return velocity;
-
-}
-
-//CPU intensive option
-/*void encoderInterruptCallback()
-{
-
-  //capture current pulse time
-  unsigned int current_pulse_time = millis();
-
-  //shift existing samples in array
-  for (int i = 0; i < (ENCODER_SAMPLE_NUM - 1); i++)
-  {
-    encoder_samples[i+1] = encoder_samples[i];
-  }
-
-  //set newest encoder sample if this isn't the first pulse received
-  if (last_pulse_time != 0)
-    encoder_samples[0] = current_pulse_time - last_pulse_time;
-
-  //set last pulse time to current pulse time for next iteration
-  last_pulse_time = current_pulse_time;
-
-}*/
+//interrupt callbacks in wheel order
+void (*const ENCODER_CALLBACKS[WHEEL_NUM])() = { encoderInterruptCallback<0>, encoderInterruptCallback<1>, encoderInterruptCallback<2>, encoderInterruptCallback<3> };
 
 int main(int argc, char **argv)
 {
@@ -94,70 +61,76 @@ int main(int argc, char **argv)
   //override the default SIGINT handler
   signal(SIGINT, sigintHandler);
 
-  //if correct number of arguments has been passed to node, capture arguments and convert to strings
-  std::string position_arg;
-  if (argc == 3)
-  {
-    position_arg = boost::lexical_cast<std::string>(argv[1]) + boost::lexical_cast<std::string>(argv[2]);
-  }
-  else
+  //retrieve counts per rev parameter from parameter server
+  int counts_per_rev;
+  if (!node_private.getParam("/sensor/encoder/counts_per_rev", counts_per_rev))
   {
-    ROS_ERROR("[ERROR] encoder_pub_node received incorrect number of arguments");
+    ROS_ERROR("[encoder_node] counts per rev not defined in config file: avc_sensors/config/sensors.yaml");
     ROS_BREAK();
   }
 
-  //set encoder path for retrieving parameters from parameter server for this node
-  std::string encoder_name = position_arg + "_encoder";
-  std::string encoder_path = "/sensor/encoder/" + position_arg;
-  ROS_INFO("encoder name: %s", encoder_name.c_str());
-  ROS_INFO("encoder path: %s", encoder_path.c_str());
-
-  //retrieve input pin parameter from parameter server
-  int counts_per_rev;
-  if (!node_private.getParam(encoder_path + "/counts_per_rev", counts_per_rev))
+  //retrieve refresh rate of sensor in hertz from prameter server
+  float refresh_rate;
+  if (!node_private.getParam("/sensor/encoder/refresh_rate", refresh_rate))
   {
-    ROS_ERROR("[encoder_node] counts per rev not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_ERROR("[encoder_node] encoder refresh rate not defined in config file: avc_sensors/config/sensors.yaml");
     ROS_BREAK();
   }
 
-  //retrieve input pin parameter from parameter server
-  int input_pin;
-  if (!node_private.getParam(encoder_path + "/input_pin", input_pin))
+  //retrieve number of edges per publish interval above which edges are counted instead of timed
+  int count_threshold;
+  if (!node_private.getParam("/sensor/encoder/count_threshold", count_threshold))
   {
-    ROS_ERROR("[encoder_node] encoder input pin not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_ERROR("[encoder_node] encoder count threshold not defined in config file: avc_sensors/config/sensors.yaml");
     ROS_BREAK();
   }
 
-  //retrieve refresh rate of sensor in hertz from prameter server
-  float refresh_rate;
-  if (!node_private.getParam(encoder_path + "/refresh_rate", refresh_rate))
+  //retrieve time without edges after which a wheel is considered stopped [s]
+  float timeout;
+  if (!node_private.getParam("/sensor/encoder/timeout", timeout))
   {
-    ROS_ERROR("[encoder_node] encoder refresh rate not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_ERROR("[encoder_node] encoder timeout not defined in config file: avc_sensors/config/sensors.yaml");
     ROS_BREAK();
   }
 
-  //retrieve input pin parameter from parameter server
-  int sample_num;
-  if (!node_private.getParam(encoder_path + "/sample_num", sample_num))
+  //retrieve input pin of each wheel encoder from parameter server
+  int input_pins[WHEEL_NUM];
+  for (int i = 0; i < WHEEL_NUM; i++)
   {
-    ROS_ERROR("[encoder_node] number of samples to use not defined in config file: avc_sensors/config/sensors.yaml");
-    ROS_BREAK();
+    if (!node_private.getParam("/sensor/encoder/" + std::string(WHEEL_NAMES[i]) + "/input_pin", input_pins[i]))
+    {
+      ROS_ERROR("[encoder_node] %s encoder input pin not defined in config file: avc_sensors/config/sensors.yaml", WHEEL_NAMES[i]);
+      ROS_BREAK();
+    }
   }
 
   //call wiringPi setup function
   wiringPiSetup();
 
-  //set pinMode of input pin to INPUT
-  pinMode(input_pin, INPUT);
+  //create velocity estimator for processing edge timestamps of each wheel
+  std::vector<EncoderVelocityEstimator> estimators(WHEEL_NUM, EncoderVelocityEstimator(counts_per_rev, count_threshold, timeout));
 
-  //register interrupt function to be called when sensor input pin rising edge goes HIGH
-  wiringPiISR(input_pin, INT_EDGE_RISING, encoderInterruptCallback);
+  //set up each wheel encoder input
+  for (int i = 0; i < WHEEL_NUM; i++)
+  {
+
+    //clear lost edge count before interrupts are enabled
+    lost_edges[i] = 0;
+
+    //set pinMode of input pin to INPUT
+    pinMode(input_pins[i], INPUT);
+
+    //register interrupt function to be called when sensor input pin rising edge goes HIGH
+    wiringPiISR(input_pins[i], INT_EDGE_RISING, ENCODER_CALLBACKS[i]);
+
+  }
 
-  //create sensor_msgs/Range type message to publish proximity sensor data
-  avc_msgs::Encoder encoder_msg;
+  //create avc_msgs/WheelEncoders type message to publish encoder data
+  avc_msgs::WheelEncoders encoder_msg;
+  encoder_msg.header.frame_id = "base_link";
 
-  //create publisher to publish proximity sensor message with buffer size 10, and latch set to false
-  ros::Publisher encoder_pub = node_public.advertise<avc_msgs::Encoder>(encoder_name, 10, false);
+  //create publisher to publish encoder message with buffer size 10, and latch set to false
+  ros::Publisher encoder_pub = node_public.advertise<avc_msgs::WheelEncoders>("wheel_encoders", 10, false);
 
   //set refresh rate of ROS loop to defined refresh rate of sensor parameter
   ros::Rate loop_rate(refresh_rate);
@@ -165,13 +138,35 @@ int main(int argc, char **argv)
   while (ros::ok())
   {
 
-    //set encoder message angular velocity value to current value reported from encoder [rad/s]
-    encoder_msg.angular_velocity = getVelocity(counts_per_rev, sample_num, refresh_rate);
+    //take one sample time shared by all wheels
+    encoder_msg.header.stamp = ros::Time::now();
+    uint32_t sample_time = micros();
+
+    //estimate angular velocity of each wheel at sample time [rad/s]
+    float velocities[WHEEL_NUM];
+    for (int i = 0; i < WHEEL_NUM; i++)
+    {
+
+      //pass edges recorded by interrupt callback since last cycle to estimator
+      uint32_t edge_time;
+      while (encoder_edges[i].pop(edge_time))
+        estimators[i].addEdge(edge_time);
+      estimators[i].addLostEdges(lost_edges[i].exchange(0));
+
+      velocities[i] = estimators[i].estimate(sample_time);
+
+    }
+
+    //set encoder message angular velocities
+    encoder_msg.front_left = velocities[0];
+    encoder_msg.front_right = velocities[1];
+    encoder_msg.rear_left = velocities[2];
+    encoder_msg.rear_right = velocities[3];
 
-    //add ROS_INFO output to display current proximity sensor range to terminal (for testing)
-    //ROS_INFO("current angular velocity: %f", encoder_msg.angular_velocity);
+    //add ROS_INFO output to display current angular velocities to terminal (for testing)
+    //ROS_INFO("current angular velocities: %f, %f, %f, %f", velocities[0], velocities[1], velocities[2], velocities[3]);
 
-    //publish proximity sensor range message
+    //publish encoder message
     encoder_pub.publish(encoder_msg);
 
     //process callback functions
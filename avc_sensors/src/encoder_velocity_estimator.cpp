@@ -0,0 +1,117 @@
+//include header
+#include <encoder_velocity_estimator.hpp>
+
+//math constants
+const double PI = 3.1415926535897;
+
+
+//default constructor
+EncoderVelocityEstimator::EncoderVelocityEstimator(int counts_per_rev, int count_threshold, double timeout)
+{
+
+  //set class variable values to passed values
+  this->_counts_per_rev = counts_per_rev;
+  this->_count_threshold = count_threshold;
+  this->_timeout = timeout;
+
+  //initialize other variables
+  this->_velocity = 0;
+  this->_have_last_edge = false;
+  this->_have_last_estimate = false;
+  this->_have_reference_edge = false;
+  this->_first_edge = 0;
+  this->_last_edge = 0;
+  this->_last_estimate = 0;
+  this->_reference_edge = 0;
+  this->_edges = 0;
+  this->_lost_edges = 0;
+
+}
+
+//default destructor
+EncoderVelocityEstimator::~EncoderVelocityEstimator() {}
+
+//other functions
+
+//record an encoder edge [us]
+void EncoderVelocityEstimator::addEdge(uint32_t timestamp)
+{
+
+  //first edge since last estimate starts a new set of periods, measured from the previous edge if there is one
+  if (this->_edges == 0)
+  {
+    this->_first_edge = timestamp;
+    this->_reference_edge = this->_last_edge;
+    this->_have_reference_edge = this->_have_last_edge;
+  }
+
+  this->_last_edge = timestamp;
+  this->_have_last_edge = true;
+  this->_edges++;
+
+}
+
+//record edges that occurred but have no timestamp (e.g. edge buffer overflow)
+void EncoderVelocityEstimator::addLostEdges(unsigned int count)
+{
+  this->_lost_edges += count;
+}
+
+//estimate angular velocity at time now from edges recorded since last estimate [rad/s]
+double EncoderVelocityEstimator::estimate(uint32_t now)
+{
+
+  //edge rate [edges/s]
+  double edge_rate = -1;
+
+  //high edge rate or lost timestamps: count edges over the time since the last estimate
+  if (this->_have_last_estimate && (((this->_edges + this->_lost_edges) >= (unsigned int)this->_count_threshold) || (this->_lost_edges > 0)))
+  {
+    uint32_t window = now - this->_last_estimate;
+    if (window > 0)
+      edge_rate = (this->_edges + this->_lost_edges) / (window / 1000000.0);
+  }
+  //low edge rate: use periods between edges, measured from the last edge before this window if available
+  else if ((this->_edges > 0) && this->_have_reference_edge)
+  {
+    uint32_t elapsed = this->_last_edge - this->_reference_edge;
+    if (elapsed > 0)
+      edge_rate = this->_edges / (elapsed / 1000000.0);
+  }
+  else if (this->_edges > 1)
+  {
+    uint32_t elapsed = this->_last_edge - this->_first_edge;
+    if (elapsed > 0)
+      edge_rate = (this->_edges - 1) / (elapsed / 1000000.0);
+  }
+
+  //convert edge rate to angular velocity
+  if (edge_rate >= 0)
+    this->_velocity = (edge_rate / this->_counts_per_rev) * 2 * PI;
+  //no new edges: the next edge can't come sooner than now, so velocity is at most one edge over the time since the last edge
+  else if (this->_edges == 0)
+  {
+
+    double since_last_edge = this->_have_last_edge ? (uint32_t)(now - this->_last_edge) / 1000000.0 : this->_timeout;
+
+    //wheel is considered stopped when no edge has been seen within timeout
+    if (since_last_edge >= this->_timeout)
+      this->_velocity = 0;
+    else if (since_last_edge > 0)
+    {
+      double bound = ((1 / since_last_edge) / this->_counts_per_rev) * 2 * PI;
+      if (bound < this->_velocity)
+        this->_velocity = bound;
+    }
+
+  }
+
+  //reset window
+  this->_edges = 0;
+  this->_lost_edges = 0;
+  this->_last_estimate = now;
+  this->_have_last_estimate = true;
+
+  return this->_velocity;
+
+}
@@ -0,0 +1,207 @@
+//fake GPS
+//emulates an MTK GPS chip on a pseudo terminal so GPS setup and ingest can be tested without hardware
+//the chip answers PMTK314 (output sentences), PMTK220 (update rate), PMTK300 (fix rate), and PMTK251 (baud rate) commands like the real one,
+//and outputs garbage instead of sentences while the pseudo terminal is set to a different baud rate than the chip
+//usage: rosrun avc_sensors fake_gps [link_path] [baud_rate] [drop_rate]
+#include <chrono>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <nmea_parser.hpp>
+#include <pseudo_terminal.hpp>
+
+//global variables
+volatile sig_atomic_t running = 1;
+
+
+//signal handler called to stop emulation
+void signalHandler(int sig)
+{
+  running = 0;
+}
+
+//write bytes to pseudo terminal
+//like a real chip the fake one keeps talking when nobody listens, so output that doesn't fit into the terminal buffer is dropped
+void writeBytes(int fd, const char *data, size_t length)
+{
+
+  ssize_t count = write(fd, data, length);
+  (void)count;
+
+}
+
+//write sentence with checksum and line ending
+void writeSentence(int fd, const char *body)
+{
+
+  char sentence[NMEA_MAX_SENTENCE_LENGTH + 1];
+  writeBytes(fd, sentence, formatNmeaSentence(body, sentence, sizeof(sentence)));
+
+}
+
+int main(int argc, char **argv)
+{
+
+  if (argc > 4)
+  {
+    fprintf(stderr, "usage: fake_gps [link_path] [baud_rate] [drop_rate]\n");
+    return 1;
+  }
+
+  //get symbolic link to create for pseudo terminal, chip baud rate at power up, and fraction of commands to ignore (to exercise retries)
+  const char *link_path = (argc >= 2) ? argv[1] : "/tmp/fake_gps";
+  int baud_rate = (argc >= 3) ? atoi(argv[2]) : 9600;
+  double drop_rate = (argc >= 4) ? atof(argv[3]) : 0;
+
+  //create pseudo terminal with symbolic link the program under test opens like a serial device
+  PseudoTerminal terminal;
+  if (!terminal.open(link_path))
+  {
+    fprintf(stderr, "failed to create pseudo terminal linked to %s\n", link_path);
+    return 1;
+  }
+  int master = terminal.getFileDescriptor();
+
+  signal(SIGINT, signalHandler);
+  signal(SIGTERM, signalHandler);
+
+  printf("fake GPS on %s (%s) at %d baud\n", link_path, terminal.getSlaveName().c_str(), baud_rate);
+
+  //chip state, MTK chips power up sending GGA, GSA, GSV, and RMC sentences once per second
+  int update_interval = 1000; //[ms]
+  bool output_rmc = true;
+  bool output_gga = true;
+  bool output_gsa = true;
+  bool output_gsv = true;
+
+  NmeaFramer framer;
+  char body[128];
+  std::chrono::steady_clock::time_point next_update = std::chrono::steady_clock::now();
+  srand(time(NULL));
+
+  while (running)
+  {
+
+    //wait for commands until next update is due
+    int timeout = std::chrono::duration_cast<std::chrono::milliseconds>(next_update - std::chrono::steady_clock::now()).count();
+    struct pollfd descriptor;
+    descriptor.fd = master;
+    descriptor.events = POLLIN;
+    descriptor.revents = 0;
+    if ((timeout > 0) && (poll(&descriptor, 1, timeout) > 0) && (descriptor.revents & POLLIN))
+    {
+
+      size_t size;
+      char *buffer = framer.getWriteBuffer(size);
+      ssize_t count = read(master, buffer, size);
+      if (count <= 0)
+        continue;
+
+      //chip can't decode commands sent at a different baud rate
+      if (terminal.getBaudRate() != baud_rate)
+      {
+        framer.reset();
+        continue;
+      }
+      framer.commit(count);
+
+      const char *sentence;
+      size_t length;
+      while (framer.next(sentence, length))
+      {
+
+        if ((strncmp(sentence, "$PMTK", 5) != 0) || ((double)rand() / RAND_MAX < drop_rate))
+          continue;
+
+        int command = atoi(sentence + 5);
+        const char *arguments = sentence + 8;
+        int flag = 3;
+        switch (command)
+        {
+          case 220:
+            update_interval = atoi(arguments + 1);
+            flag = ((update_interval >= 100) && (update_interval <= 10000)) ? 3 : 2;
+            if (flag != 3)
+              update_interval = 1000;
+            break;
+          case 251:
+            //baud rate changes take effect without acknowledgement
+            baud_rate = atoi(arguments + 1);
+            printf("switched to %d baud\n", baud_rate);
+            continue;
+          case 300:
+            break;
+          case 314:
+            //PMTK314,GLL,RMC,VTG,GGA,GSA,GSV,...
+            if (length < 21)
+            {
+              flag = 0;
+              break;
+            }
+            output_rmc = (arguments[3] != '0');
+            output_gga = (arguments[7] != '0');
+            output_gsa = (arguments[9] != '0');
+            output_gsv = (arguments[11] != '0');
+            break;
+          default:
+            flag = 1;
+            break;
+        }
+
+        printf("received %.*s, replying with flag %d\n", (int)length, sentence, flag);
+        snprintf(body, sizeof(body), "PMTK001,%d,%d", command, flag);
+        writeSentence(master, body);
+
+      }
+
+    }
+
+    if (std::chrono::steady_clock::now() < next_update)
+      continue;
+    next_update += std::chrono::milliseconds(update_interval);
+
+    //sentences sent at the wrong baud rate arrive as garbage
+    if (terminal.getBaudRate() != baud_rate)
+    {
+      char garbage[160];
+      for (size_t i = 0; i < sizeof(garbage); i++)
+        garbage[i] = rand();
+      writeBytes(master, garbage, sizeof(garbage));
+      continue;
+    }
+
+    //current UTC time of day and date
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    struct tm utc;
+    gmtime_r(&now.tv_sec, &utc);
+    int hundredths = now.tv_nsec / 10000000;
+
+    //stationary receiver with a good fix
+    if (output_gga)
+    {
+      snprintf(body, sizeof(body), "GPGGA,%02d%02d%02d.%02d,4000.0000,N,10500.0000,W,1,09,0.92,1609.3,M,-21.3,M,,",
+               utc.tm_hour, utc.tm_min, utc.tm_sec, hundredths);
+      writeSentence(master, body);
+    }
+    if (output_gsa)
+      writeSentence(master, "GPGSA,A,3,07,02,26,27,09,04,15,,,,,,1.72,0.92,1.45");
+    if (output_gsv)
+      writeSentence(master, "GPGSV,3,1,11,07,79,048,42,02,51,062,43,26,36,256,42,27,27,138,42");
+    if (output_rmc)
+    {
+      snprintf(body, sizeof(body), "GPRMC,%02d%02d%02d.%02d,A,4000.0000,N,10500.0000,W,0.00,0.00,%02d%02d%02d,,,A",
+               utc.tm_hour, utc.tm_min, utc.tm_sec, hundredths, utc.tm_mday, utc.tm_mon + 1, utc.tm_year % 100);
+      writeSentence(master, body);
+    }
+
+  }
+
+  terminal.close();
+
+  return 0;
+}
@@ -0,0 +1,153 @@
+//filter benchmark
+//measures per-update cost of the streaming filters against the original linked list median filter
+//usage: rosrun avc_sensors filter_benchmark [iterations]
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <filters.hpp>
+
+//macro definitions for median filter (algorithm method)
+#define STOPPER 0 // smaller than any datum
+#define MEDIAN_FILTER_SIZE 7
+
+
+//original median filter from proximity_sensor_node (linked list algorithm, single channel)
+int legacyMedianFilter(int datum)
+{
+
+  struct pair
+  {
+    struct pair *point;                                //Pointers forming list linked in sorted order
+    int value;                                         //Values to sort
+  };
+
+  static struct pair buffer[MEDIAN_FILTER_SIZE] = {0}; //Buffer of nwidth pairs
+  static struct pair *datpoint = buffer;               //Pointer into circular buffer of data
+  static struct pair small = {NULL, STOPPER};          //Chain stopper
+  static struct pair big = {&small, 0};                //Pointer to head (largest) of linked list
+
+  struct pair *successor;                              //Pointer to successor of replaced data item
+  struct pair *scan;                                   //Pointer used to scan down the sorted list
+  struct pair *scanold;                                //Previous value of scan
+  struct pair *median;                                 //Pointer to median
+
+  if (datum == STOPPER)
+    datum = STOPPER + 1;                               //No stoppers allowed
+
+  if ((++datpoint - buffer) >= MEDIAN_FILTER_SIZE)
+    datpoint = buffer;                                 //Increment and wrap data in pointer
+
+  datpoint->value = datum;                             //Copy in new datum
+  successor = datpoint->point;                         //Save pointer to old value's successor
+  median = &big;                                       //Median initially to first in chain
+  scanold = NULL;                                      //Scanold initially null
+  scan = &big;                                         //Points to pointer to first (largest) datum in chain
+
+  //Handle chain-out of first item in chain as special case
+  if (scan->point == datpoint)
+    scan->point = successor;
+
+  scanold = scan;                                      //Save this pointer and
+  scan = scan->point ;                                 //step down chain
+
+  //Loop through the chain, normal loop exit via break
+  for (int i = 0 ; i < MEDIAN_FILTER_SIZE; ++i)
+  {
+
+    //Handle odd-numbered item in chain
+    if (scan->point == datpoint)
+      scan->point = successor;                         //Chain out the old datum
+
+    if (scan->value < datum)                           //If datum is larger than scanned value,
+    {
+      datpoint->point = scanold->point;                //Chain it in here
+      scanold->point = datpoint;                       //Mark it chained in
+      datum = STOPPER;
+    }
+
+    //Step median pointer down chain after doing odd-numbered element
+    median = median->point;                            //Step median pointer
+    if (scan == &small)
+      break;                                           //Break at end of chain
+    scanold = scan;                                    //Save this pointer and
+    scan = scan->point;                                //step down chain
+
+    //Handle even-numbered item in chain.
+    if (scan->point == datpoint)
+      scan->point = successor;
+
+    if (scan->value < datum)
+    {
+      datpoint->point = scanold->point;
+      scanold->point = datpoint;
+      datum = STOPPER;
+    }
+
+    if (scan == &small)
+      break;
+
+    scanold = scan;
+    scan = scan->point;
+  }
+
+ return median->value;
+
+}
+
+//run update function over all samples and print average time per update
+template <typename F>
+void runBenchmark(const char *name, const int *samples, int iterations, F update)
+{
+
+  //accumulate outputs so the compiler can't discard the filter work
+  long long checksum = 0;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+    checksum += update(samples[i]);
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  double elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  printf("%-32s %8.2f ns/update (checksum %lld)\n", name, elapsed_ns / iterations, checksum);
+
+}
+
+int main(int argc, char **argv)
+{
+
+  //get number of iterations from arguments (default one million)
+  int iterations = 1000000;
+  if (argc == 2)
+    iterations = atoi(argv[1]);
+  if (iterations <= 0)
+  {
+    fprintf(stderr, "usage: filter_benchmark [iterations]\n");
+    return 1;
+  }
+
+  //generate simulated sonar ranges in millimeters (20 mm to 4 m with occasional dropouts to max range)
+  int *samples = new int[iterations];
+  srand(1);
+  for (int i = 0; i < iterations; i++)
+    samples[i] = ((rand() % 20) == 0) ? 4000 : 20 + (rand() % 3980);
+
+  //per-instance filters under test
+  MedianFilter<int, MEDIAN_FILTER_SIZE> median_int;
+  MedianFilter<float, MEDIAN_FILTER_SIZE> median_float;
+  HampelFilter<float, MEDIAN_FILTER_SIZE> hampel_float;
+  ExponentialFilter<float> exponential_float(0.3f);
+  AlphaBetaFilter<float> alpha_beta_float(0.5f, 0.1f);
+
+  printf("median window size: %d, iterations: %d\n", MEDIAN_FILTER_SIZE, iterations);
+
+  runBenchmark("legacy linked list median (int)", samples, iterations, [](int x) { return legacyMedianFilter(x); });
+  runBenchmark("MedianFilter<int>", samples, iterations, [&](int x) { return median_int.update(x); });
+  runBenchmark("MedianFilter<float>", samples, iterations, [&](int x) { return int(median_float.update(x)); });
+  runBenchmark("HampelFilter<float>", samples, iterations, [&](int x) { return int(hampel_float.update(x)); });
+  runBenchmark("ExponentialFilter<float>", samples, iterations, [&](int x) { return int(exponential_float.update(x)); });
+  runBenchmark("AlphaBetaFilter<float>", samples, iterations, [&](int x) { return int(alpha_beta_float.update(x, 1.0f / 15)); });
+
+  delete[] samples;
+
+  return 0;
+}
@@ -0,0 +1,101 @@
+//include header
+#include <gps_clock_model.hpp>
+
+//increase of arrival offset over current minimum treated as a system clock step [s]
+static const double CLOCK_STEP_THRESHOLD = 1.0;
+
+//consecutive arrivals past the step threshold before the step is believed (a single late arrival is a scheduling stall) [samples]
+static const int CLOCK_STEP_SAMPLES = 3;
+
+
+//default constructor
+GpsClockModel::GpsClockModel(double window, double min_delay)
+{
+
+  //set class variable values to passed values
+  this->_window = window;
+  this->_min_delay = min_delay;
+
+  //start without offset samples
+  this->reset();
+
+}
+
+//default destructor
+GpsClockModel::~GpsClockModel() {}
+
+//get functions
+
+//get learned offset of system time from GPS time (zero until first arrival)
+double GpsClockModel::getOffset() const
+{
+
+  if (this->_count == 0)
+    return 0;
+
+  return this->_samples[this->_head].offset - this->_min_delay;
+
+}
+
+bool GpsClockModel::isInitialized() const
+{
+  return this->_count > 0;
+}
+
+//other functions
+
+//discard all offset samples
+void GpsClockModel::reset()
+{
+  this->_head = 0;
+  this->_count = 0;
+  this->_step_samples = 0;
+}
+
+//convert GPS time to system time
+double GpsClockModel::toSystemTime(double gps_time) const
+{
+  return gps_time + this->getOffset();
+}
+
+//add arrival to sliding window minimum of offsets
+//samples are kept in a fixed ring as a monotonic queue, so each update is amortized O(1)
+void GpsClockModel::update(double gps_time, double arrival_time)
+{
+
+  double offset = arrival_time - gps_time;
+
+  //system clock stepped forward (e.g. first NTP sync) if the step persists, old offsets no longer apply; until then late arrivals are
+  //ordinary samples, which can't raise the minimum
+  if ((this->_count > 0) && (offset > this->_samples[this->_head].offset + CLOCK_STEP_THRESHOLD))
+  {
+    if (++this->_step_samples >= CLOCK_STEP_SAMPLES)
+      this->reset();
+  }
+  else
+    this->_step_samples = 0;
+
+  //drop samples that left the window
+  while ((this->_count > 0) && (this->_samples[this->_head].arrival_time < arrival_time - this->_window))
+  {
+    this->_head = (this->_head + 1) % CAPACITY;
+    this->_count--;
+  }
+
+  //drop samples that can never become the minimum again, since the new sample is smaller and stays in the window longer
+  while ((this->_count > 0) && (this->_samples[(this->_head + this->_count - 1) % CAPACITY].offset >= offset))
+    this->_count--;
+
+  //ring is full, give up oldest sample early
+  if (this->_count == CAPACITY)
+  {
+    this->_head = (this->_head + 1) % CAPACITY;
+    this->_count--;
+  }
+
+  Sample& sample = this->_samples[(this->_head + this->_count) % CAPACITY];
+  sample.arrival_time = arrival_time;
+  sample.offset = offset;
+  this->_count++;
+
+}
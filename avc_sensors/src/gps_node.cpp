@@ -0,0 +1,337 @@
+//GPS node
+//outputs GPS fix, velocity, and time reference data
+//NMEA sentences are read from the serial device into a fixed buffer, framed and checksum verified in place, and parsed without allocation
+//fixes are stamped with their GPS time converted to system time by a learned clock offset, so serial and processing latency don't shift them
+#include <math.h>
+#include <time.h>
+#include <gps_clock_model.hpp>
+#include <nmea_log.hpp>
+#include <nmea_parser.hpp>
+#include <serial_port.hpp>
+#include <ros/ros.h>
+#include <avc_msgs/GPSLatency.h>
+#include <geometry_msgs/TwistStamped.h>
+#include <sensor_msgs/NavSatFix.h>
+#include <sensor_msgs/NavSatStatus.h>
+#include <sensor_msgs/TimeReference.h>
+#include <signal.h>
+
+//time to wait for serial data before checking for shutdown [ms]
+const int READ_TIMEOUT = 100;
+
+
+//callback function called to process SIGINT command
+void sigintHandler(int sig)
+{
+
+  //call the default shutdown function
+  ros::shutdown();
+
+}
+
+//convert NMEA time of day to GPS time [s since epoch], using date of last RMC sentence (rolled over at midnight) or current system date
+//if none has been received
+double toGpsTime(double utc_time, const NmeaRMC& last_rmc)
+{
+
+  struct tm date;
+  if (last_rmc.has_date)
+  {
+    date.tm_mday = last_rmc.day;
+    date.tm_mon = last_rmc.month - 1;
+    date.tm_year = last_rmc.year - 1900;
+  }
+  else
+  {
+    time_t now = time(NULL);
+    gmtime_r(&now, &date);
+  }
+  date.tm_hour = 0;
+  date.tm_min = 0;
+  date.tm_sec = 0;
+  date.tm_isdst = 0;
+
+  //a time of day more than half a day from that of the last RMC sentence is on the neighbouring day, as for a GGA sentence of the first
+  //fix after UTC midnight arriving before its RMC sentence
+  double day_offset = 0;
+  if (last_rmc.has_date && last_rmc.has_time)
+  {
+    if (utc_time < last_rmc.utc_time - 43200)
+      day_offset = 86400;
+    else if (utc_time > last_rmc.utc_time + 43200)
+      day_offset = -86400;
+  }
+
+  return timegm(&date) + day_offset + utc_time;
+
+}
+
+//convert GGA fix quality to NavSatStatus status
+int toFixStatus(int fix_type)
+{
+
+  switch (fix_type)
+  {
+    case 1: return sensor_msgs::NavSatStatus::STATUS_FIX;
+    case 2: return sensor_msgs::NavSatStatus::STATUS_SBAS_FIX;
+    case 4: return sensor_msgs::NavSatStatus::STATUS_GBAS_FIX;
+    case 5: return sensor_msgs::NavSatStatus::STATUS_GBAS_FIX;
+    case 9: return sensor_msgs::NavSatStatus::STATUS_SBAS_FIX; //WAAS fix reported by some receivers
+    default: return sensor_msgs::NavSatStatus::STATUS_NO_FIX;
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+
+  //send notification that node is launching
+  ROS_INFO("[NODE LAUNCH]: starting gps_node");
+
+  //initialize node and create node handler
+  ros::init(argc, argv, "gps_node");
+  ros::NodeHandle node_private("~");
+  ros::NodeHandle node_public;
+
+  //override the default SIGINT handler
+  signal(SIGINT, sigintHandler);
+
+  //retrieve serial port address from parameter server
+  std::string serial_port;
+  if (!node_private.getParam("/sensor/gps/serial_port", serial_port))
+  {
+    ROS_ERROR("[gps_node] GPS serial port not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve baud rate from parameter server
+  int baud_rate;
+  if (!node_private.getParam("/sensor/gps/baud_rate", baud_rate))
+  {
+    ROS_ERROR("[gps_node] GPS baud rate not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //get frame id parameter
+  std::string frame_id = "gps";
+  if (!node_private.getParam("/sensor/gps/frame_id", frame_id))
+  {
+    ROS_WARN_STREAM("[gps_node] no frame_id provided, using default: " << frame_id);
+  }
+
+  //retrieve whether fixes are published from RMC instead of GGA sentences
+  bool use_rmc = false;
+  if (!node_private.getParam("/sensor/gps/use_rmc", use_rmc))
+  {
+    ROS_WARN_STREAM("[gps_node] no use_rmc provided, using default: " << use_rmc);
+  }
+
+  //retrieve time over which fastest sentence arrival determines clock offset from parameter server
+  double clock_window = 60;
+  if (!node_private.getParam("/sensor/gps/clock_window", clock_window))
+  {
+    ROS_WARN_STREAM("[gps_node] no clock offset window provided, using default: " << clock_window);
+  }
+
+  //retrieve minimum delay from fix to start of its output by GPS chip from parameter server
+  double output_delay = 0;
+  if (!node_private.getParam("/sensor/gps/output_delay", output_delay))
+  {
+    ROS_WARN_STREAM("[gps_node] no output delay provided, using default: " << output_delay);
+  }
+
+  //retrieve NMEA log file from parameter server, if set every byte read from GPS is recorded to log with its arrival time
+  std::string record_file;
+  node_private.getParam("/sensor/gps/record_file", record_file);
+
+  //open NMEA log for recording
+  NmeaLog record_log;
+  if (!record_file.empty())
+  {
+    if (!record_log.openWrite(record_file))
+    {
+      ROS_ERROR("[gps_node] failed to create NMEA log for recording: %s", record_file.c_str());
+      ROS_BREAK();
+    }
+    ROS_INFO("[gps_node] recording NMEA log: %s", record_file.c_str());
+  }
+
+  //open serial device
+  SerialPort port;
+  if (!port.open(serial_port, baud_rate))
+  {
+    ROS_ERROR("[gps_node] failed to open serial device %s with baud rate %d", serial_port.c_str(), baud_rate);
+    ROS_BREAK();
+  }
+  ROS_INFO("[gps_node] opened serial device %s with baud rate %d", serial_port.c_str(), baud_rate);
+
+  //create publisher to publish GPS fix messages with buffer size 1, and latch set to false
+  ros::Publisher fix_pub = node_public.advertise<sensor_msgs::NavSatFix>("fix", 1, false);
+
+  //create publisher to publish GPS velocity messages with buffer size 1, and latch set to false
+  ros::Publisher vel_pub = node_public.advertise<geometry_msgs::TwistStamped>("vel", 1, false);
+
+  //create publisher to publish GPS time reference messages with buffer size 1, and latch set to false
+  ros::Publisher time_reference_pub = node_public.advertise<sensor_msgs::TimeReference>("time_reference", 1, false);
+
+  //create publisher to publish GPS receive latency messages with buffer size 1, and latch set to false
+  ros::Publisher latency_pub = node_public.advertise<avc_msgs::GPSLatency>("gps_latency", 1, false);
+
+  //create messages once, only their contents change from sentence to sentence
+  sensor_msgs::NavSatFix fix_msg;
+  fix_msg.header.frame_id = frame_id;
+  fix_msg.status.service = sensor_msgs::NavSatStatus::SERVICE_GPS;
+
+  geometry_msgs::TwistStamped vel_msg;
+  vel_msg.header.frame_id = frame_id;
+
+  sensor_msgs::TimeReference time_reference_msg;
+  time_reference_msg.header.frame_id = frame_id;
+  time_reference_msg.source = frame_id;
+
+  avc_msgs::GPSLatency latency_msg;
+  latency_msg.header.frame_id = frame_id;
+
+  //offset of system time from GPS time, learned from the first sentence of each fix
+  GpsClockModel clock_model(clock_window, output_delay);
+  double epoch_time = 0; //GPS time of current fix [s since epoch]
+
+  //sentence framer and most recently parsed sentences
+  NmeaFramer framer;
+  NmeaGGA gga;
+  NmeaRMC rmc;
+  rmc.has_date = false;
+
+  while (ros::ok())
+  {
+
+    //read whatever has arrived straight into the framer buffer
+    size_t size;
+    char *buffer = framer.getWriteBuffer(size);
+    ssize_t count = port.read(buffer, size, READ_TIMEOUT);
+    if (count < 0)
+    {
+      ROS_ERROR("[gps_node] failed to read from serial device %s", serial_port.c_str());
+      break;
+    }
+    if (count == 0)
+      continue;
+    framer.commit(count);
+
+    //time last bytes of sentences were read
+    ros::Time arrival = ros::Time::now();
+
+    //record raw bytes as they were read
+    if (!record_file.empty() && !record_log.write(buffer, count, arrival.toNSec() / 1000))
+      ROS_ERROR_THROTTLE(1, "[gps_node] failed to write NMEA log: %s", record_file.c_str());
+
+    //process every complete sentence received
+    const char *sentence;
+    size_t length;
+    while (framer.next(sentence, length))
+    {
+
+      //parse GGA and RMC sentences, ignore all others
+      NmeaSentenceType type = getNmeaSentenceType(sentence, length);
+      bool has_time;
+      double utc_time;
+      if ((type == NMEA_GGA) && !use_rmc && parseGGA(sentence, length, gga))
+      {
+        has_time = gga.has_time;
+        utc_time = gga.utc_time;
+      }
+      else if ((type == NMEA_RMC) && parseRMC(sentence, length, rmc))
+      {
+        has_time = rmc.has_time;
+        utc_time = rmc.utc_time;
+      }
+      else
+        continue;
+
+      //stamp sentence with time of its fix, falling back to arrival time if sentence has no time
+      ros::Time stamp = arrival;
+      double gps_time = 0;
+      if (has_time)
+      {
+
+        //first sentence of each fix updates clock model, it started leaving the chip one transmission time before it was read
+        gps_time = toGpsTime(utc_time, rmc);
+        if (gps_time != epoch_time)
+        {
+          epoch_time = gps_time;
+          double transmission_time = (length + 2) * 10.0 / baud_rate;
+          clock_model.update(gps_time, arrival.toSec() - transmission_time);
+        }
+
+        stamp.fromSec(clock_model.toSystemTime(gps_time));
+
+      }
+
+      //publish fix from GGA sentence (or RMC sentence if selected)
+      if ((type == NMEA_GGA) || use_rmc)
+      {
+
+        fix_msg.header.stamp = stamp;
+        if (type == NMEA_GGA)
+        {
+          //fix with position covariance approximated from horizontal dilution of precision
+          fix_msg.status.status = toFixStatus(gga.fix_type);
+          fix_msg.latitude = gga.latitude;
+          fix_msg.longitude = gga.longitude;
+          fix_msg.altitude = gga.altitude + gga.geoid_separation; //altitude above ellipsoid
+          fix_msg.position_covariance[0] = gga.hdop * gga.hdop;
+          fix_msg.position_covariance[4] = gga.hdop * gga.hdop;
+          fix_msg.position_covariance[8] = (2 * gga.hdop) * (2 * gga.hdop);
+          fix_msg.position_covariance_type = sensor_msgs::NavSatFix::COVARIANCE_TYPE_APPROXIMATED;
+        }
+        else
+        {
+          //fix without altitude or covariance
+          fix_msg.status.status = rmc.fix_valid ? sensor_msgs::NavSatStatus::STATUS_FIX : sensor_msgs::NavSatStatus::STATUS_NO_FIX;
+          fix_msg.latitude = rmc.latitude;
+          fix_msg.longitude = rmc.longitude;
+          fix_msg.altitude = NAN;
+          fix_msg.position_covariance_type = sensor_msgs::NavSatFix::COVARIANCE_TYPE_UNKNOWN;
+        }
+        fix_pub.publish(fix_msg);
+
+        if (has_time)
+        {
+
+          //time reference is stamped with arrival time, so it relates system time to GPS time like the Python driver's
+          time_reference_msg.header.stamp = arrival;
+          time_reference_msg.time_ref.fromSec(gps_time);
+          time_reference_pub.publish(time_reference_msg);
+
+          //time from fix to reception of its sentence
+          latency_msg.header.stamp = stamp;
+          latency_msg.latency = (arrival - stamp).toSec();
+          latency_msg.clock_offset = clock_model.getOffset();
+          latency_pub.publish(latency_msg);
+
+        }
+
+      }
+
+      //velocity is only available from RMC sentences (x = east, y = north)
+      if ((type == NMEA_RMC) && rmc.fix_valid)
+      {
+        vel_msg.header.stamp = stamp;
+        vel_msg.twist.linear.x = rmc.speed * sin(rmc.course);
+        vel_msg.twist.linear.y = rmc.speed * cos(rmc.course);
+        vel_pub.publish(vel_msg);
+      }
+
+    }
+
+  }
+
+  //report sentences lost to transmission errors
+  ROS_INFO("[gps_node] dropped sentences: %u invalid checksum, %u too long", framer.getChecksumErrors(), framer.getOverflows());
+
+  //close serial device and NMEA log
+  port.close();
+  record_log.close();
+
+  return 0;
+}
@@ -1,53 +1,93 @@
-//ROS includes
+//GPS setup node
+//configures the MTK GPS chip output sentences, update rate, fix rate, and baud rate
+//each command is sent by the PMTK sequencer, which waits for the chip's acknowledgement and resends unacknowledged commands
+//the chip's current baud rate is found by probing, and setup is skipped if the chip still has its configuration from the last boot
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pmtk_sequencer.hpp>
+#include <serial_port.hpp>
 #include <ros/ros.h>
 #include <signal.h>
-#include <string.h>
-#include <wiringPi.h>
-#include <wiringSerial.h>
 
-//defines
-#define PMTK_API_SET_FIX_CTL_5HZ "$PMTK300,200,0,0,0,0*2F\r\n"
-#define PMTK_SET_BAUD_57600 "$PMTK251,57600*2C\r\n"
-#define PMTK_SET_NMEA_OUTPUT_RMCONLY "$PMTK314,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*29\r\n"
-#define PMTK_SET_NMEA_OUTPUT_RMCGGA "$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*28\r\n"
-#define PMTK_SET_NMEA_UPDATE_5HZ "$PMTK220,200*2C\r\n"
-#define PMTK_SET_NMEA_UPDATE_10HZ "$PMTK220,100*2F\r\n"
+//PMTK command bodies, checksums are added by the PMTK sequencer
+#define PMTK_API_SET_FIX_CTL_5HZ "PMTK300,200,0,0,0,0"
+#define PMTK_SET_NMEA_OUTPUT_RMCONLY "PMTK314,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0"
+#define PMTK_SET_NMEA_OUTPUT_RMCGGA "PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0"
+#define PMTK_SET_NMEA_UPDATE_5HZ "PMTK220,200"
+#define PMTK_SET_NMEA_UPDATE_10HZ "PMTK220,100"
 
-//global variables
-int fd = -1;
+//update interval set by setup [ms], and tolerance of observed update interval
+const int UPDATE_INTERVAL = 100;
+const int UPDATE_INTERVAL_TOLERANCE = 20;
+
+//baud rates supported by MTK chips, probed after cached, target, and power up baud rates
+const int PROBE_BAUD_RATES[] = { 9600, 57600, 115200, 38400, 19200, 4800 };
 
 
 //callback function called to process SIGINT command
 void sigintHandler(int sig)
 {
 
-  //if serial device has successfully been opened then close it
-  if (fd != -1)
-    serialClose(fd);
-
   //call the default shutdown function
   ros::shutdown();
 
 }
 
-//function for sending messages to GPS via serial protocol
-bool sendCommand(const char command_str[])
+//read baud rate of last known good configuration from cache file, returns 0 if there is none
+int readCache(const std::string& cache_file)
 {
 
-  //return false if provided file descriptor is invalid
-  if (fd == -1)
-    return false;
+  FILE *file = fopen(cache_file.c_str(), "r");
+  if (file == NULL)
+    return 0;
 
-  //inform of command being sent to GPS chip
-  ROS_INFO("[gps_setup_node] sending command to GPS chip: %s", command_str);
+  int baud_rate = 0;
+  if (fscanf(file, "baud_rate: %d", &baud_rate) != 1)
+    baud_rate = 0;
+  fclose(file);
+
+  return baud_rate;
+
+}
+
+//write baud rate of known good configuration to cache file
+void writeCache(const std::string& cache_file, int baud_rate)
+{
+
+  FILE *file = fopen(cache_file.c_str(), "w");
+  if (file == NULL)
+  {
+    ROS_WARN("[gps_setup_node] failed to write GPS configuration cache: %s", cache_file.c_str());
+    return;
+  }
 
-  //flush serial buffer before sending command
-  serialFlush(fd);
+  fprintf(file, "baud_rate: %d\n", baud_rate);
+  fclose(file);
 
-  //output received command to serial buffer
-  serialPrintf(fd, command_str);
+}
+
+//add baud rate to list of baud rates to probe if it isn't in the list yet
+void addProbeBaudRate(std::vector<int>& baud_rates, int baud_rate)
+{
+  if ((baud_rate > 0) && (std::find(baud_rates.begin(), baud_rates.end(), baud_rate) == baud_rates.end()))
+    baud_rates.push_back(baud_rate);
+}
+
+//send command to GPS chip and wait for acknowledgement, returns true if chip reports success
+bool sendCommand(PmtkSequencer& sequencer, const char *command)
+{
+
+  //inform of command being sent to GPS chip
+  ROS_INFO("[gps_setup_node] sending command to GPS chip: %s", command);
+
+  PmtkSequencer::Result result = sequencer.sendCommand(command);
+  if (result != PmtkSequencer::ACTION_SUCCEEDED)
+  {
+    ROS_ERROR("[gps_setup_node] command %s failed: %s", command, PmtkSequencer::getResultName(result));
+    return false;
+  }
 
-  //return true to indicate command sent successfully
   return true;
 
 }
@@ -65,7 +105,7 @@ int main(int argc, char **argv)
   //override the default SIGINT handler
   signal(SIGINT, sigintHandler);
 
-  //retrieve baud rate of sensor in hertz from parameter server
+  //retrieve baud rate of chip at power up from parameter server
   int baud_rate;
   if (!node_private.getParam("/setup/baud_rate", baud_rate))
   {
@@ -73,6 +113,14 @@ int main(int argc, char **argv)
     ROS_BREAK();
   }
 
+  //retrieve baud rate chip is switched to from parameter server
+  int target_baud_rate;
+  if (!node_private.getParam("/setup/target_baud_rate", target_baud_rate))
+  {
+    ROS_ERROR("[gps_setup_node] GPS chip target baud rate not defined in config file: avc_sensors/config/gps.yaml");
+    ROS_BREAK();
+  }
+
   //retrieve serial port address from parameter server
   std::string serial_port;
   if (!node_private.getParam("/setup/serial_port", serial_port))
@@ -81,186 +129,111 @@ int main(int argc, char **argv)
     ROS_BREAK();
   }
 
-  //-----------------------------SETUP WIRINGPI---------------------------------
-
-  if (wiringPiSetup() == -1)
+  //retrieve time to wait for acknowledgement of each command from parameter server
+  int ack_timeout = 500;
+  if (!node_private.getParam("/setup/ack_timeout", ack_timeout))
   {
-    ROS_INFO("[gps_setup_node] wiringPi setup failed");
-    ROS_BREAK();
+    ROS_WARN_STREAM("[gps_setup_node] no acknowledgement timeout provided, using default: " << ack_timeout);
   }
 
-  //---------------------------OPEN SERIAL DEVICE-------------------------------
-
-  //open serial device with default baud rate
-  fd = serialOpen(serial_port.c_str(), baud_rate);
-
-  //check if serial open succeeded
-  if (fd == -1)
+  //retrieve number of times each command is sent before giving up from parameter server
+  int attempts = 3;
+  if (!node_private.getParam("/setup/attempts", attempts))
   {
-    ROS_ERROR("[gps_setup_node] failed to open serial device");
-    ROS_BREAK();
+    ROS_WARN_STREAM("[gps_setup_node] no command attempts provided, using default: " << attempts);
   }
-  else
-    ROS_INFO("[gps_setup_node] opened serial device %s with baud rate %d", serial_port.c_str(), baud_rate);
-
-  //sleep briefly before running command
-  ros::Duration(2.0).sleep();
-
-  //----------------------------------------------------------------------------
-  //-----------------------SEND COMMANDS TO GPS CHIP----------------------------
-  //----------------------------------------------------------------------------
-
-  //-----------------------SET CHIP DATA OUTPUT TYPE----------------------------
-
-  //notify of current command to be sent
-  ROS_INFO("[gps_setup_node] setting data output type");
-
-  //set GPS chip data output type to RMC only
-  if (!sendCommand(PMTK_SET_NMEA_OUTPUT_RMCGGA))
-    ROS_BREAK();
 
-  //sleep briefly before running command
-  ros::Duration(2.0).sleep();
-
-  //-----------------------SET CHIP DATA OUTPUT RATE----------------------------
-
-  //notify of current command to be sent
-  ROS_INFO("[gps_setup_node] setting data output rate");
+  //retrieve time to listen for valid sentences at each probed baud rate from parameter server (at least one update interval of an unconfigured chip)
+  int probe_timeout = 1200;
+  if (!node_private.getParam("/setup/probe_timeout", probe_timeout))
+  {
+    ROS_WARN_STREAM("[gps_setup_node] no probe timeout provided, using default: " << probe_timeout);
+  }
 
-  //set GPS chip data output rate to 5 Hz
-  if (!sendCommand(PMTK_SET_NMEA_UPDATE_10HZ))
-    ROS_BREAK();
+  //retrieve file last known good configuration is cached in from parameter server
+  std::string cache_file;
+  if (!node_private.getParam("/setup/cache_file", cache_file))
+  {
+    ROS_WARN("[gps_setup_node] no configuration cache file provided, configuration won't be cached");
+  }
 
-  //sleep briefly before running command
-  ros::Duration(2.0).sleep();
+  //--------------------------DETECT CHIP BAUD RATE-----------------------------
 
-  //-----------------------SET CHIP FIX UPDATE RATE-----------------------------
+  ros::WallTime setup_start = ros::WallTime::now();
 
-  //notify of current command to be sent
-  ROS_INFO("[gps_setup_node] setting fix update rate");
+  //probe cached baud rate first, then target baud rate (chip kept configuration), then power up baud rate, then all others
+  std::vector<int> probe_baud_rates;
+  if (!cache_file.empty())
+    addProbeBaudRate(probe_baud_rates, readCache(cache_file));
+  addProbeBaudRate(probe_baud_rates, target_baud_rate);
+  addProbeBaudRate(probe_baud_rates, baud_rate);
+  for (size_t i = 0; i < sizeof(PROBE_BAUD_RATES) / sizeof(PROBE_BAUD_RATES[0]); i++)
+    addProbeBaudRate(probe_baud_rates, PROBE_BAUD_RATES[i]);
 
-  //set GPS chip fix update rate to 5 Hz
-  if (!sendCommand(PMTK_API_SET_FIX_CTL_5HZ))
-    ROS_BREAK();
+  SerialPort port;
+  PmtkSequencer sequencer(&port, ack_timeout, attempts);
+  int detected_baud_rate = sequencer.detectBaudRate(serial_port, probe_baud_rates, probe_timeout);
+  if (detected_baud_rate == 0)
+  {
+    ROS_ERROR("[gps_setup_node] no valid NMEA sentences received from %s at any baud rate", serial_port.c_str());
+    return 1;
+  }
+  ROS_INFO("[gps_setup_node] GPS chip found on %s at baud rate %d", serial_port.c_str(), detected_baud_rate);
 
-  //sleep briefly before running command
-  ros::Duration(2.0).sleep();
+  //skip setup if chip already sends only RMC and GGA sentences at the target update rate and baud rate
+  PmtkSequencer::Output output;
+  if ((detected_baud_rate == target_baud_rate) && sequencer.observeOutput(4 * UPDATE_INTERVAL, output) &&
+      output.rmc && output.gga && !output.other && (abs(output.update_interval - UPDATE_INTERVAL) <= UPDATE_INTERVAL_TOLERANCE))
+  {
+    ROS_INFO("[gps_setup_node] GPS chip already configured, setup skipped after %.2f s", (ros::WallTime::now() - setup_start).toSec());
+    if (!cache_file.empty())
+      writeCache(cache_file, target_baud_rate);
+    return 0;
+  }
 
-  //--------------------------SET CHIP BAUD RATE--------------------------------
+  //----------------------------------------------------------------------------
+  //-----------------------SEND COMMANDS TO GPS CHIP----------------------------
+  //----------------------------------------------------------------------------
 
-  //notify of current command to be sent
-  ROS_INFO("[gps_setup_node] setting chip baud rate");
+  //set GPS chip data output type to RMC and GGA, set data output rate to 10 Hz, and set fix update rate to 5 Hz
+  if (!sendCommand(sequencer, PMTK_SET_NMEA_OUTPUT_RMCGGA) ||
+      !sendCommand(sequencer, PMTK_SET_NMEA_UPDATE_10HZ) ||
+      !sendCommand(sequencer, PMTK_API_SET_FIX_CTL_5HZ))
+  {
+    ROS_ERROR("[gps_setup_node] GPS chip setup failed");
+    return 1;
+  }
 
-  //set GPS chip baud rate to 57600
-  if (!sendCommand(PMTK_SET_BAUD_57600))
-    ROS_BREAK();
+  //set GPS chip baud rate, confirmed by reopening serial device at new baud rate and receiving valid sentences
+  if (detected_baud_rate != target_baud_rate)
+  {
+    ROS_INFO("[gps_setup_node] setting chip baud rate to %d", target_baud_rate);
+    if (!sequencer.setBaudRate(serial_port, target_baud_rate, ack_timeout))
+    {
+      ROS_ERROR("[gps_setup_node] GPS chip did not respond at baud rate %d, setup failed", target_baud_rate);
+      return 1;
+    }
+  }
 
-  //sleep briefly before closing serial device
-  ros::Duration(2.0).sleep();
+  //remember known good configuration for next boot
+  if (!cache_file.empty())
+    writeCache(cache_file, target_baud_rate);
 
   //----------------------------------------------------------------------------
   //-----------------------END COMMANDS TO GPS CHIP-----------------------------
   //----------------------------------------------------------------------------
 
   //close serial device
-  serialClose(fd);
+  port.close();
 
   //inform of serial device closure
   ROS_INFO("[gps_setup_node] closed serial device %s", serial_port.c_str());
 
-  //sleep briefly before reopening serial device
-  ros::Duration(2.0).sleep();
-
-  //if program is still running at this point then everything has completed successfully
   //indicate that program has completed setup successfully
-  ROS_INFO("[gps_setup_node] GPS chip setup completed successfully");
+  ROS_INFO("[gps_setup_node] GPS chip setup completed successfully in %.2f s", (ros::WallTime::now() - setup_start).toSec());
 
   //kill node when finished
   ros::shutdown();
 
   return 0;
 }
-
-
-
-/*-----open serial device to confirm baud rate change------
-//open serial device with new baud rate
-fd = serialOpen(serial_port.c_str(), 57600);
-
-//check if serial open succeeded
-if (fd == -1)
-{
-  ROS_ERROR("[gps_setup_node] failed to open serial device");
-  ROS_BREAK();
-}
-else
-  ROS_INFO("[gps_setup_node] opened serial device %s with baud rate 57600", serial_port.c_str());
-
-//sleep briefly before running command
-ros::Duration(3.0).sleep();
-
-//close serial device
-serialClose(fd);*/
-
-
-
-/*-----------------------------REPLY HANDLING---------------------------------
-
-ROS_INFO("[gps_setup_node] command sent");
-
-//sleep briefly while waiting for reply
-ros::Duration(0.5).sleep();
-
-//check for reply from GPS
-if (serialDataAvail(fd) > 0)
-{
-
-  ROS_INFO("[gps_setup_node] reply received: %d", serialDataAvail(fd));
-
-  //create vector container for reply
-  std::vector<char> gps_reply;
-
-  //receive reply character by character
-  while (serialDataAvail > 0)
-  {
-    gps_reply.push_back(serialGetchar(fd));
-    ROS_INFO("[gps_setup_node] character read: %c", gps_reply.back());
-  }
-
-  //create string to output reply contents
-  std::string gps_reply_str(gps_reply.begin(), gps_reply.end());
-
-  //inform of reply contents
-  ROS_INFO("[gps_setup_node] reply received from GPS chip: %s", gps_reply_str.c_str());
-
-  //if GPS chip acknowledgement packet indicates success then return true
-  if ((gps_reply.size() > 13) && (gps_reply[13] == '3'))
-  {
-
-    //inform of success
-    ROS_INFO("[gps_setup_node] valid command / packet, action succeeded");
-
-    //return true to indicate success
-    return true;
-
-  }
-  //in all other situtations command has failed
-  else if ((gps_reply.size() > 13) && (gps_reply[13] == '2'))
-    ROS_INFO("[gps_setup_node] valid command / packet, but action failed");
-  else if ((gps_reply.size() > 13) && (gps_reply[13] == '1'))
-    ROS_INFO("[gps_setup_node] unsupported command / packet type");
-  else if ((gps_reply.size() > 13) && (gps_reply[13] == '0'))
-    ROS_INFO("[gps_setup_node] invalid command / packet");
-  else
-    ROS_INFO("[gps_setup_node] invalid reply received from GPS");
-
-}
-else if (serialDataAvail(fd) == 0)
-  ROS_INFO("[gps_setup_node] no reply received from GPS chip");
-else if (serialDataAvail(fd) == -1)
-  ROS_INFO("[gps_setup_node] attempt to check for available serial data failed: %s", strerror(errno));
-
-//return false to indicate failure
-return false;
-
------------------------------END REPLY HANDLING-----------------------------*/
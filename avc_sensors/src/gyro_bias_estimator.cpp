@@ -0,0 +1,121 @@
+//include header
+#include <gyro_bias_estimator.hpp>
+
+#include <math.h>
+
+
+//default constructor
+GyroBiasEstimator::GyroBiasEstimator(double max_accel_variance, double max_gyro_rate, double max_throttle, double min_standstill_time, double variance_time_constant, double bias_time_constant)
+{
+
+  //set class variable values to passed values
+  this->_max_accel_variance = max_accel_variance;
+  this->_max_gyro_rate = max_gyro_rate;
+  this->_max_throttle = max_throttle;
+  this->_min_standstill_time = min_standstill_time;
+  this->_variance_time_constant = variance_time_constant;
+  this->_bias_time_constant = bias_time_constant;
+
+  //initialize other variables (no bias, not standing still)
+  for (int i = 0; i < 3; i++)
+  {
+    this->_bias[i] = 0;
+    this->_mean[i] = 0;
+    this->_variance[i] = 0;
+  }
+  this->_standstill_time = 0;
+  this->_throttle_percent = 0;
+  this->_initialized = false;
+
+}
+
+//default destructor
+GyroBiasEstimator::~GyroBiasEstimator() {}
+
+//set functions
+
+//set current commanded throttle [%]
+void GyroBiasEstimator::setThrottlePercent(double throttle_percent)
+{
+  this->_throttle_percent = throttle_percent;
+}
+
+//get functions
+
+//get current gyro bias estimate [rad/s]
+void GyroBiasEstimator::getBias(double& x, double& y, double& z) const
+{
+  x = this->_bias[0];
+  y = this->_bias[1];
+  z = this->_bias[2];
+}
+
+//returns true if standstill conditions have held for the minimum standstill time
+bool GyroBiasEstimator::isStandstill() const
+{
+  return this->_standstill_time >= this->_min_standstill_time;
+}
+
+//other functions
+
+//update running accelerometer variance and standstill state, and average gyro bias while standing still
+void GyroBiasEstimator::update(double gx, double gy, double gz, double ax, double ay, double az, double dt)
+{
+
+  double accel[3] = { ax, ay, az };
+  double gyro[3] = { gx, gy, gz };
+
+  //first sample initializes running mean
+  if (!this->_initialized)
+  {
+    for (int i = 0; i < 3; i++)
+      this->_mean[i] = accel[i];
+    this->_initialized = true;
+    return;
+  }
+
+  if (dt <= 0)
+    return;
+
+  //exponentially weighted running mean and variance of each accelerometer axis
+  double alpha = dt / (this->_variance_time_constant + dt);
+  double variance = 0;
+  for (int i = 0; i < 3; i++)
+  {
+    double difference = accel[i] - this->_mean[i];
+    double increment = alpha * difference;
+    this->_mean[i] += increment;
+    this->_variance[i] = (1 - alpha) * (this->_variance[i] + difference * increment);
+    variance += this->_variance[i];
+  }
+
+  //vehicle is still if throttle is released, accelerometer is quiet, and gyro rate (after bias) is small
+  double rate = 0;
+  for (int i = 0; i < 3; i++)
+    rate += (gyro[i] - this->_bias[i]) * (gyro[i] - this->_bias[i]);
+  bool still = (fabs(this->_throttle_percent) <= this->_max_throttle) && (variance <= this->_max_accel_variance) && (sqrt(rate) <= this->_max_gyro_rate);
+
+  if (!still)
+  {
+    this->_standstill_time = 0;
+    return;
+  }
+  this->_standstill_time += dt;
+
+  //average gyro output as bias once standstill has been confirmed
+  if (this->isStandstill())
+  {
+    double bias_alpha = dt / (this->_bias_time_constant + dt);
+    for (int i = 0; i < 3; i++)
+      this->_bias[i] += bias_alpha * (gyro[i] - this->_bias[i]);
+  }
+
+}
+
+//subtract bias estimate from gyro rates [rad/s]
+void GyroBiasEstimator::correct(double& gx, double& gy, double& gz) const
+{
+  gx -= this->_bias[0];
+  gy -= this->_bias[1];
+  gz -= this->_bias[2];
+}
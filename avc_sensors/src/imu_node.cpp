@@ -1,8 +1,19 @@
 //IMU node
 //outputs IMU data
+//samples are read from the IMU FIFO (or replayed from an IMU log) by a dedicated acquisition thread and published in batches by the main thread
+#include <atomic>
+#include <chrono>
 #include <math.h>
+#include <pthread.h>
+#include <thread>
+#include <gyro_bias_estimator.hpp>
+#include <imu_source.hpp>
+#include <mag_calibrator.hpp>
+#include <orientation_filter.hpp>
+#include <spsc_ring.hpp>
 #include <ros/console.h>
 #include <ros/ros.h>
+#include <avc_msgs/ESC.h>
 #include <avc_msgs/Heading.h>
 #include <sensor_msgs/Imu.h>
 #include <sensor_msgs/MagneticField.h>
@@ -17,6 +28,20 @@ static const double G_TO_MPSS = 9.80665;
 //math constants
 const double PI = 3.1415926535897;
 
+//size of IMU sample ring buffer (must be a power of two)
+const size_t SAMPLE_RING_SIZE = 512;
+
+//publisher buffer size, large enough to hold a full batch of samples
+const int PUBLISH_QUEUE_SIZE = 32;
+
+//global variables
+//samples are pushed by the acquisition thread and popped by the publish loop
+SPSCRing<RTIMU_DATA, SAMPLE_RING_SIZE> imu_samples;
+std::atomic<unsigned int> lost_samples(0);
+std::atomic<bool> acquiring(true);
+std::atomic<bool> source_finished(false);
+GyroBiasEstimator *gyro_bias_estimator = NULL;
+
 
 //callback function called to process SIGINT command
 void sigintHandler(int sig)
@@ -27,6 +52,56 @@ void sigintHandler(int sig)
 
 }
 
+//callback function called to process messages on hardware ESC topic
+void escCallback(const avc_msgs::ESC::ConstPtr& msg)
+{
+
+  //commanded throttle rules out standstill before the accelerometer notices motion (in velocity mode the throttle is only a limit of the
+  //speed controller, so motion is commanded by a nonzero target speed)
+  if (gyro_bias_estimator != NULL)
+  {
+    if (msg->velocity_mode)
+      gyro_bias_estimator->setThrottlePercent((msg->target_speed > 0) ? msg->throttle_percent : 0);
+    else
+      gyro_bias_estimator->setThrottlePercent(msg->throttle_percent);
+  }
+
+}
+
+//IMU acquisition thread function
+//drains all samples waiting in the IMU FIFO in one burst, then sleeps until more samples are expected
+//RTIMULib timestamps each raw sample inside IMURead(), so no sample time depends on publish latency; fusion runs later in the publish loop
+void acquisitionThread(ImuSource *imu_source)
+{
+
+  RTIMU_DATA imu_data;
+  while (acquiring && !imu_source->isFinished())
+  {
+
+    //read samples until FIFO is empty, counting samples as lost if the publish loop has fallen behind
+    while (imu_source->read(imu_data))
+    {
+      if (!imu_samples.push(imu_data))
+        lost_samples++;
+    }
+
+    //sleep until next IMU reading
+    std::this_thread::sleep_for(std::chrono::milliseconds(imu_source->getPollInterval()));
+
+  }
+
+  //let publish loop know no more samples will arrive
+  source_finished = true;
+
+}
+
+//convert RTIMULib timestamp to ROS time
+ros::Time toRosTime(uint64_t timestamp)
+{
+  //RTIMULib timestamps are given in microseconds since epoch
+  return ros::Time(timestamp / 1000000, (timestamp % 1000000) * 1000);
+}
+
 int main(int argc, char **argv)
 {
 
@@ -64,24 +139,66 @@ int main(int argc, char **argv)
     ROS_WARN_STREAM("[imu_node] no frame_id provided, using default: " << frame_id);
   }
 
-  //create RTIMUSettings type object called imu_settings to set initial IMU settings that will later be used to create IMU object
+  //create RTIMUSettings type object called imu_settings to set initial IMU settings that will later be used to create IMU source
   RTIMUSettings *imu_settings = new RTIMUSettings(calibration_file_path.c_str(), calibration_file_name.c_str());
 
-  //create RTIMU type object called imu using previously determined settings
-  RTIMU *imu = RTIMU::createIMU(imu_settings);
+  //fusion runs in the publish loop after online compass calibration, so disable RTIMULib's internal fusion
+  int fusion_type = imu_settings->m_fusionType;
+  imu_settings->m_fusionType = RTFUSION_TYPE_NULL;
+
+  //retrieve IMU log file from parameter server, if set samples are replayed from log instead of read from IMU hardware
+  std::string replay_file;
+  node_private.getParam("/sensor/imu/replay_file", replay_file);
 
-  //make sure IMU was detected
-  if ((imu == NULL) || (imu->IMUType() == RTIMU_TYPE_NULL))
+  //create IMU source
+  ImuSource *imu_source;
+  if (replay_file.empty())
   {
-    ROS_ERROR("[imu_node] IMU not found");
-    ROS_BREAK();
+
+    //create IMU hardware source using previously determined settings and make sure IMU was detected and initialized
+    imu_source = new RTIMUSource(imu_settings);
+    if (!imu_source->init())
+    {
+      ROS_ERROR("[imu_node] IMU not found or failed to initialize");
+      ROS_BREAK();
+    }
+
+  }
+  else
+  {
+
+    //retrieve replay rate from parameter server (1 = real time)
+    double replay_rate = 1;
+    if (!node_private.getParam("/sensor/imu/replay_rate", replay_rate))
+    {
+      ROS_WARN_STREAM("[imu_node] no replay rate provided, using default: " << replay_rate);
+    }
+
+    //create IMU log replay source
+    imu_source = new ImuLogSource(replay_file, replay_rate);
+    if (!imu_source->init())
+    {
+      ROS_ERROR("[imu_node] failed to open IMU log for replay (replay rate must be greater than zero): %s", replay_file.c_str());
+      ROS_BREAK();
+    }
+    ROS_INFO("[imu_node] replaying IMU log at %.2fx real time: %s", replay_rate, replay_file.c_str());
+
   }
 
-  //initialize IMU
-  if (!imu->IMUInit())
+  //retrieve IMU log file from parameter server, if set every raw sample is recorded to log
+  std::string record_file;
+  node_private.getParam("/sensor/imu/record_file", record_file);
+
+  //open IMU log for recording
+  ImuLog record_log;
+  if (!record_file.empty())
   {
-    ROS_ERROR("[imu_node] failed to initialize IMU");
-    ROS_BREAK();
+    if (!record_log.openWrite(record_file))
+    {
+      ROS_ERROR("[imu_node] failed to create IMU log for recording: %s", record_file.c_str());
+      ROS_BREAK();
+    }
+    ROS_INFO("[imu_node] recording IMU log: %s", record_file.c_str());
   }
 
   //retrieve slerp power from parameter server
@@ -92,11 +209,128 @@ int main(int argc, char **argv)
     ROS_BREAK();
   }
 
-  //set fusion coefficient and enable gyro, accelerometer, and compass
-  imu->setSlerpPower(slerp_power);
-  imu->setGyroEnable(true);
-  imu->setAccelEnable(true);
-  imu->setCompassEnable(true);
+  //retrieve orientation filter type from parameter server (rtimulib, madgwick, or mahony)
+  std::string orientation_filter_type = "rtimulib";
+  if (!node_private.getParam("/sensor/imu/orientation_filter", orientation_filter_type))
+  {
+    ROS_WARN_STREAM("[imu_node] no orientation filter provided, using default: " << orientation_filter_type);
+  }
+
+  //create in-house orientation filter if selected, otherwise RTIMULib fusion output is published
+  OrientationFilter<float> *orientation_filter = NULL;
+  if (orientation_filter_type != "rtimulib")
+  {
+
+    //retrieve filter gains from parameter server
+    float gain_1 = 0;
+    float gain_2 = 0;
+    if (orientation_filter_type == "madgwick")
+    {
+      if (!node_private.getParam("/sensor/imu/madgwick_beta", gain_1))
+      {
+        ROS_ERROR("[imu_node] Madgwick filter beta not defined in config file: avc_sensors/config/sensors.yaml");
+        ROS_BREAK();
+      }
+    }
+    else if (orientation_filter_type == "mahony")
+    {
+      if (!node_private.getParam("/sensor/imu/mahony_kp", gain_1) || !node_private.getParam("/sensor/imu/mahony_ki", gain_2))
+      {
+        ROS_ERROR("[imu_node] Mahony filter gains not defined in config file: avc_sensors/config/sensors.yaml");
+        ROS_BREAK();
+      }
+    }
+
+    orientation_filter = createOrientationFilter<float>(orientation_filter_type, gain_1, gain_2);
+    if (orientation_filter == NULL)
+    {
+      ROS_ERROR("[imu_node] unknown orientation filter: %s", orientation_filter_type.c_str());
+      ROS_BREAK();
+    }
+
+  }
+
+  //create RTIMULib fusion of type configured in RTIMULib settings if no in-house orientation filter is selected
+  RTFusion *imu_fusion = NULL;
+  if (orientation_filter == NULL)
+  {
+    imu_fusion = createFusion(fusion_type);
+    imu_fusion->setSlerpPower(slerp_power);
+  }
+
+  //retrieve online compass calibration enable from parameter server
+  bool mag_calibration_enable = false;
+  if (!node_private.getParam("/sensor/imu/mag_calibration/enable", mag_calibration_enable))
+  {
+    ROS_WARN_STREAM("[imu_node] no compass calibration enable provided, using default: " << mag_calibration_enable);
+  }
+
+  //create online compass calibrator, refining the static RTIMULib calibration while driving
+  MagCalibrator *mag_calibrator = NULL;
+  if (mag_calibration_enable)
+  {
+
+    //retrieve compass calibration parameters from parameter server
+    double min_spacing;
+    double forgetting_factor;
+    int min_samples;
+    double max_residual;
+    double max_axis_ratio;
+    double prior_weight;
+    if (!node_private.getParam("/sensor/imu/mag_calibration/min_spacing", min_spacing) ||
+        !node_private.getParam("/sensor/imu/mag_calibration/forgetting_factor", forgetting_factor) ||
+        !node_private.getParam("/sensor/imu/mag_calibration/min_samples", min_samples) ||
+        !node_private.getParam("/sensor/imu/mag_calibration/max_residual", max_residual) ||
+        !node_private.getParam("/sensor/imu/mag_calibration/max_axis_ratio", max_axis_ratio) ||
+        !node_private.getParam("/sensor/imu/mag_calibration/prior_weight", prior_weight))
+    {
+      ROS_ERROR("[imu_node] compass calibration parameters not defined in config file: avc_sensors/config/sensors.yaml");
+      ROS_BREAK();
+    }
+
+    mag_calibrator = new MagCalibrator(min_spacing, forgetting_factor, min_samples, max_residual, max_axis_ratio, prior_weight);
+    mag_calibrator->start();
+
+  }
+
+  //number of compass calibrations applied so far
+  unsigned int mag_calibration_count = 0;
+
+  //retrieve standstill gyro bias estimation enable from parameter server
+  bool gyro_bias_enable = false;
+  if (!node_private.getParam("/sensor/imu/gyro_bias/enable", gyro_bias_enable))
+  {
+    ROS_WARN_STREAM("[imu_node] no gyro bias estimation enable provided, using default: " << gyro_bias_enable);
+  }
+
+  //create gyro bias estimator, removing gyro drift measured while the vehicle stands still
+  if (gyro_bias_enable)
+  {
+
+    //retrieve standstill detection and bias averaging parameters from parameter server
+    double max_accel_variance;
+    double max_gyro_rate;
+    double max_throttle;
+    double min_standstill_time;
+    double variance_time_constant;
+    double bias_time_constant;
+    if (!node_private.getParam("/sensor/imu/gyro_bias/max_accel_variance", max_accel_variance) ||
+        !node_private.getParam("/sensor/imu/gyro_bias/max_gyro_rate", max_gyro_rate) ||
+        !node_private.getParam("/sensor/imu/gyro_bias/max_throttle", max_throttle) ||
+        !node_private.getParam("/sensor/imu/gyro_bias/min_standstill_time", min_standstill_time) ||
+        !node_private.getParam("/sensor/imu/gyro_bias/variance_time_constant", variance_time_constant) ||
+        !node_private.getParam("/sensor/imu/gyro_bias/bias_time_constant", bias_time_constant))
+    {
+      ROS_ERROR("[imu_node] gyro bias estimation parameters not defined in config file: avc_sensors/config/sensors.yaml");
+      ROS_BREAK();
+    }
+
+    gyro_bias_estimator = new GyroBiasEstimator(max_accel_variance, max_gyro_rate, max_throttle, min_standstill_time, variance_time_constant, bias_time_constant);
+
+  }
+
+  //standstill state of previous sample, used to report changes
+  bool standstill = false;
 
   //create geometry_msgs/Imu type message to publish IMU data
   sensor_msgs::Imu imu_msg;
@@ -138,32 +372,133 @@ int main(int argc, char **argv)
   std::vector<double> magnetic_field_covariance(9, 0);
   std::copy(magnetic_field_covariance.begin(), magnetic_field_covariance.end(), std::begin(compass_msg.magnetic_field_covariance));
 
-  //create publisher to publish compass messages with buffer size 1, and latch set to false
-  ros::Publisher compass_pub = node_public.advertise<sensor_msgs::MagneticField>("compass", 1, false);
+  //retrieve rate at which batches of samples are published from parameter server
+  float publish_rate;
+  if (!node_private.getParam("/sensor/imu/publish_rate", publish_rate))
+  {
+    ROS_ERROR("[imu_node] IMU publish rate not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //retrieve sample decimation from parameter server (1 = publish every sample)
+  int decimation;
+  if (!node_private.getParam("/sensor/imu/decimation", decimation) || (decimation < 1))
+  {
+    ROS_ERROR("[imu_node] IMU decimation not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //create publisher to publish compass messages with buffer size of one batch, and latch set to false
+  ros::Publisher compass_pub = node_public.advertise<sensor_msgs::MagneticField>("compass", PUBLISH_QUEUE_SIZE, false);
+
+  //create publisher to publish compass heading messages with buffer size of one batch, and latch set to false
+  ros::Publisher heading_pub = node_public.advertise<avc_msgs::Heading>("heading", PUBLISH_QUEUE_SIZE, false);
+
+  //create publisher to publish IMU messages with buffer size of one batch, and latch set to false
+  ros::Publisher imu_pub = node_public.advertise<sensor_msgs::Imu>("imu", PUBLISH_QUEUE_SIZE, false);
+
+  //create subscriber to subscribe to hardware ESC topic with queue size set to 1
+  ros::Subscriber esc_sub = node_public.subscribe("/hardware/esc", 1, escCallback);
 
-  //create publisher to publish compass heading messages with buffer size 1, and latch set to false
-  ros::Publisher heading_pub = node_public.advertise<avc_msgs::Heading>("heading", 1, false);
+  //start acquisition thread
+  std::thread acquisition_thread(acquisitionThread, imu_source);
 
-  //create publisher to publish IMU messages with buffer size 1, and latch set to false
-  ros::Publisher imu_pub = node_public.advertise<sensor_msgs::Imu>("imu", 1, false);
+  //raise acquisition thread to real-time priority so sampling is not delayed by publishing (requires root)
+  sched_param acquisition_param;
+  acquisition_param.sched_priority = sched_get_priority_max(SCHED_FIFO) / 2;
+  if (pthread_setschedparam(acquisition_thread.native_handle(), SCHED_FIFO, &acquisition_param) != 0)
+    ROS_WARN("[imu_node] failed to set real-time priority of acquisition thread, running at normal priority");
+
+  //number of samples received since last published sample
+  int sample_count = 0;
+
+  //timestamp of previous sample, used to integrate in-house orientation filter [us]
+  uint64_t last_timestamp = 0;
+
+  //set refresh rate of ROS loop to defined publish rate parameter
+  ros::Rate loop_rate(publish_rate);
 
   while (ros::ok())
   {
 
-    if (imu->IMURead())
+    //publish every decimated sample received since last cycle
+    RTIMU_DATA imu_data;
+    while (imu_samples.pop(imu_data))
     {
 
-      //get current IMU data
-      RTIMU_DATA imu_data = imu->getIMUData();
+      //record raw sample to IMU log
+      if (!record_file.empty() && !record_log.write(imu_data))
+        ROS_ERROR_THROTTLE(1, "[imu_node] failed to write IMU log: %s", record_file.c_str());
+
+      //pass compass sample to online calibration and apply current calibration
+      if ((mag_calibrator != NULL) && imu_data.compassValid)
+      {
+        double x = imu_data.compass.x();
+        double y = imu_data.compass.y();
+        double z = imu_data.compass.z();
+        mag_calibrator->addSample(x, y, z);
+        mag_calibrator->correct(x, y, z);
+        imu_data.compass = RTVector3(x, y, z);
+      }
+
+      //update standstill detection and gyro bias estimate, then remove bias from gyro rates
+      if (gyro_bias_estimator != NULL)
+      {
+        double x = imu_data.gyro.x();
+        double y = imu_data.gyro.y();
+        double z = imu_data.gyro.z();
+        double dt = (last_timestamp > 0) ? (imu_data.timestamp - last_timestamp) / 1000000.0 : 0;
+        gyro_bias_estimator->update(x, y, z, imu_data.accel.x(), imu_data.accel.y(), imu_data.accel.z(), dt);
+        gyro_bias_estimator->correct(x, y, z);
+        imu_data.gyro = RTVector3(x, y, z);
+      }
+
+      //update RTIMULib fusion with every sample
+      if (imu_fusion != NULL)
+        imu_fusion->newIMUData(imu_data, imu_settings);
+
+      //update in-house orientation filter with every sample, ignoring compass data if it is not valid
+      if (orientation_filter != NULL)
+      {
+        float dt = (last_timestamp > 0) ? (imu_data.timestamp - last_timestamp) / 1000000.0 : 0;
+        if (imu_data.compassValid)
+          orientation_filter->update(imu_data.gyro.x(), imu_data.gyro.y(), imu_data.gyro.z(), imu_data.accel.x(), imu_data.accel.y(), imu_data.accel.z(), imu_data.compass.x(), imu_data.compass.y(), imu_data.compass.z(), dt);
+        else
+          orientation_filter->update(imu_data.gyro.x(), imu_data.gyro.y(), imu_data.gyro.z(), imu_data.accel.x(), imu_data.accel.y(), imu_data.accel.z(), 0, 0, 0, dt);
+      }
+      last_timestamp = imu_data.timestamp;
+
+      //skip samples between decimated samples
+      if (++sample_count < decimation)
+        continue;
+      sample_count = 0;
+
+      //get time sample was read from IMU
+      ros::Time sample_time = toRosTime(imu_data.timestamp);
 
       //set IMU message headers
-      imu_msg.header.stamp = ros::Time::now();
+      imu_msg.header.stamp = sample_time;
 
-      //set IMU message angles
-      imu_msg.orientation.x = imu_data.fusionQPose.x();
-      imu_msg.orientation.y = imu_data.fusionQPose.y();
-      imu_msg.orientation.z = imu_data.fusionQPose.z();
-      imu_msg.orientation.w = imu_data.fusionQPose.scalar();
+      //set IMU message angles from selected orientation filter
+      float yaw;
+      if (orientation_filter != NULL)
+      {
+        float w, x, y, z;
+        orientation_filter->getQuaternion(w, x, y, z);
+        imu_msg.orientation.x = x;
+        imu_msg.orientation.y = y;
+        imu_msg.orientation.z = z;
+        imu_msg.orientation.w = w;
+        yaw = orientation_filter->getYaw();
+      }
+      else
+      {
+        imu_msg.orientation.x = imu_data.fusionQPose.x();
+        imu_msg.orientation.y = imu_data.fusionQPose.y();
+        imu_msg.orientation.z = imu_data.fusionQPose.z();
+        imu_msg.orientation.w = imu_data.fusionQPose.scalar();
+        yaw = imu_data.fusionPose.z();
+      }
 
       //set IMU message angular velocities
       imu_msg.angular_velocity.x = imu_data.gyro.x();
@@ -184,7 +519,7 @@ int main(int argc, char **argv)
       {
 
         //set compass message headers
-        compass_msg.header.stamp = ros::Time::now();
+        compass_msg.header.stamp = sample_time;
 
         //set compass message magnetic field values
         //values are returned from IMU in units of microTeslas, therefore must be divided by 10^6 to convert to Teslas
@@ -196,10 +531,10 @@ int main(int argc, char **argv)
         compass_pub.publish(compass_msg);
 
         //set heading message headers
-        heading_msg.header.stamp = ros::Time::now();
+        heading_msg.header.stamp = sample_time;
 
         //get yaw value and convert to degrees [deg]
-        heading_msg.heading_angle = imu_data.fusionPose.z() / PI * 180;
+        heading_msg.heading_angle = yaw / PI * 180;
 
         //normalize yaw value to compass heading in degrees (0 - 360 deg)
         if (heading_msg.heading_angle < 90)
@@ -211,18 +546,61 @@ int main(int argc, char **argv)
         heading_pub.publish(heading_msg);
 
         //output debug data to log
-        ROS_DEBUG("[imu_node] current yaw: %f, current heading: %f", imu_data.fusionPose.z(), heading_msg.heading_angle);
+        ROS_DEBUG("[imu_node] current yaw: %f, current heading: %f", yaw, heading_msg.heading_angle);
 
       }
 
     }
 
+    //warn if samples were dropped because the ring was full
+    unsigned int lost = lost_samples.exchange(0);
+    if (lost > 0)
+      ROS_WARN("[imu_node] %u IMU samples lost, publish loop too slow for IMU sample rate", lost);
+
+    //report newly applied compass calibration
+    if ((mag_calibrator != NULL) && (mag_calibrator->getUpdateCount() != mag_calibration_count))
+    {
+      mag_calibration_count = mag_calibrator->getUpdateCount();
+      double offset[3];
+      double matrix[9];
+      mag_calibrator->getCalibration(offset, matrix);
+      ROS_INFO("[imu_node] compass calibration %u applied, offset: %f, %f, %f, residual: %f", mag_calibration_count, offset[0], offset[1], offset[2], mag_calibrator->getResidual());
+    }
+
+    //report standstill changes and bias estimate
+    if ((gyro_bias_estimator != NULL) && (gyro_bias_estimator->isStandstill() != standstill))
+    {
+      standstill = gyro_bias_estimator->isStandstill();
+      double x, y, z;
+      gyro_bias_estimator->getBias(x, y, z);
+      ROS_DEBUG("[imu_node] standstill: %d, gyro bias: %f, %f, %f", standstill, x, y, z);
+    }
+
+    //shut down once every sample of a replayed log has been published
+    if (source_finished && imu_samples.empty())
+    {
+      ROS_INFO("[imu_node] end of IMU log reached");
+      break;
+    }
+
     //process callback functions
     ros::spinOnce();
 
-    //sleep until next IMU reading
-    ros::Duration(imu->IMUGetPollInterval() / 1000.0).sleep();
+    //sleep until next batch
+    loop_rate.sleep();
 
   }
+
+  //stop acquisition thread before IMU source is released
+  acquiring = false;
+  acquisition_thread.join();
+
+  record_log.close();
+  delete mag_calibrator;
+  delete gyro_bias_estimator;
+  delete imu_source;
+  delete imu_fusion;
+  delete orientation_filter;
+
   return 0;
 }
@@ -0,0 +1,305 @@
+//include header
+#include <imu_source.hpp>
+
+#include <string.h>
+
+//external library includes
+#include <RTFusionKalman4.h>
+#include <RTFusionRTQF.h>
+
+//IMU log file identifier and format version
+const char IMU_LOG_MAGIC[8] = { 'A', 'V', 'C', 'I', 'M', 'U', '0', '1' };
+
+static_assert(sizeof(ImuLog::Record) == 48, "IMU log record must be packed to 48 bytes");
+
+
+//IMU source base class
+
+//get functions
+
+//hardware sources never run out of samples
+bool ImuSource::isFinished()
+{
+  return false;
+}
+
+
+//IMU hardware source
+
+//default constructor
+RTIMUSource::RTIMUSource(RTIMUSettings *settings)
+{
+  this->_settings = settings;
+  this->_imu = NULL;
+}
+
+//default destructor
+RTIMUSource::~RTIMUSource()
+{
+  delete this->_imu;
+}
+
+//get functions
+
+//get IMU driver poll interval [ms]
+int RTIMUSource::getPollInterval()
+{
+  return this->_imu->IMUGetPollInterval();
+}
+
+//other functions
+
+//detect and initialize IMU, returns false if no IMU is found or it fails to initialize
+bool RTIMUSource::init()
+{
+
+  //create RTIMU type object using settings
+  this->_imu = RTIMU::createIMU(this->_settings);
+
+  //make sure IMU was detected
+  if ((this->_imu == NULL) || (this->_imu->IMUType() == RTIMU_TYPE_NULL))
+    return false;
+
+  //initialize IMU
+  if (!this->_imu->IMUInit())
+    return false;
+
+  //enable gyro, accelerometer, and compass
+  this->_imu->setGyroEnable(true);
+  this->_imu->setAccelEnable(true);
+  this->_imu->setCompassEnable(true);
+
+  return true;
+
+}
+
+//read next sample from IMU FIFO
+bool RTIMUSource::read(RTIMU_DATA& data)
+{
+
+  if (!this->_imu->IMURead())
+    return false;
+
+  data = this->_imu->getIMUData();
+  return true;
+
+}
+
+
+//binary IMU log
+
+//default constructor
+ImuLog::ImuLog()
+{
+  this->_file = NULL;
+}
+
+//default destructor
+ImuLog::~ImuLog()
+{
+  this->close();
+}
+
+//other functions
+
+//open existing log for reading and check file identifier
+bool ImuLog::openRead(const std::string& file_name)
+{
+
+  this->close();
+  this->_file = fopen(file_name.c_str(), "rb");
+  if (this->_file == NULL)
+    return false;
+
+  char magic[sizeof(IMU_LOG_MAGIC)];
+  if ((fread(magic, sizeof(magic), 1, this->_file) != 1) || (memcmp(magic, IMU_LOG_MAGIC, sizeof(magic)) != 0))
+  {
+    this->close();
+    return false;
+  }
+
+  return true;
+
+}
+
+//create new log for writing
+bool ImuLog::openWrite(const std::string& file_name)
+{
+
+  this->close();
+  this->_file = fopen(file_name.c_str(), "wb");
+  if (this->_file == NULL)
+    return false;
+
+  if (fwrite(IMU_LOG_MAGIC, sizeof(IMU_LOG_MAGIC), 1, this->_file) != 1)
+  {
+    this->close();
+    return false;
+  }
+
+  return true;
+
+}
+
+//read next raw sample from log into IMU data (fused values are not logged and left invalid)
+bool ImuLog::read(RTIMU_DATA& data)
+{
+
+  Record record;
+  if ((this->_file == NULL) || (fread(&record, sizeof(record), 1, this->_file) != 1))
+    return false;
+
+  data.timestamp = record.timestamp;
+  data.gyro = RTVector3(record.gyro[0], record.gyro[1], record.gyro[2]);
+  data.accel = RTVector3(record.accel[0], record.accel[1], record.accel[2]);
+  data.compass = RTVector3(record.compass[0], record.compass[1], record.compass[2]);
+  data.gyroValid = true;
+  data.accelValid = true;
+  data.compassValid = (record.flags & COMPASS_VALID) != 0;
+  data.fusionPoseValid = false;
+  data.fusionQPoseValid = false;
+  data.pressureValid = false;
+  data.temperatureValid = false;
+  data.humidityValid = false;
+
+  return true;
+
+}
+
+//append raw values of IMU sample to log
+bool ImuLog::write(const RTIMU_DATA& data)
+{
+
+  if (this->_file == NULL)
+    return false;
+
+  Record record;
+  record.timestamp = data.timestamp;
+  for (int i = 0; i < 3; i++)
+  {
+    record.gyro[i] = data.gyro.data(i);
+    record.accel[i] = data.accel.data(i);
+    record.compass[i] = data.compass.data(i);
+  }
+  record.flags = data.compassValid ? COMPASS_VALID : 0;
+
+  return fwrite(&record, sizeof(record), 1, this->_file) == 1;
+
+}
+
+//close log file (flushes buffered records)
+void ImuLog::close()
+{
+
+  if (this->_file != NULL)
+  {
+    fclose(this->_file);
+    this->_file = NULL;
+  }
+
+}
+
+
+//IMU log replay source
+
+//default constructor
+ImuLogSource::ImuLogSource(const std::string& file_name, double replay_rate)
+{
+  this->_file_name = file_name;
+  this->_replay_rate = replay_rate;
+  this->_finished = false;
+  this->_pending = false;
+  this->_first_timestamp = 0;
+  this->_start_timestamp = 0;
+}
+
+//default destructor
+ImuLogSource::~ImuLogSource() {}
+
+//get functions
+
+//check for due samples every millisecond [ms]
+int ImuLogSource::getPollInterval()
+{
+  return 1;
+}
+
+//returns true once every sample of the log has been released
+bool ImuLogSource::isFinished()
+{
+  return this->_finished;
+}
+
+//other functions
+
+//open log, returns false if log can't be read
+bool ImuLogSource::init()
+{
+
+  if ((this->_replay_rate <= 0) || !this->_log.openRead(this->_file_name))
+    return false;
+
+  //read first sample to get start of log
+  this->_pending = this->_log.read(this->_next);
+  this->_finished = !this->_pending;
+  this->_first_timestamp = this->_next.timestamp;
+
+  //start replay clock
+  this->_replay_start = std::chrono::steady_clock::now();
+  this->_start_timestamp = RTMath::currentUSecsSinceEpoch();
+
+  return true;
+
+}
+
+//release next logged sample once it is due
+bool ImuLogSource::read(RTIMU_DATA& data)
+{
+
+  //read next sample from log if previous one was released
+  if (!this->_pending)
+  {
+    if (this->_finished || !this->_log.read(this->_next))
+    {
+      this->_finished = true;
+      return false;
+    }
+    this->_pending = true;
+  }
+
+  //hold sample until its scaled time since start of log has elapsed
+  uint64_t log_time = this->_next.timestamp - this->_first_timestamp; //[us]
+  double elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->_replay_start).count(); //[us]
+  if (elapsed * this->_replay_rate < log_time)
+    return false;
+
+  //release sample with timestamp shifted to replay start
+  data = this->_next;
+  data.timestamp = this->_start_timestamp + log_time;
+  this->_pending = false;
+
+  return true;
+
+}
+
+
+//create RTIMULib fusion of given type, as RTIMULib does for its internal fusion
+RTFusion* createFusion(int fusion_type)
+{
+
+  RTFusion *fusion;
+  if (fusion_type == RTFUSION_TYPE_KALMANSTATE4)
+    fusion = new RTFusionKalman4();
+  else if (fusion_type == RTFUSION_TYPE_RTQF)
+    fusion = new RTFusionRTQF();
+  else
+    fusion = new RTFusion();
+
+  //enable gyro, accelerometer, and compass
+  fusion->setGyroEnable(true);
+  fusion->setAccelEnable(true);
+  fusion->setCompassEnable(true);
+
+  return fusion;
+
+}
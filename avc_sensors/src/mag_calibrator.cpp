@@ -0,0 +1,466 @@
+//include header
+#include <mag_calibrator.hpp>
+
+#include <chrono>
+#include <math.h>
+#include <pthread.h>
+
+//accepted samples between fits
+const int FIT_SAMPLES = 50;
+
+//calibration thread sleep time between checks for new samples [ms]
+const int SLEEP_TIME = 100;
+
+
+//solve n x n linear system a x = b in place by Gaussian elimination with partial pivoting (a and b are modified)
+//returns false if system is singular or badly conditioned
+static bool solve(double *a, double *b, double *x, int n)
+{
+
+  for (int col = 0; col < n; col++)
+  {
+
+    //find pivot row
+    int pivot = col;
+    for (int row = col + 1; row < n; row++)
+    {
+      if (fabs(a[row * n + col]) > fabs(a[pivot * n + col]))
+        pivot = row;
+    }
+    if (fabs(a[pivot * n + col]) < 1e-12)
+      return false;
+
+    //swap pivot row into place
+    if (pivot != col)
+    {
+      for (int i = 0; i < n; i++)
+      {
+        double temp = a[col * n + i];
+        a[col * n + i] = a[pivot * n + i];
+        a[pivot * n + i] = temp;
+      }
+      double temp = b[col];
+      b[col] = b[pivot];
+      b[pivot] = temp;
+    }
+
+    //eliminate column below pivot
+    for (int row = col + 1; row < n; row++)
+    {
+      double factor = a[row * n + col] / a[col * n + col];
+      for (int i = col; i < n; i++)
+        a[row * n + i] -= factor * a[col * n + i];
+      b[row] -= factor * b[col];
+    }
+
+  }
+
+  //back substitution
+  for (int row = n - 1; row >= 0; row--)
+  {
+    double sum = b[row];
+    for (int i = row + 1; i < n; i++)
+      sum -= a[row * n + i] * x[i];
+    x[row] = sum / a[row * n + row];
+  }
+
+  return true;
+
+}
+
+//eigen decomposition of symmetric 3 x 3 matrix by cyclic Jacobi rotations
+//eigenvalues are returned in values and eigenvectors as columns of vectors (row major)
+static void eigenSymmetric(const double matrix[9], double values[3], double vectors[9])
+{
+
+  double a[3][3];
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      a[i][j] = matrix[i * 3 + j];
+      vectors[i * 3 + j] = (i == j) ? 1 : 0;
+    }
+  }
+
+  for (int sweep = 0; sweep < 50; sweep++)
+  {
+
+    //stop once off-diagonal elements vanish
+    double off = fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]);
+    if (off < 1e-15)
+      break;
+
+    for (int p = 0; p < 2; p++)
+    {
+      for (int q = p + 1; q < 3; q++)
+      {
+
+        if (a[p][q] == 0)
+          continue;
+
+        //rotation angle that zeroes a[p][q]
+        double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+        double t = ((theta >= 0) ? 1 : -1) / (fabs(theta) + sqrt(theta * theta + 1));
+        double c = 1 / sqrt(t * t + 1);
+        double s = t * c;
+
+        //apply rotation to matrix
+        for (int k = 0; k < 3; k++)
+        {
+          double akp = a[k][p];
+          double akq = a[k][q];
+          a[k][p] = c * akp - s * akq;
+          a[k][q] = s * akp + c * akq;
+        }
+        for (int k = 0; k < 3; k++)
+        {
+          double apk = a[p][k];
+          double aqk = a[q][k];
+          a[p][k] = c * apk - s * aqk;
+          a[q][k] = s * apk + c * aqk;
+        }
+
+        //accumulate rotation into eigenvectors
+        for (int k = 0; k < 3; k++)
+        {
+          double vkp = vectors[k * 3 + p];
+          double vkq = vectors[k * 3 + q];
+          vectors[k * 3 + p] = c * vkp - s * vkq;
+          vectors[k * 3 + q] = s * vkp + c * vkq;
+        }
+
+      }
+    }
+
+  }
+
+  for (int i = 0; i < 3; i++)
+    values[i] = a[i][i];
+
+}
+
+
+//default constructor
+MagCalibrator::MagCalibrator(double min_spacing, double forgetting_factor, int min_samples, double max_residual, double max_axis_ratio, double prior_weight)
+{
+
+  //set class variable values to passed values
+  this->_min_spacing = min_spacing;
+  this->_forgetting_factor = forgetting_factor;
+  this->_min_samples = min_samples;
+  this->_max_residual = max_residual;
+  this->_max_axis_ratio = max_axis_ratio;
+  this->_prior_weight = prior_weight;
+
+  //initialize fit state
+  for (int i = 0; i < 9; i++)
+  {
+    for (int j = 0; j < 9; j++)
+      this->_dtd[i][j] = 0;
+    this->_dt1[i] = 0;
+
+    //regularize first fit towards a unit sphere at the origin
+    this->_prior[i] = (i < 3) ? 1 : 0;
+  }
+  this->_weight = 0;
+  this->_last[0] = this->_last[1] = this->_last[2] = 0;
+  this->_scale = 0;
+  this->_accepted = 0;
+  this->_count = 0;
+
+  //initialize other variables
+  this->_update_count = 0;
+  this->_running = false;
+
+}
+
+//default destructor
+MagCalibrator::~MagCalibrator()
+{
+  this->stop();
+}
+
+//get functions
+
+//returns true once a fit has been accepted
+bool MagCalibrator::isCalibrated() const
+{
+  return std::atomic_load(&this->_calibration) != NULL;
+}
+
+//get number of fits accepted so far
+unsigned int MagCalibrator::getUpdateCount() const
+{
+  return this->_update_count;
+}
+
+//get RMS algebraic residual of accepted fit (zero if not calibrated)
+double MagCalibrator::getResidual() const
+{
+  std::shared_ptr<const Calibration> calibration = std::atomic_load(&this->_calibration);
+  return (calibration != NULL) ? calibration->residual : 0;
+}
+
+//get hard-iron offset and soft-iron matrix (identity if not calibrated)
+void MagCalibrator::getCalibration(double offset[3], double matrix[9]) const
+{
+
+  std::shared_ptr<const Calibration> calibration = std::atomic_load(&this->_calibration);
+  for (int i = 0; i < 3; i++)
+    offset[i] = (calibration != NULL) ? calibration->offset[i] : 0;
+  for (int i = 0; i < 9; i++)
+    matrix[i] = (calibration != NULL) ? calibration->matrix[i] : ((i % 4 == 0) ? 1 : 0);
+
+}
+
+//other functions
+
+//start calibration thread
+void MagCalibrator::start()
+{
+
+  if (this->_running)
+    return;
+
+  this->_running = true;
+  this->_thread = std::thread(&MagCalibrator::run, this);
+
+}
+
+//stop calibration thread
+void MagCalibrator::stop()
+{
+
+  if (!this->_running)
+    return;
+
+  this->_running = false;
+  this->_thread.join();
+
+}
+
+//queue compass sample for calibration thread
+void MagCalibrator::addSample(double x, double y, double z)
+{
+
+  Sample sample;
+  sample.x = x;
+  sample.y = y;
+  sample.z = z;
+
+  //samples are only needed for fitting, so drop them if calibration thread is behind
+  this->_samples.push(sample);
+
+}
+
+//apply current calibration to compass sample
+void MagCalibrator::correct(double& x, double& y, double& z) const
+{
+
+  std::shared_ptr<const Calibration> calibration = std::atomic_load(&this->_calibration);
+  if (calibration == NULL)
+    return;
+
+  //remove hard-iron offset, then undo soft-iron distortion
+  double dx = x - calibration->offset[0];
+  double dy = y - calibration->offset[1];
+  double dz = z - calibration->offset[2];
+  const double *m = calibration->matrix;
+  x = m[0] * dx + m[1] * dy + m[2] * dz;
+  y = m[3] * dx + m[4] * dy + m[5] * dz;
+  z = m[6] * dx + m[7] * dy + m[8] * dz;
+
+}
+
+//calibration thread function
+void MagCalibrator::run()
+{
+
+  //run at idle priority so fitting never delays acquisition or publishing
+  sched_param param;
+  param.sched_priority = 0;
+  pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+  Sample sample;
+  while (this->_running)
+  {
+
+    //add queued samples to fit
+    while (this->_samples.pop(sample))
+      this->accumulate(sample);
+
+    //refit once enough new samples have been accepted
+    if ((this->_count >= this->_min_samples) && (this->_accepted >= FIT_SAMPLES))
+    {
+
+      this->_accepted = 0;
+
+      //publish new fit if it is better than current calibration on the same samples
+      Calibration calibration;
+      if (this->fit(calibration))
+      {
+        std::shared_ptr<const Calibration> current = std::atomic_load(&this->_calibration);
+        if ((current == NULL) || (calibration.residual < this->residual(current->quadric)))
+        {
+          std::atomic_store(&this->_calibration, std::shared_ptr<const Calibration>(new Calibration(calibration)));
+          this->_update_count++;
+
+          //regularize following fits towards accepted one
+          for (int i = 0; i < 9; i++)
+            this->_prior[i] = calibration.quadric[i];
+        }
+      }
+
+    }
+
+    //sleep until more samples are queued
+    std::this_thread::sleep_for(std::chrono::milliseconds(SLEEP_TIME));
+
+  }
+
+}
+
+//add sample to normal equations of quadric fit
+void MagCalibrator::accumulate(const Sample& sample)
+{
+
+  //normalize samples by magnitude of first sample to keep fit well conditioned
+  if (this->_scale == 0)
+  {
+    this->_scale = sqrt(sample.x * sample.x + sample.y * sample.y + sample.z * sample.z);
+    if (this->_scale == 0)
+      return;
+  }
+
+  //ignore samples close to last accepted sample so time spent in one orientation doesn't dominate fit
+  double dx = sample.x - this->_last[0];
+  double dy = sample.y - this->_last[1];
+  double dz = sample.z - this->_last[2];
+  if ((this->_count > 0) && (sqrt(dx * dx + dy * dy + dz * dz) < this->_min_spacing))
+    return;
+  this->_last[0] = sample.x;
+  this->_last[1] = sample.y;
+  this->_last[2] = sample.z;
+
+  //quadric terms of normalized sample: a x^2 + b y^2 + c z^2 + 2d xy + 2e xz + 2f yz + 2g x + 2h y + 2i z = 1
+  double x = sample.x / this->_scale;
+  double y = sample.y / this->_scale;
+  double z = sample.z / this->_scale;
+  double row[9] = { x * x, y * y, z * z, 2 * x * y, 2 * x * z, 2 * y * z, 2 * x, 2 * y, 2 * z };
+
+  //fade old samples so calibration follows slow changes, then add new sample
+  for (int i = 0; i < 9; i++)
+  {
+    for (int j = 0; j < 9; j++)
+      this->_dtd[i][j] = this->_forgetting_factor * this->_dtd[i][j] + row[i] * row[j];
+    this->_dt1[i] = this->_forgetting_factor * this->_dt1[i] + row[i];
+  }
+  this->_weight = this->_forgetting_factor * this->_weight + 1;
+
+  this->_accepted++;
+  this->_count++;
+
+}
+
+//fit ellipsoid to accumulated samples and convert to calibration coefficients
+//returns false if fit isn't a plausible ellipsoid
+bool MagCalibrator::fit(Calibration& calibration)
+{
+
+  //solve regularized normal equations (unobserved directions, e.g. z while driving on level ground, stay near prior)
+  double a[81];
+  double b[9];
+  for (int i = 0; i < 9; i++)
+  {
+    for (int j = 0; j < 9; j++)
+      a[i * 9 + j] = this->_dtd[i][j] + ((i == j) ? this->_prior_weight : 0);
+    b[i] = this->_dt1[i] + this->_prior_weight * this->_prior[i];
+  }
+  double *q = calibration.quadric;
+  if (!solve(a, b, q, 9))
+    return false;
+
+  //quadric matrix and linear terms
+  double quadric_matrix[9] = { q[0], q[3], q[4], q[3], q[1], q[5], q[4], q[5], q[2] };
+  double linear[3] = { -q[6], -q[7], -q[8] };
+
+  //ellipsoid center solves quadric_matrix * center = -linear terms
+  double center[3];
+  double center_matrix[9];
+  for (int i = 0; i < 9; i++)
+    center_matrix[i] = quadric_matrix[i];
+  if (!solve(center_matrix, linear, center, 3))
+    return false;
+
+  //shifted to its center the ellipsoid is x^T M x = 1 with M = quadric_matrix / (1 + center^T quadric_matrix center)
+  double k = 1;
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+      k += center[i] * quadric_matrix[i * 3 + j] * center[j];
+  }
+  if (k <= 0)
+    return false;
+
+  //ellipsoid axes are eigenvectors of M, with radii 1 / sqrt(eigenvalue)
+  double m[9];
+  for (int i = 0; i < 9; i++)
+    m[i] = quadric_matrix[i] / k;
+  double values[3];
+  double vectors[9];
+  eigenSymmetric(m, values, vectors);
+  if ((values[0] <= 0) || (values[1] <= 0) || (values[2] <= 0))
+    return false;
+
+  //reject fits with implausible soft-iron distortion
+  double min_value = fmin(values[0], fmin(values[1], values[2]));
+  double max_value = fmax(values[0], fmax(values[1], values[2]));
+  if (sqrt(max_value / min_value) > this->_max_axis_ratio)
+    return false;
+
+  //reject fits that don't describe the samples well
+  calibration.residual = this->residual(q);
+  if (calibration.residual > this->_max_residual)
+    return false;
+
+  //soft-iron matrix maps ellipsoid onto sphere of the same volume: radius * V * sqrt(values) * V^T
+  double radius = pow(values[0] * values[1] * values[2], -1.0 / 6);
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      double sum = 0;
+      for (int l = 0; l < 3; l++)
+        sum += vectors[i * 3 + l] * sqrt(values[l]) * vectors[j * 3 + l];
+      calibration.matrix[i * 3 + j] = radius * sum;
+    }
+  }
+
+  //hard-iron offset in input units
+  for (int i = 0; i < 3; i++)
+    calibration.offset[i] = center[i] * this->_scale;
+
+  return true;
+
+}
+
+//get RMS algebraic residual of quadric over accumulated samples
+double MagCalibrator::residual(const double quadric[9])
+{
+
+  if (this->_weight <= 0)
+    return 0;
+
+  //sum of (row * quadric - 1)^2 = q^T (D^T D) q - 2 q^T (D^T 1) + n
+  double sum = this->_weight;
+  for (int i = 0; i < 9; i++)
+  {
+    sum -= 2 * quadric[i] * this->_dt1[i];
+    for (int j = 0; j < 9; j++)
+      sum += quadric[i] * this->_dtd[i][j] * quadric[j];
+  }
+
+  return sqrt(fmax(sum, 0) / this->_weight);
+
+}
@@ -0,0 +1,363 @@
+//NMEA benchmark
+//measures the cost of framing and parsing NMEA sentences with nmea_parser against string splitting and strtod parsing
+//(the approach of the Python nmea_navsat_driver), then feeds the log through a pseudo terminal to measure CPU use and latency of the serial read path
+//usage: rosrun avc_sensors nmea_benchmark [log_file (recorded or plain text) or - for a simulated log] [sentence_rate]
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <nmea_log.hpp>
+#include <nmea_parser.hpp>
+#include <pseudo_terminal.hpp>
+#include <serial_port.hpp>
+
+//number of times log is parsed in memory
+const int PARSE_ITERATIONS = 200;
+
+//bytes handed to parser per read, roughly what one serial read returns at 57600 baud
+const size_t READ_CHUNK_SIZE = 64;
+
+
+//append sentence with checksum and line ending to log
+void appendSentence(std::string& log, const char *body)
+{
+
+  char sentence[NMEA_MAX_SENTENCE_LENGTH + 1];
+  log.append(sentence, formatNmeaSentence(body, sentence, sizeof(sentence)));
+
+}
+
+//generate simulated log of GGA, RMC, and GSV sentences of a receiver driving in a circle
+std::string generateLog(int epochs)
+{
+
+  std::string log;
+  char body[128];
+  for (int i = 0; i < epochs; i++)
+  {
+
+    double t = i * 0.1;
+    double latitude = 4000.0 + 0.02 * sin(t * 0.1);
+    double longitude = 10500.0 + 0.02 * cos(t * 0.1);
+    int seconds = 12 * 3600 + (int)t;
+    int hundredths = (int)((t - (int)t) * 100 + 0.5);
+
+    snprintf(body, sizeof(body), "GPGGA,%02d%02d%02d.%02d,%09.4f,N,%010.4f,W,1,09,0.92,1609.3,M,-21.3,M,,",
+             seconds / 3600, (seconds / 60) % 60, seconds % 60, hundredths, latitude, longitude);
+    appendSentence(log, body);
+
+    snprintf(body, sizeof(body), "GPRMC,%02d%02d%02d.%02d,A,%09.4f,N,%010.4f,W,%.2f,%.2f,160618,,,A",
+             seconds / 3600, (seconds / 60) % 60, seconds % 60, hundredths, latitude, longitude, 4.5, fmod(t * 5.7, 360.0));
+    appendSentence(log, body);
+
+    if ((i % 10) == 0)
+      appendSentence(log, "GPGSV,3,1,11,07,79,048,42,02,51,062,43,26,36,256,42,27,27,138,42");
+
+  }
+
+  return log;
+
+}
+
+//framer based parsing, returns sum of parsed values so the work can't be discarded
+double parseFramed(const std::string& log, int& sentences)
+{
+
+  NmeaFramer framer;
+  NmeaGGA gga;
+  NmeaRMC rmc;
+  double checksum = 0;
+
+  for (size_t position = 0; position < log.size(); position += READ_CHUNK_SIZE)
+  {
+
+    size_t size;
+    char *buffer = framer.getWriteBuffer(size);
+    size_t count = std::min(std::min(size, READ_CHUNK_SIZE), log.size() - position);
+    log.copy(buffer, count, position);
+    framer.commit(count);
+
+    const char *sentence;
+    size_t length;
+    while (framer.next(sentence, length))
+    {
+      sentences++;
+      if (parseGGA(sentence, length, gga))
+        checksum += gga.latitude + gga.longitude + gga.altitude + gga.hdop;
+      else if (parseRMC(sentence, length, rmc))
+        checksum += rmc.latitude + rmc.longitude + rmc.speed + rmc.course;
+    }
+
+  }
+
+  return checksum;
+
+}
+
+//string splitting based parsing, as done by the Python driver (one string per line and per field, strtod for numbers)
+double parseSplit(const std::string& log, int& sentences)
+{
+
+  double checksum = 0;
+  std::string pending;
+
+  for (size_t position = 0; position < log.size(); position += READ_CHUNK_SIZE)
+  {
+
+    pending += log.substr(position, READ_CHUNK_SIZE);
+
+    size_t newline;
+    while ((newline = pending.find('\n')) != std::string::npos)
+    {
+
+      std::string line = pending.substr(0, newline);
+      pending.erase(0, newline + 1);
+      if (!line.empty() && (line[line.size() - 1] == '\r'))
+        line.erase(line.size() - 1);
+
+      //verify checksum
+      size_t star = line.find('*');
+      if ((line.empty()) || (line[0] != '$') || (star == std::string::npos))
+        continue;
+      unsigned char sum = 0;
+      for (size_t i = 1; i < star; i++)
+        sum ^= line[i];
+      if (sum != strtol(line.substr(star + 1).c_str(), NULL, 16))
+        continue;
+      sentences++;
+
+      //split fields
+      std::vector<std::string> fields;
+      size_t start = 0;
+      std::string data = line.substr(0, star);
+      while (true)
+      {
+        size_t comma = data.find(',', start);
+        fields.push_back(data.substr(start, comma - start));
+        if (comma == std::string::npos)
+          break;
+        start = comma + 1;
+      }
+
+      std::string type = fields[0].substr(3);
+      if ((type == "GGA") && (fields.size() >= 12))
+      {
+        double latitude = strtod(fields[2].substr(0, 2).c_str(), NULL) + strtod(fields[2].substr(2).c_str(), NULL) / 60;
+        double longitude = strtod(fields[4].substr(0, 3).c_str(), NULL) + strtod(fields[4].substr(3).c_str(), NULL) / 60;
+        checksum += latitude + (fields[5] == "W" ? -longitude : longitude) + strtod(fields[9].c_str(), NULL) + strtod(fields[8].c_str(), NULL);
+      }
+      else if ((type == "RMC") && (fields.size() >= 10))
+      {
+        double latitude = strtod(fields[3].substr(0, 2).c_str(), NULL) + strtod(fields[3].substr(2).c_str(), NULL) / 60;
+        double longitude = strtod(fields[5].substr(0, 3).c_str(), NULL) + strtod(fields[5].substr(3).c_str(), NULL) / 60;
+        checksum += latitude + (fields[6] == "W" ? -longitude : longitude) + strtod(fields[7].c_str(), NULL) * 0.514444444444 + strtod(fields[8].c_str(), NULL) * M_PI / 180;
+      }
+
+    }
+
+  }
+
+  return checksum;
+
+}
+
+//run parse function over log and print average time per sentence
+template <typename F>
+void runParseBenchmark(const char *name, const std::string& log, F parse)
+{
+
+  int sentences = 0;
+  double checksum = 0;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < PARSE_ITERATIONS; i++)
+    checksum += parse(log, sentences);
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  double elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  printf("%-32s %8.1f ns/sentence (checksum %.3f)\n", name, elapsed_ns / sentences, checksum);
+
+}
+
+//get CPU time used by calling thread [s]
+double threadCpuTime()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_THREAD, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+//pseudo terminal writer thread, writes one sentence at a time at given rate and records when each was written
+void writerThread(int fd, const std::vector<std::string>* sentences, double sentence_rate, std::vector<std::chrono::steady_clock::time_point>* write_times)
+{
+
+  std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+  std::chrono::nanoseconds period((long long)(1e9 / sentence_rate));
+  for (size_t i = 0; i < sentences->size(); i++)
+  {
+    std::this_thread::sleep_until(next);
+    next += period;
+    (*write_times)[i] = std::chrono::steady_clock::now();
+    while (write(fd, (*sentences)[i].data(), (*sentences)[i].size()) < 0)
+    {
+      //wait for reader to make room in terminal buffer
+      if (errno != EAGAIN)
+        return;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+}
+
+int main(int argc, char **argv)
+{
+
+  if (argc > 3)
+  {
+    fprintf(stderr, "usage: nmea_benchmark [log_file or -] [sentence_rate]\n");
+    return 1;
+  }
+
+  //load recorded NMEA log, plain text NMEA file, or generate 100 s of 10 Hz sentences if none is given
+  std::string log;
+  NmeaLog nmea_log;
+  if ((argc >= 2) && nmea_log.openRead(argv[1]))
+  {
+    char chunk[4096];
+    size_t count;
+    uint64_t timestamp;
+    while (nmea_log.read(chunk, sizeof(chunk), count, timestamp))
+      log.append(chunk, count);
+    nmea_log.close();
+  }
+  else if ((argc >= 2) && (std::string(argv[1]) != "-"))
+  {
+    FILE *file = fopen(argv[1], "rb");
+    if (file == NULL)
+    {
+      fprintf(stderr, "failed to open NMEA log: %s\n", argv[1]);
+      return 1;
+    }
+    char chunk[4096];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0)
+      log.append(chunk, count);
+    fclose(file);
+  }
+  else
+    log = generateLog(1000);
+
+  //get rate at which sentences are fed through pseudo terminal (default 200 sentences per second)
+  double sentence_rate = 200;
+  if (argc == 3)
+    sentence_rate = atof(argv[2]);
+  if (sentence_rate <= 0)
+  {
+    fprintf(stderr, "sentence rate must be greater than zero\n");
+    return 1;
+  }
+
+  //--------------------------------PARSING-------------------------------------
+
+  printf("log size: %zu bytes, parse iterations: %d\n", log.size(), PARSE_ITERATIONS);
+  runParseBenchmark("string split and strtod", log, parseSplit);
+  runParseBenchmark("NmeaFramer and nmea_parser", log, parseFramed);
+
+  //------------------------------PSEUDO TERMINAL-------------------------------
+
+  //split log into sentences so each is written (and timed) separately
+  std::vector<std::string> sentences;
+  size_t start = 0;
+  size_t newline;
+  while ((newline = log.find('\n', start)) != std::string::npos)
+  {
+    sentences.push_back(log.substr(start, newline - start + 1));
+    start = newline + 1;
+  }
+
+  //create pseudo terminal, writer uses master side and reader opens slave side like a serial device
+  PseudoTerminal terminal;
+  if (!terminal.open(""))
+  {
+    fprintf(stderr, "failed to create pseudo terminal\n");
+    return 1;
+  }
+
+  SerialPort port;
+  if (!port.open(terminal.getSlaveName(), 57600))
+  {
+    fprintf(stderr, "failed to open pseudo terminal %s\n", terminal.getSlaveName().c_str());
+    return 1;
+  }
+
+  printf("feeding %zu sentences through %s at %.0f sentences/s\n", sentences.size(), terminal.getSlaveName().c_str(), sentence_rate);
+
+  std::vector<std::chrono::steady_clock::time_point> write_times(sentences.size());
+  std::vector<double> latencies;
+  latencies.reserve(sentences.size());
+
+  std::thread writer(writerThread, terminal.getFileDescriptor(), &sentences, sentence_rate, &write_times);
+
+  //read, frame, and parse sentences as gps_node does, timing each from write to parsed
+  NmeaFramer framer;
+  NmeaGGA gga;
+  NmeaRMC rmc;
+  size_t received = 0;
+  double cpu_start = threadCpuTime();
+  std::chrono::steady_clock::time_point wall_start = std::chrono::steady_clock::now();
+  while (received < sentences.size())
+  {
+
+    size_t size;
+    char *buffer = framer.getWriteBuffer(size);
+    ssize_t count = port.read(buffer, size, 1000);
+    if (count <= 0)
+      break;
+    framer.commit(count);
+
+    const char *sentence;
+    size_t length;
+    while (framer.next(sentence, length))
+    {
+      if (!parseGGA(sentence, length, gga))
+        parseRMC(sentence, length, rmc);
+      std::chrono::steady_clock::time_point parsed = std::chrono::steady_clock::now();
+      if (received < sentences.size())
+        latencies.push_back(std::chrono::duration<double, std::micro>(parsed - write_times[received]).count());
+      received++;
+    }
+
+  }
+  double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+  double cpu_time = threadCpuTime() - cpu_start;
+
+  writer.join();
+  port.close();
+  terminal.close();
+
+  if (latencies.empty())
+  {
+    fprintf(stderr, "no sentences received through pseudo terminal\n");
+    return 1;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  double mean = 0;
+  for (size_t i = 0; i < latencies.size(); i++)
+    mean += latencies[i];
+  mean /= latencies.size();
+
+  printf("received sentences: %zu of %zu (checksum errors %u)\n", received, sentences.size(), framer.getChecksumErrors());
+  printf("reader CPU: %.3f s over %.1f s (%.2f %%, %.1f us/sentence)\n", cpu_time, wall_time, 100 * cpu_time / wall_time, 1e6 * cpu_time / received);
+  printf("write to parsed latency: mean %.1f us, median %.1f us, 99th percentile %.1f us, max %.1f us\n",
+         mean, latencies[latencies.size() / 2], latencies[(latencies.size() * 99) / 100], latencies.back());
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+//include header
+#include <nmea_log.hpp>
+
+#include <string.h>
+
+//file identifier written at start of every NMEA log
+const char NMEA_LOG_MAGIC[8] = { 'A', 'V', 'C', 'N', 'M', 'E', 'A', '1' };
+
+
+//default constructor
+NmeaLog::NmeaLog()
+{
+  this->_file = NULL;
+}
+
+//default destructor
+NmeaLog::~NmeaLog()
+{
+  this->close();
+}
+
+//other functions
+
+//open existing log for reading and check file identifier
+bool NmeaLog::openRead(const std::string& file_name)
+{
+
+  this->close();
+  this->_file = fopen(file_name.c_str(), "rb");
+  if (this->_file == NULL)
+    return false;
+
+  char magic[sizeof(NMEA_LOG_MAGIC)];
+  if ((fread(magic, sizeof(magic), 1, this->_file) != 1) || (memcmp(magic, NMEA_LOG_MAGIC, sizeof(magic)) != 0))
+  {
+    this->close();
+    return false;
+  }
+
+  return true;
+
+}
+
+//create new log for writing
+bool NmeaLog::openWrite(const std::string& file_name)
+{
+
+  this->close();
+  this->_file = fopen(file_name.c_str(), "wb");
+  if (this->_file == NULL)
+    return false;
+
+  if (fwrite(NMEA_LOG_MAGIC, sizeof(NMEA_LOG_MAGIC), 1, this->_file) != 1)
+  {
+    this->close();
+    return false;
+  }
+
+  return true;
+
+}
+
+//read next chunk of bytes and its arrival time, bytes that don't fit into buffer are skipped
+bool NmeaLog::read(char *buffer, size_t size, size_t& length, uint64_t& timestamp)
+{
+
+  Record record;
+  if ((this->_file == NULL) || (fread(&record, sizeof(record), 1, this->_file) != 1))
+    return false;
+
+  length = (record.length < size) ? record.length : size;
+  if (fread(buffer, 1, length, this->_file) != length)
+    return false;
+  if ((length < record.length) && (fseek(this->_file, record.length - length, SEEK_CUR) != 0))
+    return false;
+
+  timestamp = record.timestamp;
+  return true;
+
+}
+
+//append chunk of bytes with its arrival time
+bool NmeaLog::write(const char *data, size_t length, uint64_t timestamp)
+{
+
+  if (this->_file == NULL)
+    return false;
+
+  Record record;
+  record.timestamp = timestamp;
+  record.length = length;
+
+  return (fwrite(&record, sizeof(record), 1, this->_file) == 1) && (fwrite(data, 1, length, this->_file) == length);
+
+}
+
+//close log file (flushes buffered chunks)
+void NmeaLog::close()
+{
+
+  if (this->_file != NULL)
+  {
+    fclose(this->_file);
+    this->_file = NULL;
+  }
+
+}
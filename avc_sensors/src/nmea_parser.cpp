@@ -0,0 +1,443 @@
+//include header
+#include <nmea_parser.hpp>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+//math constants
+static const double PI = 3.1415926535897;
+
+//knots to m/s conversion factor
+static const double KNOTS_TO_MPS = 0.514444444444;
+
+//powers of ten used to scale parsed decimal digits
+static const double POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+
+
+//convert hex character to value, returns -1 if character isn't a hex digit
+static int hexValue(char c)
+{
+
+  if ((c >= '0') && (c <= '9'))
+    return c - '0';
+  if ((c >= 'A') && (c <= 'F'))
+    return c - 'A' + 10;
+  if ((c >= 'a') && (c <= 'f'))
+    return c - 'a' + 10;
+
+  return -1;
+
+}
+
+//returns true if sentence between "$" and "*" XORs to the two hex digit checksum following "*"
+static bool verifyChecksum(const char *sentence, size_t length)
+{
+
+  //shortest sentence is "$" + five character address + "*hh"
+  if ((length < 9) || (sentence[length - 3] != '*'))
+    return false;
+
+  int high = hexValue(sentence[length - 2]);
+  int low = hexValue(sentence[length - 1]);
+  if ((high < 0) || (low < 0))
+    return false;
+
+  unsigned char checksum = 0;
+  for (size_t i = 1; i < length - 3; i++)
+    checksum ^= sentence[i];
+
+  return checksum == ((high << 4) | low);
+
+}
+
+//parse decimal number from characters [begin, end), returns NaN if field is empty or not a number
+static double parseNumber(const char *begin, const char *end)
+{
+
+  if (begin == end)
+    return NAN;
+
+  bool negative = false;
+  if ((*begin == '-') || (*begin == '+'))
+  {
+    negative = (*begin == '-');
+    begin++;
+  }
+
+  //accumulate up to 18 significant digits as an integer and count digits after decimal point
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int decimals = 0;
+  int exponent = 0;
+  bool point = false;
+  bool any = false;
+  for (const char *c = begin; c != end; c++)
+  {
+    if ((*c >= '0') && (*c <= '9'))
+    {
+      any = true;
+      if (digits < 18)
+      {
+        mantissa = mantissa * 10 + (*c - '0');
+        if (mantissa != 0)
+          digits++;
+        if (point)
+          decimals++;
+      }
+      else if (!point)
+        exponent++;
+    }
+    else if ((*c == '.') && !point)
+      point = true;
+    else
+      return NAN;
+  }
+  if (!any)
+    return NAN;
+
+  double value = (double)mantissa;
+  if (decimals > 18)
+    value /= pow(10, decimals);
+  else if (decimals > 0)
+    value /= POWERS_OF_TEN[decimals];
+  else if (exponent > 0)
+    value *= pow(10, exponent);
+
+  return negative ? -value : value;
+
+}
+
+//parse unsigned integer from characters [begin, end), returns -1 if field is empty or not an integer
+static int parseInteger(const char *begin, const char *end)
+{
+
+  if (begin == end)
+    return -1;
+
+  int value = 0;
+  for (const char *c = begin; c != end; c++)
+  {
+    if ((*c < '0') || (*c > '9'))
+      return -1;
+    value = value * 10 + (*c - '0');
+  }
+
+  return value;
+
+}
+
+//parse NMEA angle in (d)ddmm.mmmm format with given number of degree digits and apply hemisphere sign, returns NaN if field is empty
+static double parseAngle(const char *begin, const char *end, size_t degree_digits, const char *hemisphere, const char *hemisphere_end)
+{
+
+  if ((size_t)(end - begin) <= degree_digits)
+    return NAN;
+
+  double angle = parseNumber(begin, begin + degree_digits) + parseNumber(begin + degree_digits, end) / 60.0;
+  if ((hemisphere != hemisphere_end) && ((*hemisphere == 'S') || (*hemisphere == 'W')))
+    angle = -angle;
+
+  return angle;
+
+}
+
+//parse NMEA time in hhmmss(.sss) format to seconds since midnight, returns false if field is empty or malformed
+static bool parseTime(const char *begin, const char *end, double& seconds)
+{
+
+  if (end - begin < 6)
+    return false;
+
+  int hours = parseInteger(begin, begin + 2);
+  int minutes = parseInteger(begin + 2, begin + 4);
+  double second = parseNumber(begin + 4, end);
+  if ((hours < 0) || (minutes < 0) || isnan(second))
+    return false;
+
+  seconds = hours * 3600 + minutes * 60 + second;
+  return true;
+
+}
+
+//comma separated field iterator over the data part of a sentence (after the address, before "*")
+struct FieldReader
+{
+
+  const char *position;
+  const char *end;
+
+  FieldReader(const char *sentence, size_t length)
+  {
+    //sentence has been checksum verified, so it ends with "*hh"
+    this->position = sentence;
+    this->end = sentence + length - 3;
+  }
+
+  //get next field, returns false once all fields have been read
+  bool next(const char*& field, const char*& field_end)
+  {
+
+    if (this->position == NULL)
+      return false;
+
+    field = this->position;
+    const char *comma = (const char*)memchr(this->position, ',', this->end - this->position);
+    if (comma == NULL)
+    {
+      field_end = this->end;
+      this->position = NULL;
+    }
+    else
+    {
+      field_end = comma;
+      this->position = comma + 1;
+    }
+
+    return true;
+
+  }
+
+};
+
+
+//default constructor
+NmeaFramer::NmeaFramer()
+{
+  this->_checksum_errors = 0;
+  this->_overflows = 0;
+  this->reset();
+}
+
+//default destructor
+NmeaFramer::~NmeaFramer() {}
+
+//get functions
+
+unsigned int NmeaFramer::getChecksumErrors() const
+{
+  return this->_checksum_errors;
+}
+
+unsigned int NmeaFramer::getOverflows() const
+{
+  return this->_overflows;
+}
+
+//get free space at end of buffer to read new bytes into
+//unfinished sentence at end of buffer is first moved to the front, so sentences are always contiguous
+char* NmeaFramer::getWriteBuffer(size_t& size)
+{
+
+  if (this->_start > 0)
+  {
+    size_t remaining = this->_end - this->_start;
+    memmove(this->_buffer, this->_buffer + this->_start, remaining);
+    this->_scan -= this->_start;
+    this->_end = remaining;
+    this->_start = 0;
+  }
+
+  size = BUFFER_SIZE - this->_end;
+  return this->_buffer + this->_end;
+
+}
+
+//other functions
+
+//mark bytes read into write buffer as received
+void NmeaFramer::commit(size_t count)
+{
+  this->_end += count;
+}
+
+//find next complete sentence with valid checksum in received bytes
+//returns false once no complete sentence is left
+bool NmeaFramer::next(const char*& sentence, size_t& length)
+{
+
+  while (true)
+  {
+
+    //skip to start of sentence
+    if ((this->_start == this->_scan) || (this->_buffer[this->_start] != '$'))
+    {
+      const char *dollar = (const char*)memchr(this->_buffer + this->_start, '$', this->_end - this->_start);
+      if (dollar == NULL)
+      {
+        this->_start = this->_end;
+        this->_scan = this->_end;
+        return false;
+      }
+      this->_start = dollar - this->_buffer;
+      this->_scan = this->_start + 1;
+    }
+
+    //find end of sentence, only searching bytes not searched before
+    const char *newline = (const char*)memchr(this->_buffer + this->_scan, '\n', this->_end - this->_scan);
+    if (newline == NULL)
+    {
+
+      //drop sentences that can't be valid so buffer never fills up
+      if (this->_end - this->_start > NMEA_MAX_SENTENCE_LENGTH)
+      {
+        this->_overflows++;
+        this->_start++;
+        this->_scan = this->_start;
+        continue;
+      }
+
+      this->_scan = this->_end;
+      return false;
+
+    }
+
+    //sentence runs from "$" up to line ending, without "\r"
+    sentence = this->_buffer + this->_start;
+    length = newline - sentence;
+    if ((length > 0) && (sentence[length - 1] == '\r'))
+      length--;
+
+    //continue after line ending on next call
+    this->_start = newline - this->_buffer + 1;
+    this->_scan = this->_start;
+
+    //a second "$" inside the line means the previous sentence was cut off, restart from there
+    const char *dollar = (const char*)memchr(sentence + 1, '$', length - 1);
+    if (dollar != NULL)
+    {
+      this->_checksum_errors++;
+      this->_start = dollar - this->_buffer;
+      this->_scan = this->_start + 1;
+      continue;
+    }
+
+    if (length > NMEA_MAX_SENTENCE_LENGTH)
+    {
+      this->_overflows++;
+      continue;
+    }
+
+    if (verifyChecksum(sentence, length))
+      return true;
+
+    this->_checksum_errors++;
+
+  }
+
+}
+
+//discard all buffered bytes
+void NmeaFramer::reset()
+{
+  this->_start = 0;
+  this->_scan = 0;
+  this->_end = 0;
+}
+
+//get type of sentence from address field ("$ttsss", talker ID is ignored)
+NmeaSentenceType getNmeaSentenceType(const char *sentence, size_t length)
+{
+
+  if ((length < 7) || (sentence[6] != ','))
+    return NMEA_UNKNOWN;
+
+  if ((sentence[3] == 'G') && (sentence[4] == 'G') && (sentence[5] == 'A'))
+    return NMEA_GGA;
+  if ((sentence[3] == 'R') && (sentence[4] == 'M') && (sentence[5] == 'C'))
+    return NMEA_RMC;
+
+  return NMEA_UNKNOWN;
+
+}
+
+//parse GGA sentence
+//$--GGA,time,lat,N/S,lon,E/W,quality,satellites,hdop,altitude,M,geoid separation,M,dgps age,dgps station*hh
+bool parseGGA(const char *sentence, size_t length, NmeaGGA& gga)
+{
+
+  if (getNmeaSentenceType(sentence, length) != NMEA_GGA)
+    return false;
+
+  //collect field boundaries first, since angles need the hemisphere field that follows them
+  const char *field[12];
+  const char *field_end[12];
+  FieldReader reader(sentence, length);
+  int count = 0;
+  while ((count < 12) && reader.next(field[count], field_end[count]))
+    count++;
+  if (count < 12)
+    return false;
+
+  gga.has_time = parseTime(field[1], field_end[1], gga.utc_time);
+  gga.latitude = parseAngle(field[2], field_end[2], 2, field[3], field_end[3]);
+  gga.longitude = parseAngle(field[4], field_end[4], 3, field[5], field_end[5]);
+  gga.fix_type = parseInteger(field[6], field_end[6]);
+  if (gga.fix_type < 0)
+    gga.fix_type = 0;
+  gga.satellites = parseInteger(field[7], field_end[7]);
+  if (gga.satellites < 0)
+    gga.satellites = 0;
+  gga.hdop = parseNumber(field[8], field_end[8]);
+  gga.altitude = parseNumber(field[9], field_end[9]);
+  gga.geoid_separation = parseNumber(field[11], field_end[11]);
+
+  return true;
+
+}
+
+//parse RMC sentence
+//$--RMC,time,status,lat,N/S,lon,E/W,speed,course,date,magnetic variation,E/W(,mode)*hh
+bool parseRMC(const char *sentence, size_t length, NmeaRMC& rmc)
+{
+
+  if (getNmeaSentenceType(sentence, length) != NMEA_RMC)
+    return false;
+
+  const char *field[10];
+  const char *field_end[10];
+  FieldReader reader(sentence, length);
+  int count = 0;
+  while ((count < 10) && reader.next(field[count], field_end[count]))
+    count++;
+  if (count < 10)
+    return false;
+
+  rmc.has_time = parseTime(field[1], field_end[1], rmc.utc_time);
+  rmc.fix_valid = (field_end[2] - field[2] == 1) && (*field[2] == 'A');
+  rmc.latitude = parseAngle(field[3], field_end[3], 2, field[4], field_end[4]);
+  rmc.longitude = parseAngle(field[5], field_end[5], 3, field[6], field_end[6]);
+  rmc.speed = parseNumber(field[7], field_end[7]) * KNOTS_TO_MPS;
+  rmc.course = parseNumber(field[8], field_end[8]) * PI / 180;
+
+  //date is given as ddmmyy
+  rmc.has_date = false;
+  if (field_end[9] - field[9] == 6)
+  {
+    rmc.day = parseInteger(field[9], field[9] + 2);
+    rmc.month = parseInteger(field[9] + 2, field[9] + 4);
+    rmc.year = parseInteger(field[9] + 4, field[9] + 6);
+    rmc.has_date = (rmc.day > 0) && (rmc.month > 0) && (rmc.year >= 0);
+    rmc.year += 2000;
+  }
+
+  return true;
+
+}
+
+//format sentence with checksum and line ending
+size_t formatNmeaSentence(const char *body, char *buffer, size_t size)
+{
+
+  unsigned char checksum = 0;
+  for (const char *c = body; *c != '\0'; c++)
+    checksum ^= *c;
+
+  int length = snprintf(buffer, size, "$%s*%02X\r\n", body, checksum);
+  if ((length < 0) || ((size_t)length >= size))
+    return 0;
+
+  return length;
+
+}
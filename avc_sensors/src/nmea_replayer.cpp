@@ -0,0 +1,125 @@
+//NMEA replayer
+//replays a GPS log recorded by gps_node (record_file parameter) into a pseudo terminal, chunk by chunk at the recorded arrival times
+//divided by replay rate, so gps_node, the Python nmea_serial_driver, or any other reader sees the same bytes with the same timing as on the car
+//usage: rosrun avc_sensors nmea_replayer log_file [link_path] [replay_rate] [loop]
+#include <chrono>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+#include <nmea_log.hpp>
+#include <pseudo_terminal.hpp>
+
+//global variables
+volatile sig_atomic_t running = 1;
+
+
+//signal handler called to stop replay
+void signalHandler(int sig)
+{
+  running = 0;
+}
+
+int main(int argc, char **argv)
+{
+
+  if ((argc < 2) || (argc > 5))
+  {
+    fprintf(stderr, "usage: nmea_replayer log_file [link_path] [replay_rate] [loop]\n");
+    return 1;
+  }
+
+  //get log file, symbolic link to create for pseudo terminal (point serial_port at it), replay speed, and whether to replay log endlessly
+  const char *log_file = argv[1];
+  const char *link_path = (argc >= 3) ? argv[2] : "/tmp/gps";
+  double replay_rate = (argc >= 4) ? atof(argv[3]) : 1;
+  bool loop = (argc >= 5) && (atoi(argv[4]) != 0);
+  if (replay_rate <= 0)
+  {
+    fprintf(stderr, "replay rate must be greater than zero\n");
+    return 1;
+  }
+
+  NmeaLog log;
+  if (!log.openRead(log_file))
+  {
+    fprintf(stderr, "failed to open NMEA log: %s\n", log_file);
+    return 1;
+  }
+
+  PseudoTerminal terminal;
+  if (!terminal.open(link_path))
+  {
+    fprintf(stderr, "failed to create pseudo terminal linked to %s\n", link_path);
+    return 1;
+  }
+  int master = terminal.getFileDescriptor();
+
+  signal(SIGINT, signalHandler);
+  signal(SIGTERM, signalHandler);
+
+  printf("replaying %s on %s (%s) at %.2fx real time\n", log_file, link_path, terminal.getSlaveName().c_str(), replay_rate);
+
+  char chunk[4096];
+  char discard[256];
+  size_t length;
+  uint64_t timestamp;
+  uint64_t first_timestamp = 0;
+  bool first = true;
+  unsigned long long replayed_bytes = 0;
+  unsigned long long dropped_bytes = 0;
+  std::chrono::steady_clock::time_point replay_start = std::chrono::steady_clock::now();
+
+  while (running)
+  {
+
+    if (!log.read(chunk, sizeof(chunk), length, timestamp))
+    {
+
+      if (!loop)
+        break;
+
+      //start over from beginning of log
+      if (!log.openRead(log_file) || !log.read(chunk, sizeof(chunk), length, timestamp))
+        break;
+      first = true;
+      replay_start = std::chrono::steady_clock::now();
+
+    }
+
+    if (first)
+    {
+      first_timestamp = timestamp;
+      first = false;
+    }
+
+    //release chunk at its recorded arrival time, scaled by replay rate
+    std::chrono::steady_clock::time_point release = replay_start + std::chrono::microseconds((long long)((timestamp - first_timestamp) / replay_rate));
+    std::this_thread::sleep_until(release);
+
+    //discard commands written by the program under test, the replayed receiver doesn't answer them
+    while (read(master, discard, sizeof(discard)) > 0) {}
+
+    //bytes nobody reads are lost like on a real serial port once the terminal buffer is full
+    ssize_t count = write(master, chunk, length);
+    if (count < 0)
+    {
+      if (errno != EAGAIN)
+        break;
+      count = 0;
+    }
+    replayed_bytes += count;
+    dropped_bytes += length - count;
+
+  }
+
+  printf("replayed %llu bytes (%llu dropped because nobody was reading)\n", replayed_bytes, dropped_bytes);
+
+  log.close();
+  terminal.close();
+
+  return 0;
+}
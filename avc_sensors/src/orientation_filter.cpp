@@ -0,0 +1,513 @@
+//include header
+#include <orientation_filter.hpp>
+
+#include <math.h>
+#include <stddef.h>
+
+
+//orientation filter base class
+
+//default constructor
+template <typename T>
+OrientationFilter<T>::OrientationFilter()
+{
+  this->reset();
+}
+
+//default destructor
+template <typename T>
+OrientationFilter<T>::~OrientationFilter() {}
+
+//get functions
+
+//get orientation quaternion
+template <typename T>
+void OrientationFilter<T>::getQuaternion(T& w, T& x, T& y, T& z) const
+{
+  w = this->_q0;
+  x = this->_q1;
+  y = this->_q2;
+  z = this->_q3;
+}
+
+//get roll angle (rotation about x axis) [rad]
+template <typename T>
+T OrientationFilter<T>::getRoll() const
+{
+  return atan2(2 * (this->_q0 * this->_q1 + this->_q2 * this->_q3), 1 - 2 * (this->_q1 * this->_q1 + this->_q2 * this->_q2));
+}
+
+//get pitch angle (rotation about y axis) [rad]
+template <typename T>
+T OrientationFilter<T>::getPitch() const
+{
+
+  T sin_pitch = 2 * (this->_q0 * this->_q2 - this->_q3 * this->_q1);
+
+  //clamp to avoid NaN from rounding at +/-90 degrees
+  if (sin_pitch > 1)
+    sin_pitch = 1;
+  else if (sin_pitch < -1)
+    sin_pitch = -1;
+
+  return asin(sin_pitch);
+
+}
+
+//get yaw angle (rotation about z axis) [rad]
+template <typename T>
+T OrientationFilter<T>::getYaw() const
+{
+  return atan2(2 * (this->_q0 * this->_q3 + this->_q1 * this->_q2), 1 - 2 * (this->_q2 * this->_q2 + this->_q3 * this->_q3));
+}
+
+//returns true once orientation has been set from a valid sample
+template <typename T>
+bool OrientationFilter<T>::isInitialized() const
+{
+  return this->_initialized;
+}
+
+//other functions
+
+//update orientation with new sample
+template <typename T>
+void OrientationFilter<T>::update(T gx, T gy, T gz, T ax, T ay, T az, T mx, T my, T mz, T dt)
+{
+
+  //first valid sample sets orientation directly so the filter doesn't have to converge from identity
+  if (!this->_initialized)
+  {
+    this->_initialized = this->initialize(ax, ay, az, mx, my, mz);
+    return;
+  }
+
+  //ignore samples without a valid time step
+  if (dt <= 0)
+    return;
+
+  //without accelerometer data orientation can only be propagated with gyro data
+  if ((ax == 0) && (ay == 0) && (az == 0))
+  {
+    this->integrateGyro(gx, gy, gz, dt);
+    this->normalizeQuaternion();
+    return;
+  }
+
+  this->step(gx, gy, gz, ax, ay, az, mx, my, mz, dt);
+
+}
+
+//reset orientation to identity, next sample reinitializes filter
+template <typename T>
+void OrientationFilter<T>::reset()
+{
+  this->_q0 = 1;
+  this->_q1 = 0;
+  this->_q2 = 0;
+  this->_q3 = 0;
+  this->_initialized = false;
+}
+
+//integrate quaternion rate of change from gyro over dt (quaternion is not normalized)
+template <typename T>
+void OrientationFilter<T>::integrateGyro(T gx, T gy, T gz, T dt)
+{
+
+  T half_dt = T(0.5) * dt;
+  T q0 = this->_q0;
+  T q1 = this->_q1;
+  T q2 = this->_q2;
+  T q3 = this->_q3;
+
+  this->_q0 += (-q1 * gx - q2 * gy - q3 * gz) * half_dt;
+  this->_q1 += (q0 * gx + q2 * gz - q3 * gy) * half_dt;
+  this->_q2 += (q0 * gy - q1 * gz + q3 * gx) * half_dt;
+  this->_q3 += (q0 * gz + q1 * gy - q2 * gx) * half_dt;
+
+}
+
+//normalize quaternion to unit length
+template <typename T>
+void OrientationFilter<T>::normalizeQuaternion()
+{
+
+  T norm = sqrt(this->_q0 * this->_q0 + this->_q1 * this->_q1 + this->_q2 * this->_q2 + this->_q3 * this->_q3);
+  if (norm == 0)
+  {
+    this->_q0 = 1;
+    return;
+  }
+
+  this->_q0 /= norm;
+  this->_q1 /= norm;
+  this->_q2 /= norm;
+  this->_q3 /= norm;
+
+}
+
+//set orientation from accelerometer (up) and compass (north) directions
+//returns false if sample can't define an orientation
+template <typename T>
+bool OrientationFilter<T>::initialize(T ax, T ay, T az, T mx, T my, T mz)
+{
+
+  //up direction in sensor frame (accelerometer measures reaction to gravity)
+  T norm = sqrt(ax * ax + ay * ay + az * az);
+  if (norm == 0)
+    return false;
+  T ux = ax / norm;
+  T uy = ay / norm;
+  T uz = az / norm;
+
+  //west direction = up x magnetic field, falls back to current heading if no compass data is available
+  T wx = uy * mz - uz * my;
+  T wy = uz * mx - ux * mz;
+  T wz = ux * my - uy * mx;
+  norm = sqrt(wx * wx + wy * wy + wz * wz);
+  if (norm == 0)
+  {
+    //use sensor y axis projected onto horizontal plane as west
+    wx = -uy * ux;
+    wy = 1 - uy * uy;
+    wz = -uy * uz;
+    norm = sqrt(wx * wx + wy * wy + wz * wz);
+    if (norm == 0)
+      return false;
+  }
+  wx /= norm;
+  wy /= norm;
+  wz /= norm;
+
+  //north direction = west x up
+  T nx = wy * uz - wz * uy;
+  T ny = wz * ux - wx * uz;
+  T nz = wx * uy - wy * ux;
+
+  //rotation matrix from sensor to earth frame has north, west, and up as rows, convert to quaternion
+  T trace = nx + wy + uz;
+  if (trace > 0)
+  {
+    T s = T(0.5) / sqrt(trace + 1);
+    this->_q0 = T(0.25) / s;
+    this->_q1 = (uy - wz) * s;
+    this->_q2 = (nz - ux) * s;
+    this->_q3 = (wx - ny) * s;
+  }
+  else if ((nx > wy) && (nx > uz))
+  {
+    T s = 2 * sqrt(1 + nx - wy - uz);
+    this->_q0 = (uy - wz) / s;
+    this->_q1 = T(0.25) * s;
+    this->_q2 = (ny + wx) / s;
+    this->_q3 = (nz + ux) / s;
+  }
+  else if (wy > uz)
+  {
+    T s = 2 * sqrt(1 + wy - nx - uz);
+    this->_q0 = (nz - ux) / s;
+    this->_q1 = (ny + wx) / s;
+    this->_q2 = T(0.25) * s;
+    this->_q3 = (wz + uy) / s;
+  }
+  else
+  {
+    T s = 2 * sqrt(1 + uz - nx - wy);
+    this->_q0 = (wx - ny) / s;
+    this->_q1 = (nz + ux) / s;
+    this->_q2 = (wz + uy) / s;
+    this->_q3 = T(0.25) * s;
+  }
+  this->normalizeQuaternion();
+
+  return true;
+
+}
+
+
+//Madgwick filter
+
+//default constructor
+template <typename T>
+MadgwickFilter<T>::MadgwickFilter(T beta)
+{
+  this->_beta = beta;
+}
+
+//default destructor
+template <typename T>
+MadgwickFilter<T>::~MadgwickFilter() {}
+
+//set functions
+
+//set gyro measurement error gain [rad/s]
+template <typename T>
+void MadgwickFilter<T>::setBeta(T beta)
+{
+  this->_beta = beta;
+}
+
+//other functions
+
+//one gradient descent correction step followed by gyro integration
+template <typename T>
+void MadgwickFilter<T>::step(T gx, T gy, T gz, T ax, T ay, T az, T mx, T my, T mz, T dt)
+{
+
+  T q0 = this->_q0;
+  T q1 = this->_q1;
+  T q2 = this->_q2;
+  T q3 = this->_q3;
+
+  //normalize accelerometer measurement
+  T norm = sqrt(ax * ax + ay * ay + az * az);
+  ax /= norm;
+  ay /= norm;
+  az /= norm;
+
+  //auxiliary variables to avoid repeated arithmetic
+  T _2q0 = 2 * q0;
+  T _2q1 = 2 * q1;
+  T _2q2 = 2 * q2;
+  T _2q3 = 2 * q3;
+  T q0q0 = q0 * q0;
+  T q1q1 = q1 * q1;
+  T q2q2 = q2 * q2;
+  T q3q3 = q3 * q3;
+
+  //objective function gradient
+  T s0;
+  T s1;
+  T s2;
+  T s3;
+
+  norm = sqrt(mx * mx + my * my + mz * mz);
+  if (norm == 0)
+  {
+
+    //gravity only
+    T _4q0 = 4 * q0;
+    T _4q1 = 4 * q1;
+    T _4q2 = 4 * q2;
+    T _8q1 = 8 * q1;
+    T _8q2 = 8 * q2;
+
+    s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+    s1 = _4q1 * q3q3 - _2q3 * ax + 4 * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+    s2 = 4 * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+    s3 = 4 * q1q1 * q3 - _2q1 * ax + 4 * q2q2 * q3 - _2q2 * ay;
+
+  }
+  else
+  {
+
+    //normalize compass measurement
+    mx /= norm;
+    my /= norm;
+    mz /= norm;
+
+    T _2q0mx = 2 * q0 * mx;
+    T _2q0my = 2 * q0 * my;
+    T _2q0mz = 2 * q0 * mz;
+    T _2q1mx = 2 * q1 * mx;
+    T _2q0q2 = 2 * q0 * q2;
+    T _2q2q3 = 2 * q2 * q3;
+    T q0q1 = q0 * q1;
+    T q0q2 = q0 * q2;
+    T q0q3 = q0 * q3;
+    T q1q2 = q1 * q2;
+    T q1q3 = q1 * q3;
+    T q2q3 = q2 * q3;
+
+    //reference direction of earth's magnetic field (horizontal north and vertical components)
+    T hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+    T hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+    T _2bx = sqrt(hx * hx + hy * hy);
+    T _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+    T _4bx = 2 * _2bx;
+    T _4bz = 2 * _2bz;
+
+    //errors between measured and estimated gravity and magnetic field directions
+    T fax = 2 * q1q3 - _2q0q2 - ax;
+    T fay = 2 * q0q1 + _2q2q3 - ay;
+    T faz = 1 - 2 * q1q1 - 2 * q2q2 - az;
+    T fmx = _2bx * (T(0.5) - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+    T fmy = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+    T fmz = _2bx * (q0q2 + q1q3) + _2bz * (T(0.5) - q1q1 - q2q2) - mz;
+
+    s0 = -_2q2 * fax + _2q1 * fay - _2bz * q2 * fmx + (-_2bx * q3 + _2bz * q1) * fmy + _2bx * q2 * fmz;
+    s1 = _2q3 * fax + _2q0 * fay - 4 * q1 * faz + _2bz * q3 * fmx + (_2bx * q2 + _2bz * q0) * fmy + (_2bx * q3 - _4bz * q1) * fmz;
+    s2 = -_2q0 * fax + _2q3 * fay - 4 * q2 * faz + (-_4bx * q2 - _2bz * q0) * fmx + (_2bx * q1 + _2bz * q3) * fmy + (_2bx * q0 - _4bz * q2) * fmz;
+    s3 = _2q1 * fax + _2q2 * fay + (-_4bx * q3 + _2bz * q1) * fmx + (-_2bx * q0 + _2bz * q2) * fmy + _2bx * q1 * fmz;
+
+  }
+
+  //integrate gyro rate of change
+  this->integrateGyro(gx, gy, gz, dt);
+
+  //apply normalized gradient step scaled by beta
+  norm = sqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+  if (norm > 0)
+  {
+    T step = this->_beta * dt / norm;
+    this->_q0 -= step * s0;
+    this->_q1 -= step * s1;
+    this->_q2 -= step * s2;
+    this->_q3 -= step * s3;
+  }
+
+  this->normalizeQuaternion();
+
+}
+
+
+//Mahony filter
+
+//default constructor
+template <typename T>
+MahonyFilter<T>::MahonyFilter(T kp, T ki)
+{
+  this->_kp = kp;
+  this->_ki = ki;
+  this->_integral_x = 0;
+  this->_integral_y = 0;
+  this->_integral_z = 0;
+}
+
+//default destructor
+template <typename T>
+MahonyFilter<T>::~MahonyFilter() {}
+
+//set functions
+
+//set proportional and integral gains
+template <typename T>
+void MahonyFilter<T>::setGains(T kp, T ki)
+{
+  this->_kp = kp;
+  this->_ki = ki;
+}
+
+//other functions
+
+//reset orientation and gyro bias estimate
+template <typename T>
+void MahonyFilter<T>::reset()
+{
+  OrientationFilter<T>::reset();
+  this->_integral_x = 0;
+  this->_integral_y = 0;
+  this->_integral_z = 0;
+}
+
+//correct gyro rates with feedback of accelerometer/compass error, then integrate
+template <typename T>
+void MahonyFilter<T>::step(T gx, T gy, T gz, T ax, T ay, T az, T mx, T my, T mz, T dt)
+{
+
+  T q0 = this->_q0;
+  T q1 = this->_q1;
+  T q2 = this->_q2;
+  T q3 = this->_q3;
+
+  //normalize accelerometer measurement
+  T norm = sqrt(ax * ax + ay * ay + az * az);
+  ax /= norm;
+  ay /= norm;
+  az /= norm;
+
+  T q0q0 = q0 * q0;
+  T q0q1 = q0 * q1;
+  T q0q2 = q0 * q2;
+  T q0q3 = q0 * q3;
+  T q1q1 = q1 * q1;
+  T q1q2 = q1 * q2;
+  T q1q3 = q1 * q3;
+  T q2q2 = q2 * q2;
+  T q2q3 = q2 * q3;
+  T q3q3 = q3 * q3;
+
+  //estimated direction of gravity
+  T vx = 2 * (q1q3 - q0q2);
+  T vy = 2 * (q0q1 + q2q3);
+  T vz = q0q0 - q1q1 - q2q2 + q3q3;
+
+  //error is cross product between measured and estimated gravity directions
+  T ex = ay * vz - az * vy;
+  T ey = az * vx - ax * vz;
+  T ez = ax * vy - ay * vx;
+
+  norm = sqrt(mx * mx + my * my + mz * mz);
+  if (norm > 0)
+  {
+
+    //normalize compass measurement
+    mx /= norm;
+    my /= norm;
+    mz /= norm;
+
+    //reference direction of earth's magnetic field (horizontal north and vertical components)
+    T hx = 2 * (mx * (T(0.5) - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+    T hy = 2 * (mx * (q1q2 + q0q3) + my * (T(0.5) - q1q1 - q3q3) + mz * (q2q3 - q0q1));
+    T bx = sqrt(hx * hx + hy * hy);
+    T bz = 2 * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (T(0.5) - q1q1 - q2q2));
+
+    //estimated direction of magnetic field
+    T wx = 2 * (bx * (T(0.5) - q2q2 - q3q3) + bz * (q1q3 - q0q2));
+    T wy = 2 * (bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3));
+    T wz = 2 * (bx * (q0q2 + q1q3) + bz * (T(0.5) - q1q1 - q2q2));
+
+    //add cross product between measured and estimated magnetic field directions
+    ex += my * wz - mz * wy;
+    ey += mz * wx - mx * wz;
+    ez += mx * wy - my * wx;
+
+  }
+
+  //integral feedback (gyro bias estimate)
+  if (this->_ki > 0)
+  {
+    this->_integral_x += this->_ki * ex * dt;
+    this->_integral_y += this->_ki * ey * dt;
+    this->_integral_z += this->_ki * ez * dt;
+    gx += this->_integral_x;
+    gy += this->_integral_y;
+    gz += this->_integral_z;
+  }
+
+  //proportional feedback
+  gx += this->_kp * ex;
+  gy += this->_kp * ey;
+  gz += this->_kp * ez;
+
+  //integrate corrected gyro rate of change
+  this->integrateGyro(gx, gy, gz, dt);
+  this->normalizeQuaternion();
+
+}
+
+
+//create orientation filter of named type
+template <typename T>
+OrientationFilter<T>* createOrientationFilter(const std::string& type, T gain_1, T gain_2)
+{
+
+  if (type == "madgwick")
+    return new MadgwickFilter<T>(gain_1);
+  else if (type == "mahony")
+    return new MahonyFilter<T>(gain_1, gain_2);
+
+  return NULL;
+
+}
+
+
+//explicit instantiations for single and double precision
+template class OrientationFilter<float>;
+template class OrientationFilter<double>;
+template class MadgwickFilter<float>;
+template class MadgwickFilter<double>;
+template class MahonyFilter<float>;
+template class MahonyFilter<double>;
+template OrientationFilter<float>* createOrientationFilter<float>(const std::string& type, float gain_1, float gain_2);
+template OrientationFilter<double>* createOrientationFilter<double>(const std::string& type, double gain_1, double gain_2);
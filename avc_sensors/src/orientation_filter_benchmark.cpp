@@ -0,0 +1,283 @@
+//orientation filter benchmark
+//measures per-update cost and heading error of the in-house orientation filters against RTIMULib's Kalman fusion
+//usage: rosrun avc_sensors orientation_filter_benchmark [log_file [settings_directory]]
+//log_file is a binary IMU log recorded by imu_node (record_file parameter)
+//without a log file a simulated drive with known heading and gyro bias is used, and errors are measured against the true heading
+//with a log file errors are measured against RTIMULib's heading
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <imu_source.hpp>
+#include <orientation_filter.hpp>
+
+//external library includes
+#include <RTFusionKalman4.h>
+#include <RTIMULib.h>
+
+//time at start of log ignored in error statistics while filters converge [s]
+const double SETTLE_TIME = 5.0;
+
+//filter gains, matching avc_sensors/config/sensors.yaml
+const double MADGWICK_BETA = 0.04;
+const double MAHONY_KP = 1.0;
+const double MAHONY_KI = 0.0;
+
+//math constants
+const double PI = 3.1415926535897;
+
+//one raw IMU sample
+struct ImuRecord
+{
+  uint64_t timestamp; //[us]
+  double gyro[3]; //[rad/s]
+  double accel[3]; //[g]
+  double compass[3]; //[uT]
+  double heading; //true yaw if known [rad]
+};
+
+//heading results of one filter
+struct FilterResult
+{
+  std::string name;
+  double ns_per_update;
+  std::vector<double> yaw; //[rad]
+};
+
+
+//wrap angle to -pi to pi [rad]
+double wrapAngle(double angle)
+{
+  return atan2(sin(angle), cos(angle));
+}
+
+//read binary IMU log, returns false if file can't be opened or isn't an IMU log
+bool readLog(const char *file_name, std::vector<ImuRecord>& records)
+{
+
+  ImuLog log;
+  if (!log.openRead(file_name))
+    return false;
+
+  RTIMU_DATA data;
+  while (log.read(data))
+  {
+
+    ImuRecord record;
+    record.timestamp = data.timestamp;
+    for (int i = 0; i < 3; i++)
+    {
+      record.gyro[i] = data.gyro.data(i);
+      record.accel[i] = data.accel.data(i);
+      record.compass[i] = data.compassValid ? data.compass.data(i) : 0;
+    }
+    record.heading = NAN;
+    records.push_back(record);
+
+  }
+
+  return true;
+
+}
+
+//simulate level drive at 400 Hz with weaving turns, noisy sensors, and a constant yaw gyro bias
+void simulateLog(std::vector<ImuRecord>& records)
+{
+
+  const int SAMPLE_RATE = 400; //[Hz]
+  const int DURATION = 120; //[s]
+  const double GYRO_BIAS = 0.01; //[rad/s]
+
+  std::mt19937 generator(1);
+  std::normal_distribution<double> gyro_noise(0, 0.005);
+  std::normal_distribution<double> accel_noise(0, 0.01);
+  std::normal_distribution<double> compass_noise(0, 0.5);
+
+  double heading = 0;
+  for (int i = 0; i < SAMPLE_RATE * DURATION; i++)
+  {
+
+    double t = double(i) / SAMPLE_RATE;
+    double yaw_rate = 0.6 * sin(0.4 * t) + 0.2 * sin(1.3 * t);
+    heading = wrapAngle(heading + yaw_rate / SAMPLE_RATE);
+
+    ImuRecord record;
+    record.timestamp = uint64_t(i) * 1000000 / SAMPLE_RATE;
+    record.gyro[0] = gyro_noise(generator);
+    record.gyro[1] = gyro_noise(generator);
+    record.gyro[2] = yaw_rate + GYRO_BIAS + gyro_noise(generator);
+    record.accel[0] = accel_noise(generator);
+    record.accel[1] = accel_noise(generator);
+    record.accel[2] = 1 + accel_noise(generator);
+
+    //earth field of 20 uT north and 40 uT down rotated into sensor frame
+    record.compass[0] = 20 * cos(heading) + compass_noise(generator);
+    record.compass[1] = -20 * sin(heading) + compass_noise(generator);
+    record.compass[2] = -40 + compass_noise(generator);
+    record.heading = heading;
+
+    records.push_back(record);
+
+  }
+
+}
+
+//run in-house filter over all samples
+FilterResult runFilter(const std::string& name, OrientationFilter<double> *filter, const std::vector<ImuRecord>& records)
+{
+
+  FilterResult result;
+  result.name = name;
+  result.yaw.resize(records.size());
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); i++)
+  {
+    const ImuRecord& r = records[i];
+    double dt = (i > 0) ? (r.timestamp - records[i - 1].timestamp) / 1000000.0 : 0;
+    filter->update(r.gyro[0], r.gyro[1], r.gyro[2], r.accel[0], r.accel[1], r.accel[2], r.compass[0], r.compass[1], r.compass[2], dt);
+    result.yaw[i] = filter->getYaw();
+  }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  result.ns_per_update = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / records.size();
+
+  return result;
+
+}
+
+//run RTIMULib Kalman fusion over all samples
+FilterResult runRTIMULib(RTIMUSettings *settings, const std::vector<ImuRecord>& records)
+{
+
+  FilterResult result;
+  result.name = "RTIMULib RTFusionKalman4";
+  result.yaw.resize(records.size());
+
+  RTFusionKalman4 fusion;
+  fusion.setGyroEnable(true);
+  fusion.setAccelEnable(true);
+  fusion.setCompassEnable(true);
+
+  RTIMU_DATA data;
+  data.fusionPoseValid = false;
+  data.fusionQPoseValid = false;
+  data.gyroValid = true;
+  data.accelValid = true;
+  data.compassValid = true;
+  data.pressureValid = false;
+  data.temperatureValid = false;
+  data.humidityValid = false;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); i++)
+  {
+    const ImuRecord& r = records[i];
+    data.timestamp = r.timestamp;
+    data.gyro = RTVector3(r.gyro[0], r.gyro[1], r.gyro[2]);
+    data.accel = RTVector3(r.accel[0], r.accel[1], r.accel[2]);
+    data.compass = RTVector3(r.compass[0], r.compass[1], r.compass[2]);
+    fusion.newIMUData(data, settings);
+    result.yaw[i] = data.fusionPose.z();
+  }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  result.ns_per_update = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / records.size();
+
+  return result;
+
+}
+
+//print cost and heading error of filter against reference heading after settle time
+void printResult(const FilterResult& result, const std::vector<double>& reference, const std::vector<ImuRecord>& records)
+{
+
+  double sum_squared_error = 0;
+  double max_error = 0;
+  double final_error = 0;
+  int count = 0;
+
+  for (size_t i = 0; i < records.size(); i++)
+  {
+
+    if ((records[i].timestamp - records[0].timestamp) / 1000000.0 < SETTLE_TIME)
+      continue;
+
+    double error = wrapAngle(result.yaw[i] - reference[i]);
+    sum_squared_error += error * error;
+    if (fabs(error) > max_error)
+      max_error = fabs(error);
+    final_error = error;
+    count++;
+
+  }
+
+  double rms_error = (count > 0) ? sqrt(sum_squared_error / count) : 0;
+  printf("%-28s %9.1f ns/update   rms %7.3f deg   max %7.3f deg   final %8.3f deg\n", result.name.c_str(), result.ns_per_update, rms_error * 180 / PI, max_error * 180 / PI, final_error * 180 / PI);
+
+}
+
+int main(int argc, char **argv)
+{
+
+  if (argc > 3)
+  {
+    fprintf(stderr, "usage: orientation_filter_benchmark [log_file [settings_directory]]\n");
+    return 1;
+  }
+
+  //load recorded log or simulate one
+  std::vector<ImuRecord> records;
+  if (argc >= 2)
+  {
+    if (!readLog(argv[1], records))
+    {
+      fprintf(stderr, "failed to open IMU log: %s\n", argv[1]);
+      return 1;
+    }
+  }
+  else
+    simulateLog(records);
+
+  if (records.size() < 2)
+  {
+    fprintf(stderr, "IMU log contains too few samples\n");
+    return 1;
+  }
+
+  //RTIMULib settings (RTIMULib.ini is created in settings directory if it doesn't exist)
+  const char *settings_directory = (argc == 3) ? argv[2] : ".";
+  RTIMUSettings *settings = new RTIMUSettings(settings_directory, "RTIMULib");
+
+  //run filters over log
+  MadgwickFilter<double> madgwick(MADGWICK_BETA);
+  MahonyFilter<double> mahony(MAHONY_KP, MAHONY_KI);
+  std::vector<FilterResult> results;
+  results.push_back(runRTIMULib(settings, records));
+  results.push_back(runFilter("MadgwickFilter<double>", &madgwick, records));
+  results.push_back(runFilter("MahonyFilter<double>", &mahony, records));
+
+  //compare against true heading if simulated, otherwise against RTIMULib
+  std::vector<double> reference;
+  if (argc >= 2)
+  {
+    reference = results[0].yaw;
+    printf("%zu recorded samples, errors relative to RTIMULib heading\n", records.size());
+  }
+  else
+  {
+    for (size_t i = 0; i < records.size(); i++)
+      reference.push_back(records[i].heading);
+    printf("%zu simulated samples, errors relative to true heading\n", records.size());
+  }
+
+  for (size_t i = 0; i < results.size(); i++)
+    printResult(results[i], reference, records);
+
+  delete settings;
+
+  return 0;
+}
@@ -0,0 +1,298 @@
+//include header
+#include <pmtk_sequencer.hpp>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+//time given to chip to switch baud rate after receiving command [ms]
+static const int BAUD_SWITCH_DELAY = 100;
+
+
+//get milliseconds left until deadline (zero once it has passed)
+static int remainingTime(const std::chrono::steady_clock::time_point& deadline)
+{
+
+  std::chrono::steady_clock::duration remaining = deadline - std::chrono::steady_clock::now();
+  if (remaining <= std::chrono::steady_clock::duration::zero())
+    return 0;
+
+  return std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count() + 1;
+
+}
+
+//get command number of PMTK command body ("PMTK220,100" -> 220), returns -1 if body isn't a PMTK command
+static int commandNumber(const char *command)
+{
+
+  if (strncmp(command, "PMTK", 4) != 0)
+    return -1;
+
+  char *end;
+  long number = strtol(command + 4, &end, 10);
+  if ((end == command + 4) || ((*end != ',') && (*end != '\0')))
+    return -1;
+
+  return number;
+
+}
+
+
+//default constructor
+PmtkSequencer::PmtkSequencer(SerialPort *port, int ack_timeout, int attempts)
+{
+
+  //set class variable values to passed values
+  this->_port = port;
+  this->_ack_timeout = ack_timeout;
+  this->_attempts = attempts;
+
+}
+
+//default destructor
+PmtkSequencer::~PmtkSequencer() {}
+
+//get functions
+
+//get readable name of command result
+const char* PmtkSequencer::getResultName(Result result)
+{
+
+  switch (result)
+  {
+    case WRITE_FAILED: return "write to serial device failed";
+    case NO_REPLY: return "no reply received";
+    case INVALID_COMMAND: return "invalid command / packet";
+    case UNSUPPORTED_COMMAND: return "unsupported command / packet type";
+    case ACTION_FAILED: return "valid command / packet, but action failed";
+    case ACTION_SUCCEEDED: return "valid command / packet, action succeeded";
+  }
+
+  return "unknown result";
+
+}
+
+//other functions
+
+//send command and wait for its acknowledgement, resending it until the chip reports success or attempts run out
+//unsupported commands are not resent, since the chip won't accept them on later attempts either
+PmtkSequencer::Result PmtkSequencer::sendCommand(const char *command)
+{
+
+  char sentence[NMEA_MAX_SENTENCE_LENGTH + 1];
+  size_t length = formatNmeaSentence(command, sentence, sizeof(sentence));
+  int number = commandNumber(command);
+  if ((length == 0) || (number < 0))
+    return INVALID_COMMAND;
+
+  Result result = NO_REPLY;
+  for (int attempt = 0; attempt < this->_attempts; attempt++)
+  {
+
+    //discard replies to earlier commands before sending
+    this->_port->flush();
+    this->_framer.reset();
+
+    if (!this->_port->write(sentence, length))
+      return WRITE_FAILED;
+
+    result = this->waitForAck(number, this->_ack_timeout);
+    if ((result == ACTION_SUCCEEDED) || (result == UNSUPPORTED_COMMAND))
+      break;
+
+  }
+
+  return result;
+
+}
+
+//open port at each candidate baud rate in turn until sentences with valid checksums are received
+//at a wrong baud rate the chip's output arrives as garbage that never passes the checksum test
+int PmtkSequencer::detectBaudRate(const std::string& device, const std::vector<int>& baud_rates, int timeout)
+{
+
+  for (size_t i = 0; i < baud_rates.size(); i++)
+  {
+
+    if (!this->_port->open(device, baud_rates[i]))
+      continue;
+
+    if (this->waitForSentence(timeout))
+      return baud_rates[i];
+
+  }
+
+  this->_port->close();
+  return 0;
+
+}
+
+//collect types of received sentences and measure their update interval from RMC arrival times
+bool PmtkSequencer::observeOutput(int timeout, Output& output)
+{
+
+  output.rmc = false;
+  output.gga = false;
+  output.other = false;
+  output.update_interval = 0;
+
+  this->_framer.reset();
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+  std::chrono::steady_clock::time_point first_rmc;
+  int rmc_count = 0;
+  bool received = false;
+
+  int remaining;
+  while (((remaining = remainingTime(deadline)) > 0) && (rmc_count < 3))
+  {
+
+    size_t size;
+    char *buffer = this->_framer.getWriteBuffer(size);
+    ssize_t count = this->_port->read(buffer, size, remaining);
+    if (count < 0)
+      return false;
+    this->_framer.commit(count);
+
+    const char *sentence;
+    size_t length;
+    while (this->_framer.next(sentence, length))
+    {
+
+      received = true;
+      switch (getNmeaSentenceType(sentence, length))
+      {
+        case NMEA_GGA:
+          output.gga = true;
+          break;
+        case NMEA_RMC:
+          output.rmc = true;
+          if (rmc_count == 0)
+            first_rmc = std::chrono::steady_clock::now();
+          else
+            output.update_interval = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - first_rmc).count() / rmc_count;
+          rmc_count++;
+          break;
+        default:
+          //replies to commands aren't part of the NMEA output
+          if (strncmp(sentence, "$PMTK", 5) != 0)
+            output.other = true;
+          break;
+      }
+
+    }
+
+  }
+
+  return received;
+
+}
+
+//send baud rate command, then reopen port at new baud rate and wait for a valid sentence to confirm chip switched
+//chip doesn't acknowledge baud rate changes, so a missed command is only noticed by the missing sentences and the command is resent at the previous rate
+bool PmtkSequencer::setBaudRate(const std::string& device, int baud_rate, int timeout)
+{
+
+  char command[32];
+  snprintf(command, sizeof(command), "PMTK251,%d", baud_rate);
+  char sentence[NMEA_MAX_SENTENCE_LENGTH + 1];
+  size_t length = formatNmeaSentence(command, sentence, sizeof(sentence));
+
+  int previous_baud_rate = this->_port->getBaudRate();
+  for (int attempt = 0; attempt < this->_attempts; attempt++)
+  {
+
+    this->_port->flush();
+    if (!this->_port->write(sentence, length))
+      return false;
+
+    //wait until command has left the port and chip has switched
+    this->_port->drain();
+    std::this_thread::sleep_for(std::chrono::milliseconds(BAUD_SWITCH_DELAY));
+
+    //reopen port at new baud rate and listen for sentences
+    if (!this->_port->open(device, baud_rate))
+      return false;
+    if (this->waitForSentence(timeout))
+      return true;
+
+    //go back to previous baud rate to resend command
+    if (!this->_port->open(device, previous_baud_rate))
+      return false;
+
+  }
+
+  return false;
+
+}
+
+//wait for any sentence with valid checksum
+bool PmtkSequencer::waitForSentence(int timeout)
+{
+
+  this->_framer.reset();
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+  int remaining;
+  while ((remaining = remainingTime(deadline)) > 0)
+  {
+
+    size_t size;
+    char *buffer = this->_framer.getWriteBuffer(size);
+    ssize_t count = this->_port->read(buffer, size, remaining);
+    if (count < 0)
+      return false;
+    this->_framer.commit(count);
+
+    const char *sentence;
+    size_t length;
+    if (this->_framer.next(sentence, length))
+      return true;
+
+  }
+
+  return false;
+
+}
+
+//wait for $PMTK001,command,flag reply to given command
+PmtkSequencer::Result PmtkSequencer::waitForAck(int command, int timeout)
+{
+
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+  int remaining;
+  while ((remaining = remainingTime(deadline)) > 0)
+  {
+
+    size_t size;
+    char *buffer = this->_framer.getWriteBuffer(size);
+    ssize_t count = this->_port->read(buffer, size, remaining);
+    if (count < 0)
+      return NO_REPLY;
+    this->_framer.commit(count);
+
+    //skip NMEA output and acknowledgements of other commands
+    const char *sentence;
+    size_t length;
+    while (this->_framer.next(sentence, length))
+    {
+
+      if ((length < 14) || (strncmp(sentence, "$PMTK001,", 9) != 0))
+        continue;
+
+      char *end;
+      long acked_command = strtol(sentence + 9, &end, 10);
+      if ((acked_command != command) || (*end != ',') || (end[1] < '0') || (end[1] > '3'))
+        continue;
+
+      return (Result)(end[1] - '0');
+
+    }
+
+  }
+
+  return NO_REPLY;
+
+}
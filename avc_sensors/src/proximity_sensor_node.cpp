@@ -1,13 +1,36 @@
 //ROS includes
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <filters.hpp>
 #include <proximity_sensor.hpp>
+#include <ranging_scheduler.hpp>
 #include <ros/ros.h>
+#include <avc_msgs/ESC.h>
+#include <avc_msgs/SteeringServo.h>
+#include <avc_msgs/TimeToCollision.h>
+#include <avc_msgs/WheelEncoders.h>
 #include <sensor_msgs/Range.h>
 #include <signal.h>
 #include <string.h>
 
-//macro definitions for median filter (algorithm method)
-#define STOPPER 0 // smaller than any datum
-#define MEDIAN_FILTER_SIZE 7
+//median filter window size [samples]
+const size_t MEDIAN_FILTER_SIZE = 7;
+
+//time after which a wheel speed reading is considered stale [s]
+const double SPEED_TIMEOUT = 0.5;
+
+//minimum closing speed for which a finite time to collision is reported [m/s]
+const float MIN_CLOSING_SPEED = 0.05;
+
+//global variables
+float commanded_steering_angle = 0; //steering angle sent to hardware [deg]
+float commanded_throttle_percent = 0; //throttle sent to hardware [%]
+bool commanded_velocity_mode = false; //ESC commands give target speed, their throttle is only a limit
+float commanded_target_speed = 0; //[m/s]
+float wheel_radius = 0; //[m]
+float wheel_speed = 0; //front (undriven) wheel ground speed [m/s]
+ros::Time wheel_speed_time;
 
 
 //callback function called to process SIGINT command
@@ -19,86 +42,47 @@ void sigintHandler(int sig)
 
 }
 
-//median filter using fancy algorithm (more efficient for filter sizes > 3)
-int medianFilter(int datum)
+//callback function called to process messages on hardware ESC topic
+void escCallback(const avc_msgs::ESC::ConstPtr& msg)
 {
 
-  struct pair
-  {
-    struct pair *point;                                //Pointers forming list linked in sorted order
-    int value;                                         //Values to sort
-  };
-
-  static struct pair buffer[MEDIAN_FILTER_SIZE] = {0}; //Buffer of nwidth pairs
-  static struct pair *datpoint = buffer;               //Pointer into circular buffer of data
-  static struct pair small = {NULL, STOPPER};          //Chain stopper
-  static struct pair big = {&small, 0};                //Pointer to head (largest) of linked list
-
-  struct pair *successor;                              //Pointer to successor of replaced data item
-  struct pair *scan;                                   //Pointer used to scan down the sorted list
-  struct pair *scanold;                                //Previous value of scan
-  struct pair *median;                                 //Pointer to median
+  //set local value to received value
+  commanded_throttle_percent = msg->throttle_percent;
+  commanded_velocity_mode = msg->velocity_mode;
+  commanded_target_speed = msg->target_speed;
 
-  if (datum == STOPPER)
-    datum = STOPPER + 1;                               //No stoppers allowed
-
-  if ((++datpoint - buffer) >= MEDIAN_FILTER_SIZE)
-    datpoint = buffer;                                 //Increment and wrap data in pointer
-
-  datpoint->value = datum;                             //Copy in new datum
-  successor = datpoint->point;                         //Save pointer to old value's successor
-  median = &big;                                       //Median initially to first in chain
-  scanold = NULL;                                      //Scanold initially null
-  scan = &big;                                         //Points to pointer to first (largest) datum in chain
-
-  //Handle chain-out of first item in chain as special case
-  if (scan->point == datpoint)
-    scan->point = successor;
-
-  scanold = scan;                                      //Save this pointer and
-  scan = scan->point ;                                 //step down chain
+}
 
-  //Loop through the chain, normal loop exit via break
-  for (int i = 0 ; i < MEDIAN_FILTER_SIZE; ++i)
-  {
+//callback function called to process messages on hardware steering servo topic
+void steeringServoCallback(const avc_msgs::SteeringServo::ConstPtr& msg)
+{
 
-    //Handle odd-numbered item in chain
-    if (scan->point == datpoint)
-      scan->point = successor;                         //Chain out the old datum
+  //set local value to received value
+  commanded_steering_angle = msg->steering_angle;
 
-    if (scan->value < datum)                           //If datum is larger than scanned value,
-    {
-      datpoint->point = scanold->point;                //Chain it in here
-      scanold->point = datpoint;                       //Mark it chained in
-      datum = STOPPER;
-    }
+}
 
-    //Step median pointer down chain after doing odd-numbered element
-    median = median->point;                            //Step median pointer
-    if (scan == &small)
-      break;                                           //Break at end of chain
-    scanold = scan;                                    //Save this pointer and
-    scan = scan->point;                                //step down chain
+//callback function called to process messages on wheel encoders topic
+void wheelEncodersCallback(const avc_msgs::WheelEncoders::ConstPtr& msg)
+{
 
-    //Handle even-numbered item in chain.
-    if (scan->point == datpoint)
-      scan->point = successor;
+  //average front (undriven) wheels and convert angular velocity to ground speed [m/s]
+  wheel_speed = (msg->front_left + msg->front_right) / 2 * wheel_radius;
+  wheel_speed_time = ros::Time::now();
 
-    if (scan->value < datum)
-    {
-      datpoint->point = scanold->point;
-      scanold->point = datpoint;
-      datum = STOPPER;
-    }
+}
 
-    if (scan == &small)
-      break;
+//get own ground speed from front wheels
+//returns false if no recent wheel speed is available
+bool getOwnSpeed(float& speed)
+{
 
-    scanold = scan;
-    scan = scan->point;
-  }
+  //ignore wheel speed if it hasn't been updated recently
+  if (wheel_speed_time.isZero() || ((ros::Time::now() - wheel_speed_time).toSec() >= SPEED_TIMEOUT))
+    return false;
 
- return median->value;
+  speed = wheel_speed;
+  return true;
 
 }
 
@@ -137,11 +121,66 @@ int main(int argc, char **argv)
     ROS_BREAK();
   }
 
-  //get refresh rate of sensor in hertz
-  float refresh_rate;
-  if (!node_private.getParam("/sensor/proximity_sensor/refresh_rate", refresh_rate))
+  //get sensor position used to decide when this sensor matters
+  RangingScheduler::Position position;
+  if (!RangingScheduler::parsePosition(sensor_position, position))
   {
-    ROS_ERROR("[proximity_sensor_node] sensor refresh rate not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_ERROR("[proximity_sensor_node] unknown sensor position: %s (expected front, left or right)", sensor_position);
+    ROS_BREAK();
+  }
+
+  //get refresh rate of sensor in hertz when parked or not relevant to current motion
+  float idle_refresh_rate;
+  if (!node_private.getParam("/sensor/proximity_sensor/idle_refresh_rate", idle_refresh_rate) || (idle_refresh_rate <= 0))
+  {
+    ROS_ERROR("[proximity_sensor_node] sensor idle refresh rate not defined or not positive in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //get refresh rate of sensor in hertz when most relevant to current motion
+  float max_refresh_rate;
+  if (!node_private.getParam("/sensor/proximity_sensor/max_refresh_rate", max_refresh_rate))
+  {
+    ROS_ERROR("[proximity_sensor_node] sensor maximum refresh rate not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //get minimum time between readings required by the sensor [ms]
+  float min_cycle_time;
+  if (!node_private.getParam("/sensor/proximity_sensor/min_cycle_time", min_cycle_time))
+  {
+    ROS_ERROR("[proximity_sensor_node] sensor minimum cycle time not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //get throttle at which sensors reach their maximum refresh rate [%]
+  float full_rate_throttle;
+  if (!node_private.getParam("/sensor/proximity_sensor/full_rate_throttle", full_rate_throttle))
+  {
+    ROS_ERROR("[proximity_sensor_node] sensor full rate throttle not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //get target speed at which sensors reach their maximum refresh rate in velocity mode [m/s]
+  float full_rate_speed = 4.0;
+  if (!node_private.getParam("/sensor/proximity_sensor/full_rate_speed", full_rate_speed))
+  {
+    ROS_WARN_STREAM("[proximity_sensor_node] no full rate speed provided, using default: " << full_rate_speed);
+  }
+
+  //get minimum relevance of side sensors while moving [0 to 1]
+  float side_rate_floor;
+  if (!node_private.getParam("/sensor/proximity_sensor/side_rate_floor", side_rate_floor))
+  {
+    ROS_ERROR("[proximity_sensor_node] side sensor rate floor not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //get maximum steering angle used to scale side sensor relevance [deg]
+  float max_steering_angle;
+  if (!node_private.getParam("/steering_servo/max_rotation_angle", max_steering_angle))
+  {
+    ROS_ERROR("[proximity_sensor_node] maximum steering angle not defined in config file: avc_bringup/config/global.yaml");
     ROS_BREAK();
   }
 
@@ -212,15 +251,106 @@ int main(int argc, char **argv)
 
   //----------------------------------------------------------
 
+  //get alpha-beta filter range correction gain used for range rate estimation
+  float ttc_alpha;
+  if (!node_private.getParam("/sensor/proximity_sensor/ttc_alpha", ttc_alpha))
+  {
+    ROS_ERROR("[proximity_sensor_node] time to collision alpha gain not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //get alpha-beta filter range rate correction gain used for range rate estimation
+  float ttc_beta;
+  if (!node_private.getParam("/sensor/proximity_sensor/ttc_beta", ttc_beta))
+  {
+    ROS_ERROR("[proximity_sensor_node] time to collision beta gain not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //get range residual at which time to collision confidence falls to 1/e [m]
+  float ttc_residual_scale;
+  if (!node_private.getParam("/sensor/proximity_sensor/ttc_residual_scale", ttc_residual_scale))
+  {
+    ROS_ERROR("[proximity_sensor_node] time to collision residual scale not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //get closing speed disagreement with own speed at which time to collision confidence falls to 1/e [m/s]
+  float ttc_speed_scale;
+  if (!node_private.getParam("/sensor/proximity_sensor/ttc_speed_scale", ttc_speed_scale))
+  {
+    ROS_ERROR("[proximity_sensor_node] time to collision speed scale not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //get wheel radius used to convert encoder angular velocity to ground speed [m]
+  if (!node_private.getParam("/sensor/encoder/wheel_radius", wheel_radius))
+  {
+    ROS_ERROR("[proximity_sensor_node] wheel radius not defined in config file: avc_sensors/config/sensors.yaml");
+    ROS_BREAK();
+  }
+
+  //own speed only predicts closing speed of static obstacles directly ahead
+  bool forward_facing = (strcmp(sensor_position, "front") == 0);
+
+  //create time to collision message
+  avc_msgs::TimeToCollision ttc_msg;
+  ttc_msg.header.frame_id = "proximity_sensor_link";
+
+  //create median filter for smoothing range readings
+  MedianFilter<float, MEDIAN_FILTER_SIZE> range_filter;
+
+  //create alpha-beta filter for estimating range rate from filtered range
+  AlphaBetaFilter<float> range_rate_filter(ttc_alpha, ttc_beta);
+  ros::Time last_range_time;
+
   //create publisher to publish proximity sensor message with buffer size 1, and latch set to false
   ros::Publisher proximity_pub = node_public.advertise<sensor_msgs::Range>("proximity", 1, false);
 
-  //set refresh rate of ROS loop to defined refresh rate of sensor parameter
-  ros::Rate loop_rate(refresh_rate);
+  //create publisher to publish time to collision message with buffer size 1, and latch set to false
+  ros::Publisher ttc_pub = node_public.advertise<avc_msgs::TimeToCollision>("ttc", 1, false);
+
+  //create subscriber to subscribe to wheel encoders topic with queue size set to 1
+  ros::Subscriber wheel_encoders_sub = node_public.subscribe("/sensor/wheel_encoders", 1, wheelEncodersCallback);
+
+  //create subscribers to subscribe to hardware command topics with queue size set to 1
+  ros::Subscriber esc_sub = node_public.subscribe("/hardware/esc", 1, escCallback);
+  ros::Subscriber steering_servo_sub = node_public.subscribe("/hardware/steering_servo", 1, steeringServoCallback);
+
+  //create scheduler to set refresh rate of ROS loop from commanded motion
+  RangingScheduler scheduler(position, idle_refresh_rate, max_refresh_rate, min_cycle_time / 1000, full_rate_throttle, side_rate_floor, max_steering_angle);
+
+  //time of last sensor reading
+  ros::Time last_reading_time;
 
   while (ros::ok())
   {
 
+    //wait until next reading is due, re-evaluating the schedule in short steps so that a parked sensor
+    //speeds up as soon as the car starts moving instead of after its idle period
+    while (ros::ok())
+    {
+
+      //process callback functions and update scheduler with latest commanded motion
+      ros::spinOnce();
+      //in velocity mode commanded motion is the target speed, scaled to the throttle with the same firing rate
+      if (commanded_velocity_mode)
+        scheduler.setThrottlePercent((full_rate_speed > 0) ? commanded_target_speed / full_rate_speed * full_rate_throttle : 0);
+      else
+        scheduler.setThrottlePercent(commanded_throttle_percent);
+      scheduler.setSteeringAngle(commanded_steering_angle);
+
+      //stop waiting once the current period has elapsed since the last reading
+      double remaining = scheduler.getPeriod() - (ros::Time::now() - last_reading_time).toSec();
+      if (last_reading_time.isZero() || (remaining <= 0))
+        break;
+
+      //sleep for remaining time or one minimum cycle, whichever is shorter
+      ros::Duration(std::min(remaining, min_cycle_time / 1000.0)).sleep();
+
+    }
+    last_reading_time = ros::Time::now();
+
     //set time of current distance reading
     proximity_msg.header.stamp = ros::Time::now();
 
@@ -229,22 +359,53 @@ int main(int argc, char **argv)
 
     //verify distance from proximity sensor is valid
     //if distance check timed out then report max range
+    bool echo_received = (distance != -1) && (distance <= max_range);
     if ((distance == -1) || (distance > max_range))
       distance = max_range;
     else if (distance < min_range)
       distance = min_range;
 
     //set message range value to median filtered sensor reading [m]
-    proximity_msg.range = float(medianFilter(int(distance * 1000))) / 1000;
+    proximity_msg.range = range_filter.update(distance);
 
     //publish proximity sensor range message
     proximity_pub.publish(proximity_msg);
 
-    //process callback functions
-    ros::spinOnce();
+    //-------------------------TIME TO COLLISION--------------------------
+
+    //estimate range rate from filtered range using actual time between readings
+    if (echo_received)
+    {
+      range_rate_filter.update(proximity_msg.range, last_range_time.isZero() ? 0 : (proximity_msg.header.stamp - last_range_time).toSec());
+      last_range_time = proximity_msg.header.stamp;
+    }
+    //without an echo the object is out of range, so restart estimation when one reappears
+    else
+    {
+      range_rate_filter.reset();
+      last_range_time = ros::Time();
+    }
+
+    //closing speed is the rate at which range decreases [m/s]
+    ttc_msg.closing_speed = -range_rate_filter.rate();
+
+    //confidence falls as range measurements stop following the tracked range rate
+    ttc_msg.confidence = echo_received ? exp(-fabs(range_rate_filter.residual()) / ttc_residual_scale) : 0;
+
+    //for static obstacles ahead closing speed should match own speed, so scale confidence by their agreement
+    float own_speed;
+    if (forward_facing && getOwnSpeed(own_speed))
+      ttc_msg.confidence *= exp(-fabs(ttc_msg.closing_speed - own_speed) / ttc_speed_scale);
+
+    //calculate time to collision, reporting infinity if not closing on the object [s]
+    if (echo_received && (ttc_msg.closing_speed > MIN_CLOSING_SPEED))
+      ttc_msg.time_to_collision = proximity_msg.range / ttc_msg.closing_speed;
+    else
+      ttc_msg.time_to_collision = std::numeric_limits<float>::infinity();
 
-    //sleep until next sensor reading
-    loop_rate.sleep();
+    //set time to collision message time and publish
+    ttc_msg.header.stamp = proximity_msg.header.stamp;
+    ttc_pub.publish(ttc_msg);
 
   }
   return 0;
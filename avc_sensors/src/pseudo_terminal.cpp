@@ -0,0 +1,138 @@
+//include header
+#include <pseudo_terminal.hpp>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+
+//convert termios speed to baud rate, returns 0 if speed is not a standard serial baud rate
+static int toBaudRate(speed_t speed)
+{
+
+  switch (speed)
+  {
+    case B4800: return 4800;
+    case B9600: return 9600;
+    case B19200: return 19200;
+    case B38400: return 38400;
+    case B57600: return 57600;
+    case B115200: return 115200;
+    case B230400: return 230400;
+    default: return 0;
+  }
+
+}
+
+
+//default constructor
+PseudoTerminal::PseudoTerminal()
+{
+  this->_master = -1;
+  this->_slave = -1;
+}
+
+//default destructor
+PseudoTerminal::~PseudoTerminal()
+{
+  this->close();
+}
+
+//get functions
+
+//get baud rate of slave side (master and slave share terminal settings)
+int PseudoTerminal::getBaudRate() const
+{
+
+  struct termios options;
+  if ((this->_master == -1) || (tcgetattr(this->_master, &options) != 0))
+    return 0;
+
+  return toBaudRate(cfgetispeed(&options));
+
+}
+
+int PseudoTerminal::getFileDescriptor() const
+{
+  return this->_master;
+}
+
+std::string PseudoTerminal::getSlaveName() const
+{
+
+  if (this->_master == -1)
+    return "";
+
+  return ptsname(this->_master);
+
+}
+
+//other functions
+
+//create pseudo terminal in raw mode with non-blocking master side
+bool PseudoTerminal::open(const std::string& link_path)
+{
+
+  this->close();
+
+  this->_master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if ((this->_master == -1) || (grantpt(this->_master) != 0) || (unlockpt(this->_master) != 0))
+  {
+    this->close();
+    return false;
+  }
+
+  //hold slave side open, otherwise the master reports an error whenever no program has the device open
+  this->_slave = ::open(ptsname(this->_master), O_RDWR | O_NOCTTY);
+  if (this->_slave == -1)
+  {
+    this->close();
+    return false;
+  }
+
+  //no line editing or character translation, like a serial port in raw mode
+  struct termios options;
+  tcgetattr(this->_slave, &options);
+  cfmakeraw(&options);
+  tcsetattr(this->_slave, TCSANOW, &options);
+
+  //replace any existing link (e.g. left behind by an earlier run)
+  if (!link_path.empty())
+  {
+    unlink(link_path.c_str());
+    if (symlink(ptsname(this->_master), link_path.c_str()) != 0)
+    {
+      this->close();
+      return false;
+    }
+    this->_link_path = link_path;
+  }
+
+  return true;
+
+}
+
+//close pseudo terminal and remove symbolic link
+void PseudoTerminal::close()
+{
+
+  if (!this->_link_path.empty())
+  {
+    unlink(this->_link_path.c_str());
+    this->_link_path.clear();
+  }
+
+  if (this->_slave != -1)
+  {
+    ::close(this->_slave);
+    this->_slave = -1;
+  }
+
+  if (this->_master != -1)
+  {
+    ::close(this->_master);
+    this->_master = -1;
+  }
+
+}
@@ -0,0 +1,111 @@
+//include header
+#include <ranging_scheduler.hpp>
+
+
+//default constructor
+RangingScheduler::RangingScheduler(Position position, double idle_rate, double max_rate, double min_cycle_time, double full_rate_throttle, double side_rate_floor, double max_steering_angle)
+{
+
+  //set class variable values to passed values
+  this->_position = position;
+  this->_idle_rate = idle_rate;
+  this->_max_rate = max_rate;
+  this->_full_rate_throttle = full_rate_throttle;
+  this->_side_rate_floor = side_rate_floor;
+  this->_max_steering_angle = max_steering_angle;
+
+  //never fire faster than the sensor's minimum measurement cycle allows
+  if ((min_cycle_time > 0) && (this->_max_rate > 1 / min_cycle_time))
+    this->_max_rate = 1 / min_cycle_time;
+
+  //idle rate can't exceed maximum rate
+  if (this->_idle_rate > this->_max_rate)
+    this->_idle_rate = this->_max_rate;
+
+  //initialize other variables (parked)
+  this->_steering_angle = 0;
+  this->_throttle_percent = 0;
+
+}
+
+//default destructor
+RangingScheduler::~RangingScheduler() {}
+
+//set functions
+
+//set current commanded steering angle [deg]
+void RangingScheduler::setSteeringAngle(double steering_angle)
+{
+  this->_steering_angle = steering_angle;
+}
+
+//set current commanded throttle [%]
+void RangingScheduler::setThrottlePercent(double throttle_percent)
+{
+  this->_throttle_percent = throttle_percent;
+}
+
+//get functions
+
+//get relevance of sensor to current motion [0 to 1]
+double RangingScheduler::getImportance()
+{
+
+  //forward speed as a fraction of the throttle at which sensors reach full rate (reverse motion doesn't approach anything these sensors see)
+  double speed = (this->_full_rate_throttle > 0) ? (this->_throttle_percent / this->_full_rate_throttle) : 0;
+  if (speed < 0)
+    speed = 0;
+  else if (speed > 1)
+    speed = 1;
+
+  //front sensor matters in proportion to forward speed
+  if (this->_position == FRONT)
+    return speed;
+
+  //fraction of full steering lock toward this sensor's side
+  double turn = (this->_max_steering_angle > 0) ? (this->_steering_angle / this->_max_steering_angle) : 0;
+  if (this->_position == RIGHT)
+    turn = -turn;
+  if (turn < this->_side_rate_floor)
+    turn = this->_side_rate_floor;
+  else if (turn > 1)
+    turn = 1;
+
+  //side sensors matter when moving and turning toward their side, keeping a floor for obstacle avoidance decisions
+  return speed * turn;
+
+}
+
+//get time until next reading [s]
+double RangingScheduler::getPeriod()
+{
+  return 1 / this->getRate();
+}
+
+//get current firing rate [Hz]
+double RangingScheduler::getRate()
+{
+
+  //interpolate between idle and maximum rate by importance
+  return this->_idle_rate + (this->_max_rate - this->_idle_rate) * this->getImportance();
+
+}
+
+//other functions
+
+//convert position name to position, returns false if name isn't recognized
+bool RangingScheduler::parsePosition(const std::string& name, Position& position)
+{
+
+  if (name == "front")
+    position = FRONT;
+  else if (name == "left")
+    position = LEFT;
+  else if (name == "right")
+    position = RIGHT;
+  else
+    return false;
+
+  return true;
+
+}
@@ -0,0 +1,202 @@
+//include header
+#include <serial_port.hpp>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+
+//convert baud rate to termios speed, returns false if baud rate isn't supported
+static bool toSpeed(int baud_rate, speed_t& speed)
+{
+
+  switch (baud_rate)
+  {
+    case 4800: speed = B4800; break;
+    case 9600: speed = B9600; break;
+    case 19200: speed = B19200; break;
+    case 38400: speed = B38400; break;
+    case 57600: speed = B57600; break;
+    case 115200: speed = B115200; break;
+    case 230400: speed = B230400; break;
+    default: return false;
+  }
+
+  return true;
+
+}
+
+
+//default constructor
+SerialPort::SerialPort()
+{
+  this->_fd = -1;
+  this->_baud_rate = 0;
+}
+
+//default destructor
+SerialPort::~SerialPort()
+{
+  this->close();
+}
+
+//get functions
+
+int SerialPort::getBaudRate() const
+{
+  return this->_baud_rate;
+}
+
+int SerialPort::getFileDescriptor() const
+{
+  return this->_fd;
+}
+
+bool SerialPort::isOpen() const
+{
+  return this->_fd != -1;
+}
+
+//other functions
+
+//open serial device in raw 8N1 mode with given baud rate
+bool SerialPort::open(const std::string& device, int baud_rate)
+{
+
+  this->close();
+
+  speed_t speed;
+  if (!toSpeed(baud_rate, speed))
+    return false;
+
+  this->_fd = ::open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (this->_fd == -1)
+    return false;
+
+  //raw mode: no line editing, echo, signals, or character translation
+  struct termios options;
+  if (tcgetattr(this->_fd, &options) != 0)
+  {
+    this->close();
+    return false;
+  }
+  cfmakeraw(&options);
+  cfsetispeed(&options, speed);
+  cfsetospeed(&options, speed);
+
+  //8 data bits, no parity, 1 stop bit, no flow control, ignore modem lines
+  options.c_cflag &= ~(PARENB | CSTOPB | CSIZE | CRTSCTS);
+  options.c_cflag |= CS8 | CLOCAL | CREAD;
+
+  //reads return immediately with whatever is available (waiting is done with poll)
+  options.c_cc[VMIN] = 0;
+  options.c_cc[VTIME] = 0;
+
+  if (tcsetattr(this->_fd, TCSANOW, &options) != 0)
+  {
+    this->close();
+    return false;
+  }
+
+  this->_baud_rate = baud_rate;
+  this->flush();
+
+  return true;
+
+}
+
+//close serial device
+void SerialPort::close()
+{
+
+  if (this->_fd != -1)
+  {
+    ::close(this->_fd);
+    this->_fd = -1;
+  }
+
+}
+
+//wait until all output has been transmitted
+void SerialPort::drain()
+{
+
+  if (this->_fd != -1)
+    tcdrain(this->_fd);
+
+}
+
+//discard unread input and unsent output
+void SerialPort::flush()
+{
+
+  if (this->_fd != -1)
+    tcflush(this->_fd, TCIOFLUSH);
+
+}
+
+//read available bytes into buffer, waiting up to timeout [ms] for data to arrive
+//returns number of bytes read (0 on timeout) or -1 on error
+ssize_t SerialPort::read(char *buffer, size_t size, int timeout)
+{
+
+  if (this->_fd == -1)
+    return -1;
+
+  struct pollfd descriptor;
+  descriptor.fd = this->_fd;
+  descriptor.events = POLLIN;
+  descriptor.revents = 0;
+
+  int result = poll(&descriptor, 1, timeout);
+  if (result < 0)
+    return (errno == EINTR) ? 0 : -1;
+  if (result == 0)
+    return 0;
+  if (descriptor.revents & (POLLERR | POLLNVAL))
+    return -1;
+
+  ssize_t count = ::read(this->_fd, buffer, size);
+  if (count < 0)
+    return ((errno == EAGAIN) || (errno == EINTR)) ? 0 : -1;
+
+  return count;
+
+}
+
+//write all bytes to serial device
+bool SerialPort::write(const char *data, size_t length)
+{
+
+  if (this->_fd == -1)
+    return false;
+
+  while (length > 0)
+  {
+
+    ssize_t count = ::write(this->_fd, data, length);
+    if (count < 0)
+    {
+      if ((errno == EAGAIN) || (errno == EINTR))
+      {
+        //wait until device accepts more output
+        struct pollfd descriptor;
+        descriptor.fd = this->_fd;
+        descriptor.events = POLLOUT;
+        descriptor.revents = 0;
+        poll(&descriptor, 1, 100);
+        continue;
+      }
+      return false;
+    }
+
+    data += count;
+    length -= count;
+
+  }
+
+  return true;
+
+}